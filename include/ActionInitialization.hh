@@ -0,0 +1,17 @@
+#ifndef ActionInitialization_h
+#define ActionInitialization_h 1
+
+#include "G4VUserActionInitialization.hh"
+
+class ActionInitialization : public G4VUserActionInitialization
+{
+
+public:
+	ActionInitialization();
+	~ActionInitialization();
+
+	void BuildForMaster() const;
+	void Build() const;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef AliasTable_h
+#define AliasTable_h 1
+
+#include "globals.hh"
+#include <vector>
+
+/**
+ * Walker/Vose alias table for sampling a discrete distribution in O(1).
+ *
+ * Build() is O(n) and meant to run once at initialization; Sample() costs
+ * one uniform random number and a single table lookup.
+ */
+class AliasTable
+{
+
+public:
+	AliasTable();
+	~AliasTable();
+
+	void	Build(const std::vector<G4double>& weights);
+	void	Clear();
+
+	//u uniform in [0,1)
+	inline G4int Sample(G4double u) const;
+
+	G4bool	IsEmpty() const		{return probability.empty();};
+	G4int	GetSize() const		{return probability.size();};
+
+private:
+	std::vector<G4double> probability;
+	std::vector<G4int> alias;
+};
+
+inline G4int AliasTable::Sample(G4double u) const
+{
+
+	G4double scaled = u*probability.size();
+	G4int bin = (G4int)scaled;
+	if(bin >= (G4int)probability.size()) bin = probability.size() - 1;
+
+	//The fractional part is the second, independent uniform
+	return (scaled - bin < probability[bin]) ? bin : alias[bin];
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef BiasingMonitor_h
+#define BiasingMonitor_h 1
+
+#include "globals.hh"
+#include "Hits.hh"
+
+#include <chrono>
+
+class G4Run;
+class Run;
+
+/**
+ * Efficiency of the forced interaction (matrix --force-interaction)
+ * against analog simulation, estimated from the biased run itself.
+ *
+ * Per event it records the wall time, whether any photon was detected
+ * (a useful event), the weighted photon count S and the photon count n.
+ * With the mean photon weight w = S/n of an event, the analog useful
+ * fraction is the mean of w over useful events and the analog second
+ * moment of the light yield the mean of w n^2. The analog time per event
+ * is modelled from the biased times of useful and empty events. The
+ * speedup is the ratio of the figures of merit 1/(variance x time) of the
+ * light yield. Active whenever a biasing operator exists.
+ *
+ * The per-event sums go to the Run, which merges them over the threads.
+ */
+class BiasingMonitor
+{
+
+public:
+	BiasingMonitor();
+	~BiasingMonitor();
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	BeginOfEvent();
+	void	EndOfEvent(HitsCollection*, Run*);
+
+	G4bool	IsActive() const	{return active;};
+
+	struct Sums
+	{
+		G4double events;
+		G4double useful;
+		G4double analogUseful;
+		G4double score;
+		G4double score2;
+		G4double analogScore2;
+		G4double time;
+		G4double usefulTime;
+		G4double emptyTime;
+		G4double minTime;
+
+		void	Clear();
+		void	Merge(const Sums&);
+	};
+
+private:
+	G4bool active;
+	std::chrono::steady_clock::time_point eventStart;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef ConvergenceMonitor_h
+#define ConvergenceMonitor_h 1
+
+#include "globals.hh"
+#include "Hits.hh"
+#include "DetectorParameters.hh"
+
+#include <vector>
+#include <chrono>
+
+class G4Run;
+class G4Event;
+class ConvergenceMonitorMessenger;
+
+/**
+ * Stops a run once the chosen observables reach a target precision, or
+ * when its time budget is spent.
+ *
+ * Observables, estimated per event:
+ *   channels     mean photon count of every X and Y readout channel
+ *                holding at least a fraction of the largest one
+ *   lightYield   detected photons per event
+ *   efficiency   fraction of events whose brightest X and Y channels
+ *                match the crystal below the primary vertex
+ *
+ * Each thread accumulates running moments (Welford) on its own and folds
+ * them into the shared totals every checkEvery events, the only time a
+ * lock is taken. The decision is published through an atomic flag that
+ * every thread polls after its events.
+ */
+class ConvergenceMonitor : private DetectorParameters
+{
+
+public:
+	ConvergenceMonitor();
+	~ConvergenceMonitor();
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(const G4Event*, HitsCollection*);
+
+	void	SetTarget(G4double value)		{target = value;};
+	void	SetTimeBudget(G4double minutes)		{timeBudget = minutes;};
+	void	SetCheckEvery(G4int n)			{checkEvery = n > 0 ? n : 1;};
+	void	SetMinEvents(G4int n)			{minEvents = n;};
+	void	SetChannelFraction(G4double value)	{channelFraction = value;};
+	void	SetObservable(const G4String& name, G4bool enable);
+
+	G4bool	IsActive() const			{return target > 0 || timeBudget > 0;};
+
+	struct Moments
+	{
+		G4double n;
+		G4double mean;
+		G4double m2;
+
+		void	Clear()				{n = 0; mean = 0; m2 = 0;};
+		void	Add(G4double x);
+		void	Merge(const Moments&);
+		G4double RelativeError() const;
+	};
+
+private:
+	void	Publish();
+	G4bool	Converged(G4double& worst) const;
+
+	ConvergenceMonitorMessenger* messenger;
+
+	G4double target;
+	G4double timeBudget;
+	G4int checkEvery;
+	G4int minEvents;
+	G4double channelFraction;
+	G4bool useChannels;
+	G4bool useLightYield;
+	G4bool useEfficiency;
+
+	G4int nChannels;
+	std::vector<Moments> local;
+	//Weighted photons per global channel ID, sized at initialization
+	std::vector<G4double> counts;
+	G4int sinceCheck;
+	G4bool aborted;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef ConvergenceMonitorMessenger_h
+#define ConvergenceMonitorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ConvergenceMonitor;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+
+class ConvergenceMonitorMessenger : public G4UImessenger
+{
+
+public:
+	ConvergenceMonitorMessenger(ConvergenceMonitor*);
+	~ConvergenceMonitorMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	ConvergenceMonitor* monitor;
+
+	G4UIdirectory*		convergenceDir;
+	G4UIcmdWithADouble*	targetCmd;
+	G4UIcmdWithADouble*	budgetCmd;
+	G4UIcmdWithAnInteger*	checkEveryCmd;
+	G4UIcmdWithAnInteger*	minEventsCmd;
+	G4UIcmdWithADouble*	fractionCmd;
+	G4UIcommand*		observableCmd;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef CrystalPhotonModel_h
+#define CrystalPhotonModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Material;
+class G4MaterialPropertyVector;
+class CrystalPhotonModelMessenger;
+
+/**
+ * Fast optical photon transport inside the LYSO crystals.
+ *
+ * A crystal is a box with painted faces (specular reflection with the
+ * REFLECTIVITY of CrystalOpticalSurface, absorption otherwise) except the
+ * +z face, which touches the plate and is a plain dielectric interface.
+ * Photons starting in or entering a crystal are gathered and traced in
+ * batches, with structure-of-arrays ray/box stepping over all photons of
+ * a batch at once; the transmitted ones are emitted just beyond the +z
+ * face as ordinary tracks. Batches hold photons of a single primary, so
+ * the emitted tracks keep the right primary tag.
+ *
+ * A batch is traced when full (its survivors are secondaries of the photon
+ * that completed it) and at the end of the event, where the survivors are
+ * tracked on the spot under their own track and parent IDs. One instance
+ * per thread, built with the sensitive detectors at initialization.
+ */
+class CrystalPhotonModel : public G4VFastSimulationModel
+{
+
+public:
+	CrystalPhotonModel(const G4String& name, G4Region*, const G4Material* exitMaterial);
+	~CrystalPhotonModel();
+
+	G4bool	IsApplicable(const G4ParticleDefinition&);
+	G4bool	ModelTrigger(const G4FastTrack&);
+	void	DoIt(const G4FastTrack&, G4FastStep&);
+
+	//Traces what is left of the event and tracks the survivors
+	void	FlushEvent();
+	void	BeginOfRun();
+	void	EndOfRun();
+
+	void	SetEnabled(G4bool value)		{enabled = value;};
+	void	SetBatchSize(G4int n)			{batchSize = n > 0 ? n : 1;};
+	void	SetMaxBounces(G4int n)			{maxBounces = n;};
+
+	static CrystalPhotonModel* GetInstance();
+
+private:
+	struct Survivor
+	{
+		G4ThreeVector position;
+		G4ThreeVector direction;
+		G4double energy;
+		G4double time;
+		G4double weight;
+		G4int trackID;
+		G4int parentID;
+	};
+
+	void	Trace(std::vector<Survivor>&);
+	void	Clear();
+	G4bool	ReadSurface();
+	G4bool	ReadMaterial(const G4Material*);
+	G4ThreeVector Polarization(const G4ThreeVector& direction) const;
+
+	CrystalPhotonModelMessenger* messenger;
+	G4bool enabled;
+	G4int batchSize;
+	G4int maxBounces;
+
+	const G4Material* exitMaterial;
+	const G4Material* crystalMaterial;
+	G4MaterialPropertyVector* reflectivity;
+	G4MaterialPropertyVector* crystalIndex;
+	G4MaterialPropertyVector* crystalAbsorption;
+	G4MaterialPropertyVector* exitIndex;
+	G4bool surfaceRead;
+
+	//Batch, structure of arrays in the crystal frame
+	G4ThreeVector halfSize;
+	G4int batchPrimary;
+	std::vector<G4double> x, y, z, dx, dy, dz;
+	std::vector<G4double> energy, time, weight, path, invSpeed, reflect, eta;
+	std::vector<G4double> offsetX, offsetY, offsetZ;
+	std::vector<G4int> trackIDs, parentIDs;
+	std::vector<G4double> uniform;
+	std::vector<G4int> face;
+	std::vector<char> status;
+
+	//Survivors of batches closed before the end of the event
+	std::vector<std::vector<Survivor> > pending;
+
+	//Statistics of the run
+	G4double traced;
+	G4double transmitted;
+	G4double absorbedBulk;
+	G4double absorbedPaint;
+	G4double capped;
+	G4double bounces;
+	G4double seconds;
+};
+
+#endif
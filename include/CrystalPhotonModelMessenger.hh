@@ -0,0 +1,31 @@
+#ifndef CrystalPhotonModelMessenger_h
+#define CrystalPhotonModelMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class CrystalPhotonModel;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+
+class CrystalPhotonModelMessenger : public G4UImessenger
+{
+
+public:
+	CrystalPhotonModelMessenger(CrystalPhotonModel*);
+	~CrystalPhotonModelMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	CrystalPhotonModel* model;
+
+	G4UIdirectory*		tracerDir;
+	G4UIcmdWithABool*	enableCmd;
+	G4UIcmdWithAnInteger*	batchSizeCmd;
+	G4UIcmdWithAnInteger*	maxBouncesCmd;
+};
+
+#endif
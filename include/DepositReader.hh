@@ -0,0 +1,72 @@
+#ifndef DepositReader_h
+#define DepositReader_h 1
+
+#include "globals.hh"
+#include "MappedFile.hh"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Binary energy deposit file layout (little endian), written by
+ * DepositRecorder:
+ *
+ *   DepositHeader        magic "MTXDEP1", version, record size
+ *   for every event:
+ *     DepositEventHeader event ID, number of deposits (may be 0)
+ *     DepositRecord[]    one per charged step with energy in a crystal
+ *
+ * Positions are in mm (world frame), times in ns, energy in MeV; ix and iy
+ * are the crystal column and row, counted across the modules of the plane.
+ */
+struct DepositHeader
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	recordSize;
+};
+
+struct DepositEventHeader
+{
+	int32_t		event;
+	uint32_t	nDeposits;
+};
+
+struct DepositRecord
+{
+	int16_t	ix, iy;
+	int32_t	primary;
+	float	x0, y0, z0;
+	float	x1, y1, z1;
+	float	t0, t1;
+	float	edep;
+	float	weight;
+};
+
+/**
+ * Random access to the events of a memory mapped deposit file. Opening it
+ * walks the event headers once to index them.
+ */
+class DepositReader
+{
+
+public:
+	DepositReader();
+	~DepositReader();
+
+	G4bool	Open(const G4String& fileName);
+	void	Close();
+
+	//Deposits of the i-th event of the file
+	const DepositRecord* GetEvent(G4int i, G4int& eventID, G4int& nDeposits) const;
+
+	G4bool	IsOpen() const			{return file.IsOpen();};
+	G4int	GetNumberOfEvents() const	{return offsets.size();};
+	const G4String& GetFileName() const	{return file.GetFileName();};
+
+private:
+	MappedFile file;
+	std::vector<uint64_t> offsets;
+};
+
+#endif
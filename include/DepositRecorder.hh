@@ -0,0 +1,53 @@
+#ifndef DepositRecorder_h
+#define DepositRecorder_h 1
+
+#include "globals.hh"
+#include "DepositReader.hh"
+
+#include <vector>
+
+class G4Run;
+class Run;
+class G4Step;
+class G4LogicalVolume;
+class DepositRecorderMessenger;
+
+/**
+ * First stage of a two-stage simulation: records the energy deposits of
+ * charged steps in the crystals (see DepositReader.hh for the file).
+ *
+ * Deposits are buffered per event and appended to the file as one block
+ * at the end of the event, so the events of all threads stay contiguous
+ * in the single output. The file is (re)created when a run starts with a
+ * new name and is appended to by the following runs. The steps and events
+ * written are counted in the Run. The second stage replays it with
+ * /matrix/source/type deposits (DepositReplay).
+ */
+class DepositRecorder
+{
+
+public:
+	DepositRecorder();
+	~DepositRecorder();
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(G4int eventID, Run*);
+
+	//Called for every step with an energy deposit
+	void	Record(const G4Step*);
+
+	void	SetFileName(const G4String& name)	{fileName = name;};
+	const G4String& GetFileName() const	{return fileName;};
+	G4bool	IsActive() const			{return active;};
+
+private:
+	DepositRecorderMessenger* messenger;
+	G4String fileName;
+	G4bool active;
+
+	const G4LogicalVolume* crystal;
+	std::vector<DepositRecord> buffer;
+};
+
+#endif
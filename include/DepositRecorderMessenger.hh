@@ -0,0 +1,30 @@
+#ifndef DepositRecorderMessenger_h
+#define DepositRecorderMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class DepositRecorder;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+
+class DepositRecorderMessenger : public G4UImessenger
+{
+
+public:
+	DepositRecorderMessenger(DepositRecorder*);
+	~DepositRecorderMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	DepositRecorder* recorder;
+
+	G4UIdirectory*			depositDir;
+	G4UIcmdWithAString*		recordCmd;
+	G4UIcmdWithoutParameter*	stopCmd;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef DepositReplay_h
+#define DepositReplay_h 1
+
+#include "globals.hh"
+#include "DepositReader.hh"
+#include "AliasTable.hh"
+
+#include <vector>
+
+class G4Event;
+
+/**
+ * Second stage of a two-stage simulation: turns the recorded crystal
+ * deposits of one event back into scintillation photons, so the optical
+ * response can be studied many times without redoing the gamma shower.
+ *
+ * The photons follow the LYSO scintillation model of the geometry:
+ * SCINTILLATIONYIELD per deposited energy, smeared by RESOLUTIONSCALE,
+ * emitted uniformly along the step, isotropic, delayed by the
+ * FASTTIMECONSTANT decay, with energies from the FASTCOMPONENT spectrum.
+ * They keep the weight and primary index of the depositing track.
+ * Cerenkov light of the first stage is not replayed.
+ */
+class DepositReplay
+{
+
+public:
+	DepositReplay();
+	~DepositReplay();
+
+	void	SetFileName(const G4String& name)	{fileName = name; ready = false;};
+	const G4String& GetFileName() const		{return fileName;};
+
+	//Replays file event eventID modulo the number of recorded events
+	void	GeneratePrimaries(G4Event*);
+
+private:
+	void	Open();
+	void	ReadScintillation();
+	G4int	SamplePhotons(G4double edep) const;
+	G4double SampleEnergy() const;
+
+	DepositReader reader;
+	G4String fileName;
+	G4bool ready;
+	G4bool wrapped;
+
+	//LYSO scintillation
+	G4double yield;
+	G4double resolution;
+	G4double decayTime;
+	std::vector<G4double> spectrumLow;
+	std::vector<G4double> spectrumWidth;
+	AliasTable spectrum;
+};
+
+#endif
@@ -6,20 +6,52 @@
 #include "G4VPhysicalVolume.hh"
 #include "G4ThreeVector.hh"
 #include "G4RotationMatrix.hh"
+#include "DetectorParameters.hh"
 
-class DetectorConstruction : public G4VUserDetectorConstruction
+#include <map>
+
+class G4LogicalVolume;
+class G4Material;
+class DetectorMessenger;
+
+class DetectorConstruction : public G4VUserDetectorConstruction, private DetectorParameters
 {
 
 public:
 	DetectorConstruction();	
 	~DetectorConstruction();
 	G4VPhysicalVolume* Construct();
+	void ConstructSDandField();
+
+	//Geometry read from GDML instead of built, set before initialization
+	void SetGDMLFile(const G4String& file)	{gdmlFile = file;};
+	//Forces the first gamma interaction in the crystals, needs the biased physics
+	void SetForcedInteraction(G4bool value)	{forcedInteraction = value;};
+	void ExportGDML(const G4String& file);
+
+	//Per logical volume navigation settings, by name
+	void SetSmartless(const G4String& volume, G4double value);
+	void SetVoxelization(const G4String& volume, G4bool value);
+
+	//Times voxelization and straight-line navigation of random rays
+	void BenchmarkNavigation(G4int nRays);
 	
 private:
-	SensitiveDetector* pSD;
-	G4VPhysicalVolume* pWorldPhys;
+	G4VPhysicalVolume* ConstructMatrix();
+	G4VPhysicalVolume* ReadGDML();
+	void CheckTiling() const;
+	void ConstructSurfaces();
+	void ApplyVolumeSettings();
 
-#include "DetectorParameterDef.hh"
+	G4VPhysicalVolume* pWorldPhys;
+	G4LogicalVolume* pRODivLog_X;
+	G4LogicalVolume* pRODivLog_Y;
+	G4Material* plateMaterial;
+	G4String gdmlFile;
+	G4bool forcedInteraction;
+	std::map<G4String, G4double> smartless;
+	std::map<G4String, G4bool> voxelize;
+	DetectorMessenger* messenger;
 };
 
 #endif
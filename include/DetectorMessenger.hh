@@ -0,0 +1,32 @@
+#ifndef DetectorMessenger_h
+#define DetectorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class DetectorConstruction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+
+class DetectorMessenger : public G4UImessenger
+{
+
+public:
+	DetectorMessenger(DetectorConstruction*);
+	~DetectorMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	DetectorConstruction* detector;
+
+	G4UIdirectory*		geometryDir;
+	G4UIcmdWithAString*	exportCmd;
+	G4UIcommand*		smartlessCmd;
+	G4UIcommand*		voxelizeCmd;
+	G4UIcmdWithAnInteger*	benchmarkCmd;
+};
+
+#endif
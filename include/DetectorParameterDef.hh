@@ -1,69 +0,0 @@
-
- G4ThreeVector Id_tr;
- G4ThreeVector tr1;
- G4RotationMatrix* Id_rot;
- G4RotationMatrix *rot;
-
- //Array
- G4double nx;
- G4double ny;
-
- //Fiber
- G4double CoreR;
- G4double Clad1R;
- G4double Clad2R;
- G4double Phi; 
-
- //Crystal
- G4double Cx;
- G4double Cy;
- G4double Cz;
- G4double CG; 
-
- //Crystal surface
- G4double CSx;
- G4double CSy;
- G4double CSz;
-
- //Plate
- G4double Px;
- G4double Py;
- G4double Pz;
-
- //Readout Geometry
- G4double ROh;
- G4double ROw;
- G4double ROd;
- G4ThreeVector tr_x;
- G4ThreeVector tr_y;
-
- //Readout Division
- G4double RODiv;
-
- //Plate surface
- G4double PSx; 
- G4double PSy;
- G4double PSz;
-
- //Fiber Slot
- G4double Tol;
- G4double Sx;
- G4double Sy;
- G4double Sz;
-
- //Matrix
- G4double Mx;
- G4double My;
- G4double Mz;
-
- //Detector
- G4double Dx;
- G4double Dy;
- G4double Dz;
-
- //World
- G4double Wx;
- G4double Wy;
- G4double Wz;
-
-
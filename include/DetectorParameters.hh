@@ -0,0 +1,203 @@
+#ifndef DetectorParameters_h
+#define DetectorParameters_h 1
+
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+
+/**
+ * Dimensions of the preshower matrix, shared by the geometry, the readout
+ * and everything sized by the number of channels. All lengths are half
+ * lengths, as given to G4Box.
+ *
+ * MatrixParameters<NX, NY> fixes the array at compile time: every derived
+ * quantity is a constant expression and channel buffers can be sized with
+ * maxX/maxY. RuntimeMatrixParameters takes the array from SetArray()
+ * before initialization, with maxX/maxY as upper bounds. Build with
+ * -DMATRIX_RUNTIME_ARRAY to select it; DetectorParameters names the one
+ * in use. Classes inherit it privately to use the names unqualified.
+ */
+
+//Dimensions that do not depend on the number of crystals
+struct MatrixDimensions
+{
+	//Fiber
+	static constexpr G4double CoreR  = .44*mm;
+	static constexpr G4double Clad1R = .47*mm;
+	static constexpr G4double Clad2R = .50*mm;
+	static constexpr G4double Phi    = 360.*deg;
+
+	//Crystal
+	static constexpr G4double Cx = 2.*mm;
+	static constexpr G4double Cy = 2.*mm;
+	static constexpr G4double Cz = 22.5*mm;
+	static constexpr G4double CG = 0.015*mm;
+
+	//Crystal surface
+	static constexpr G4double CSx = Cx + CG;
+	static constexpr G4double CSy = Cy + CG;
+	static constexpr G4double CSz = Cz + CG;
+
+	//Plate
+	static constexpr G4double Pz = 1.5*mm;
+
+	//Readout Geometry
+	static constexpr G4double ROh = 1.45*mm;
+	static constexpr G4double ROd = Pz;
+
+	//Module, half the gap between neighbours
+	static constexpr G4double MG = 0.5*mm;
+
+	//Fiber Slot
+	static constexpr G4double Tol = 0.05*mm;
+	static constexpr G4double Sx = Clad2R + Tol;
+	static constexpr G4double Sz = Clad2R + Tol;
+
+	//Matrix
+	static constexpr G4double Mz = CSz;
+
+	//Detector
+	static constexpr G4double Dx = 450.*mm;
+	static constexpr G4double Dy = 450.*mm;
+	static constexpr G4double Dz = 450.*mm;
+
+	//World
+	static constexpr G4double Wx = 1.2*Dx;
+	static constexpr G4double Wy = 1.2*Dy;
+	static constexpr G4double Wz = 1.2*Dz;
+};
+
+static_assert(MatrixDimensions::CoreR < MatrixDimensions::Clad1R
+	      && MatrixDimensions::Clad1R < MatrixDimensions::Clad2R, "fiber claddings must enclose the core");
+static_assert(MatrixDimensions::Sx <= MatrixDimensions::CSx, "fiber slots wider than the crystal pitch");
+static_assert(2.*MatrixDimensions::Sz <= MatrixDimensions::Pz, "fiber slots of both planes overlap in the plate");
+static_assert(MatrixDimensions::Dz >= MatrixDimensions::Mz + 2.*MatrixDimensions::Pz, "matrix and plate do not fit the detector");
+
+template<G4int NX, G4int NY>
+struct MatrixParameters : MatrixDimensions
+{
+	//Array
+	static constexpr G4int nx = NX;
+	static constexpr G4int ny = NY;
+	static constexpr G4int maxX = NX;
+	static constexpr G4int maxY = NY;
+
+	//Plate
+	static constexpr G4double Px = nx*CSx;
+	static constexpr G4double Py = ny*CSy;
+
+	//Readout Geometry and Division
+	static constexpr G4double ROw = Px;
+	static constexpr G4double RODiv = ROw/nx;
+
+	//Fiber Slot
+	static constexpr G4double Sy = Py;
+
+	//Matrix
+	static constexpr G4double Mx = nx*CSx;
+	static constexpr G4double My = ny*CSy;
+
+	static_assert(NX > 0 && NY > 0, "empty crystal array");
+	//One fiber assembly is imprinted rotated for the Y plane
+	static_assert(NX == NY, "the fiber planes need a square array");
+	static_assert(Mx < Dx && My < Dy, "matrix wider than the detector");
+};
+
+//Out of class definitions for odr-used constants (C++11)
+template<G4int NX, G4int NY> constexpr G4int MatrixParameters<NX, NY>::nx;
+template<G4int NX, G4int NY> constexpr G4int MatrixParameters<NX, NY>::ny;
+template<G4int NX, G4int NY> constexpr G4int MatrixParameters<NX, NY>::maxX;
+template<G4int NX, G4int NY> constexpr G4int MatrixParameters<NX, NY>::maxY;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::Px;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::Py;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::ROw;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::RODiv;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::Sy;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::Mx;
+template<G4int NX, G4int NY> constexpr G4double MatrixParameters<NX, NY>::My;
+
+struct RuntimeMatrixParameters : MatrixDimensions
+{
+	//Upper bounds for channel buffers (the live monitor segment size)
+	static constexpr G4int maxX = 64;
+	static constexpr G4int maxY = 64;
+
+	//Recomputes the derived dimensions, before initialization only
+	static void SetArray(G4int nx, G4int ny);
+
+	static G4int nx;
+	static G4int ny;
+	static G4double Px;
+	static G4double Py;
+	static G4double ROw;
+	static G4double RODiv;
+	static G4double Sy;
+	static G4double Mx;
+	static G4double My;
+};
+
+//Crystals per side, -DMATRIX_ARRAY=<n> to change
+#ifndef MATRIX_ARRAY
+#define MATRIX_ARRAY 25
+#endif
+
+#ifdef MATRIX_RUNTIME_ARRAY
+typedef RuntimeMatrixParameters DetectorParameters;
+#else
+typedef MatrixParameters<MATRIX_ARRAY, MATRIX_ARRAY> DetectorParameters;
+#endif
+
+/**
+ * Plane of identical modules (matrix, plate and readouts), set with
+ * SetTiling() before initialization. A module cell holds the matrix at its
+ * centre, the readouts on its +x and +y sides and half the gap all round.
+ * Modules are numbered row by row, module = my*nModulesX + mx.
+ *
+ * Global channel IDs pack module, axis and channel densely, the X channels
+ * of a module followed by its Y channels:
+ *   id = module*(nx + ny) + (axis == 1 ? channel : nx + channel)
+ * so per-channel arrays are sized with NumberOfChannels().
+ */
+struct ModuleTiling : DetectorParameters
+{
+	//Before initialization only
+	static void SetTiling(G4int mx, G4int my);
+
+	static G4int nModulesX;
+	static G4int nModulesY;
+
+	static G4int	NumberOfModules()	{return nModulesX*nModulesY;};
+	static G4int	ChannelsPerModule()	{return nx + ny;};
+	static G4int	NumberOfChannels()	{return NumberOfModules()*ChannelsPerModule();};
+
+	//Half sizes of a module cell and of the plane
+	static G4double	ModuleX()		{return Mx + 2.*ROh + MG;};
+	static G4double	ModuleY()		{return My + 2.*ROh + MG;};
+	static G4double	ModuleZ()		{return Mz + Pz;};
+	static G4double	PlaneX()		{return nModulesX*ModuleX();};
+	static G4double	PlaneY()		{return nModulesY*ModuleY();};
+
+	//Detector and world grow with the plane, never below one module's
+	static G4double	DetectorX()		{return std::max(Dx, 1.05*PlaneX());};
+	static G4double	DetectorY()		{return std::max(Dy, 1.05*PlaneY());};
+	static G4double	WorldX()		{return 1.2*DetectorX();};
+	static G4double	WorldY()		{return 1.2*DetectorY();};
+
+	static G4int	Module(G4int mx, G4int my)	{return my*nModulesX + mx;};
+	static G4double	ModuleCentreX(G4int mx)		{return (2*mx + 1)*ModuleX() - PlaneX();};
+	static G4double	ModuleCentreY(G4int my)		{return (2*my + 1)*ModuleY() - PlaneY();};
+
+	static G4int	ChannelID(G4int module, G4int axis, G4int channel)
+			{return module*(nx + ny) + (axis == 1 ? channel : nx + channel);};
+	static void	DecodeChannel(G4int id, G4int& module, G4int& axis, G4int& channel);
+
+	//Channel of one axis counted over all modules, for per-axis histograms
+	static G4int	AxisChannel(G4int module, G4int axis, G4int channel)
+			{return module*(axis == 1 ? nx : ny) + channel;};
+
+	//Module and crystal below a point of the plane, false between matrices
+	static G4bool	Locate(G4double x, G4double y, G4int& module, G4int& ix, G4int& iy);
+};
+
+#endif
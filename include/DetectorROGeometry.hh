@@ -3,8 +3,9 @@
 #define DetectorROGeometry_h 1
 
 #include "G4VReadOutGeometry.hh"
+#include "DetectorParameters.hh"
 
-class DetectorROGeometry : public G4VReadOutGeometry
+class DetectorROGeometry : public G4VReadOutGeometry, private DetectorParameters
 {
 
 public:
@@ -14,9 +15,6 @@ public:
 
 private:
 	G4VPhysicalVolume* Build();
-	
-#include "DetectorParameterDef.hh"
-
 };
 
 #endif
@@ -2,16 +2,29 @@
 #define EventAction_h 1
 
 #include "G4UserEventAction.hh"
+#include "globals.hh"
+#include "Hits.hh"
+
+class RunAction;
+class RunCheckpoint;
 
 class EventAction : public G4UserEventAction
 {
 public:
-	EventAction();
+	EventAction(RunAction*);
 	~EventAction();
 
 	void BeginOfEventAction(const G4Event*);
 	void EndOfEventAction(const G4Event*);
-	
+
+	//One ntuple row and histogram entry per hit, also driven by microbench
+	void FillOutput(const G4Event*, HitsCollection*, RunCheckpoint*);
+
+private:
+	HitsCollection* GetHits(const G4Event*);
+
+	RunAction* runAction;
+	G4int hcID;
 };
 
 #endif
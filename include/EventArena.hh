@@ -0,0 +1,163 @@
+#ifndef EventArena_h
+#define EventArena_h 1
+
+#include "globals.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Per-thread bump allocator for objects that live for one event: hits and
+ * per-event scratch buffers.
+ *
+ * Memory comes in large chunks mapped on first use, optionally backed by
+ * huge pages, and is handed out by moving a pointer. Freeing only counts:
+ * every block carries its arena, so it may be freed from any thread, and
+ * Reset() at the start of an event rewinds the whole arena once nothing
+ * allocated since the last rewind is alive. Events kept by the run manager
+ * (for visualisation) hold their hits, the rewind then waits and the arena
+ * grows until they are released. Chunks are never unmapped, like the
+ * pages of a G4Allocator.
+ *
+ * One instance per thread, created on first use.
+ */
+class EventArena
+{
+
+public:
+	static EventArena* Instance();
+
+	inline void*	Allocate(std::size_t size);
+	static inline void Free(void* p);
+
+	//Start of an event, rewinds if nothing is alive
+	void	Reset();
+
+	//Chunks mapped from now on, in bytes and with or without huge pages
+	static void	SetChunkSize(G4double bytes);
+	static void	SetHugePages(G4bool value);
+
+	//Counts of a run, summed over threads by the MemoryMonitor
+	struct Statistics
+	{
+		G4double allocations;
+		G4double bytes;
+		G4double reusedBytes;		//served from memory touched before
+		G4double highWater;		//largest single event, in bytes
+		G4double resets;
+		G4double deferred;		//rewinds skipped, blocks still alive
+		G4double chunks;
+		G4double hugeChunks;
+		G4double reserved;		//bytes of all chunks
+		G4double minorFaults;		//page faults of the thread over the run
+		G4double majorFaults;
+
+		void	Clear();
+		void	Merge(const Statistics&);
+	};
+
+	void	BeginOfRun();
+	const Statistics& EndOfRun();
+
+	G4double GetReservedBytes() const	{return reserved;};
+
+private:
+	EventArena();
+
+	//Blocks are aligned for any type, behind the arena that owns them
+	static const std::size_t kAlign = 16;
+	static const std::size_t kHeader = 16;
+
+	struct Chunk
+	{
+		char* base;
+		std::size_t size;
+		std::size_t touched;
+		G4bool huge;
+	};
+
+	inline void* Take(std::size_t need);
+	void*	Grow(std::size_t need);
+	void	Select(G4int index);
+	void	Map(std::size_t need);
+
+	std::vector<Chunk> chunks;
+	G4int current;
+	char* base;
+	std::size_t offset;
+	std::size_t limit;
+	std::size_t touched;
+	std::size_t used;
+	G4double reserved;
+	std::atomic<long> live;
+
+	//Of this run
+	unsigned long long allocations;
+	unsigned long long bytes;
+	unsigned long long reusedBytes;
+	std::size_t highWater;
+	long resets;
+	long deferred;
+	long minorFaults;
+	long majorFaults;
+	Statistics statistics;
+};
+
+inline void* EventArena::Allocate(std::size_t size)
+{
+	std::size_t need = kHeader + ((size + kAlign - 1) & ~(kAlign - 1));
+	if(offset + need > limit) return Grow(need);
+	return Take(need);
+}
+
+inline void* EventArena::Take(std::size_t need)
+{
+	char* block = base + offset;
+	if(offset < touched) reusedBytes += std::min(need, touched - offset);
+	offset += need;
+	if(offset > touched) touched = offset;
+	used += need;
+	allocations++;
+	bytes += need;
+	live.fetch_add(1, std::memory_order_relaxed);
+	*reinterpret_cast<EventArena**>(block) = this;
+	return block + kHeader;
+}
+
+inline void EventArena::Free(void* p)
+{
+	if(!p) return;
+	EventArena* owner = *reinterpret_cast<EventArena**>(static_cast<char*>(p) - kHeader);
+	owner->live.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * STL allocator on the arena of the constructing thread, for per-event
+ * containers. The container must not grow from other threads.
+ */
+template<class T> struct ArenaAllocator
+{
+	typedef T value_type;
+
+	ArenaAllocator() : arena(EventArena::Instance()) {}
+	template<class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T*	allocate(std::size_t n)			{return static_cast<T*>(arena->Allocate(n*sizeof(T)));};
+	void	deallocate(T* p, std::size_t)		{EventArena::Free(p);};
+
+	EventArena* arena;
+};
+
+template<class T, class U> inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena == b.arena;
+}
+
+template<class T, class U> inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena != b.arena;
+}
+
+#endif
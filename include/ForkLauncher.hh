@@ -0,0 +1,31 @@
+#ifndef ForkLauncher_h
+#define ForkLauncher_h 1
+
+#include "globals.hh"
+
+class G4RunManager;
+
+/**
+ * Runs one sequential run in forked worker processes.
+ *
+ * The parent has initialized geometry and physics and built the physics
+ * tables (BeamOn(0)), so the workers share them copy-on-write instead of
+ * each building its own copy. Worker k gets seed + k, a contiguous range
+ * of the event IDs and its own output (<file>_p<k>.root) and checkpoint
+ * directory; the parent waits for all of them and merges the outputs,
+ * histograms added and ntuples chained, into <file>.root. An alternative
+ * to threads for code that is not thread-safe.
+ */
+class ForkLauncher
+{
+
+public:
+	//0 when every worker succeeded and the outputs are merged
+	static G4int Run(G4RunManager*, G4int nWorkers, G4int nEvents, long seed);
+
+private:
+	static void	RunWorker(G4RunManager*, G4int worker, G4int nWorkers, G4int nEvents, long seed);
+	static G4bool	Merge(const G4String& fileName, G4int nWorkers);
+};
+
+#endif
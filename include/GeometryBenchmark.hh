@@ -0,0 +1,23 @@
+#ifndef GeometryBenchmark_h
+#define GeometryBenchmark_h 1
+
+#include "globals.hh"
+
+class G4VPhysicalVolume;
+
+/**
+ * Straight-line navigation benchmark.
+ *
+ * Rays start at random points of the detector envelope with isotropic
+ * directions and are stepped boundary to boundary, as transportation does,
+ * until they leave the world. The random sequence is fixed, so geometries
+ * built in C++ and read from GDML see the same rays.
+ */
+class GeometryBenchmark
+{
+
+public:
+	static void Run(G4VPhysicalVolume* world, G4int nRays);
+};
+
+#endif
@@ -3,7 +3,7 @@
 
 #include "G4VHit.hh"
 #include "G4THitsCollection.hh"
-#include "G4Allocator.hh"
+#include "EventArena.hh"
 #include "G4ThreeVector.hh"
 
 class Hits : public G4VHit{
@@ -23,24 +23,40 @@ public:
 	G4double getEnergy() const	{return energy;  };
 	void setPos(G4ThreeVector Pos)	{pos = Pos;};
 	G4ThreeVector getPos() const	{return pos;  };
+	void setTime(G4double Time)	{time = Time;};
+	G4double getTime() const	{return time;  };
+	void setModule(G4int Module)	{module = Module;};
+	G4int getModule() const	{return module;  };
+	void setAxis(G4int Axis)	{axis = Axis;};
+	G4int getAxis() const		{return axis;  };
+	void setChannel(G4int Channel)	{channel = Channel;};
+	G4int getChannel() const	{return channel;  };
+	void setPrimary(G4int Primary)	{primary = Primary;};
+	G4int getPrimary() const	{return primary;  };
+	void setWeight(G4double Weight)	{weight = Weight;};
+	G4double getWeight() const	{return weight;  };
 
 private:
 	G4double energy;
 	G4ThreeVector pos;
+	G4double time;
+	G4int module;
+	G4int axis;
+	G4int channel;
+	G4int primary;
+	G4double weight;
 };
 
 typedef G4THitsCollection<Hits> HitsCollection;
-extern G4Allocator<Hits> HitAllocator;
 
-inline void* Hits::operator new(size_t){
+//Hits live for one event, they come from the arena of the thread
+inline void* Hits::operator new(size_t size){
 
-	void* hit;
-	hit = (void*)HitAllocator.MallocSingle();
-	return hit;
+	return EventArena::Instance()->Allocate(size);
 }
 
 inline void Hits::operator delete(void* hit){
 
-	HitAllocator.FreeSingle((Hits*)hit);
+	EventArena::Free(hit);
 }
 #endif
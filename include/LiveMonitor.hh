@@ -0,0 +1,59 @@
+#ifndef LiveMonitor_h
+#define LiveMonitor_h 1
+
+#include "globals.hh"
+#include "Hits.hh"
+#include "DetectorParameters.hh"
+
+#include <array>
+#include <chrono>
+#include <stdint.h>
+
+class G4Run;
+class LiveMonitorMessenger;
+struct LiveMonitorSegment;
+
+/**
+ * Publishes the progress of the run into a POSIX shared-memory segment
+ * (see LiveMonitorSegment.hh) that tools/matrix_monitor displays.
+ *
+ * The master thread owns the segment. Every thread counts into plain
+ * local variables and adds them to the segment at most once per update
+ * interval, so the event loop only pays for a few increments per event.
+ */
+class LiveMonitor : private DetectorParameters
+{
+
+public:
+	LiveMonitor();
+	~LiveMonitor();
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(HitsCollection*, G4int photonsTracked);
+
+	void	SetSegmentName(const G4String& name)	{segmentName = name;};
+	void	SetInterval(G4double seconds)		{interval = seconds;};
+
+	G4bool	IsActive() const;
+
+private:
+	G4bool	Create();
+	void	Flush();
+
+	LiveMonitorMessenger* messenger;
+	G4String segmentName;
+	G4double interval;
+	G4bool owner;
+
+	//Not yet published counts of this thread
+	uint64_t events;
+	uint64_t tracked;
+	uint64_t detected;
+	std::array<uint64_t, maxX> channelX;
+	std::array<uint64_t, maxY> channelY;
+	G4int sinceCheck;
+	std::chrono::steady_clock::time_point lastFlush;
+};
+
+#endif
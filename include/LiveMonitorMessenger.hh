@@ -0,0 +1,30 @@
+#ifndef LiveMonitorMessenger_h
+#define LiveMonitorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class LiveMonitor;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+
+class LiveMonitorMessenger : public G4UImessenger
+{
+
+public:
+	LiveMonitorMessenger(LiveMonitor*);
+	~LiveMonitorMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	LiveMonitor* monitor;
+
+	G4UIdirectory*		monitorDir;
+	G4UIcmdWithAString*	segmentCmd;
+	G4UIcmdWithADouble*	intervalCmd;
+};
+
+#endif
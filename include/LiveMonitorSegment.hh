@@ -0,0 +1,46 @@
+#ifndef LiveMonitorSegment_h
+#define LiveMonitorSegment_h 1
+
+#include <atomic>
+#include <stdint.h>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "The live monitor needs lock-free 64 bit atomics"
+#endif
+
+/**
+ * Layout of the POSIX shared-memory segment published by a running
+ * matrix job and read by tools/matrix_monitor. No Geant4 types, so the
+ * viewer builds on its own.
+ *
+ * Every field is an independent lock-free atomic: writers add their
+ * increments with relaxed ordering and readers see a slightly moving
+ * but never torn picture. updateTime is stored last (release), so a
+ * reader that loads it first (acquire) sees counters at least that new.
+ */
+struct LiveMonitorSegment
+{
+	enum { kMaxChannels = 64 };
+	enum State { kIdle = 0, kRunning = 1, kDone = 2 };
+
+	char		magic[8];		//"MTXMON1"
+	uint32_t	version;
+	uint32_t	nChannelsX;
+	uint32_t	nChannelsY;
+	int32_t		pid;
+
+	std::atomic<int32_t>	state;
+	std::atomic<int32_t>	runID;
+	std::atomic<uint64_t>	eventsRequested;
+	std::atomic<uint64_t>	events;
+	std::atomic<uint64_t>	photonsTracked;
+	std::atomic<uint64_t>	photonsDetected;
+	std::atomic<uint64_t>	residentBytes;
+	std::atomic<int64_t>	startTime;	//ns, steady clock
+	std::atomic<int64_t>	updateTime;	//ns, steady clock
+
+	std::atomic<uint64_t>	channelX[kMaxChannels];
+	std::atomic<uint64_t>	channelY[kMaxChannels];
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MappedFile_h
+#define MappedFile_h 1
+
+#include "globals.hh"
+#include <cstddef>
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * Pages are brought in by the kernel on demand; Prefetch() asks for a
+ * window ahead of the reader so sequential access never blocks on I/O.
+ */
+class MappedFile
+{
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	G4bool	Open(const G4String& fileName);
+	void	Close();
+	void	Prefetch(std::size_t offset, std::size_t length) const;
+
+	G4bool		IsOpen() const		{return data != 0;};
+	const char*	GetData() const		{return data;};
+	std::size_t	GetSize() const		{return size;};
+	const G4String&	GetFileName() const	{return fileName;};
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	G4String fileName;
+	const char* data;
+	std::size_t size;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef MemoryMonitor_h
+#define MemoryMonitor_h 1
+
+#include "globals.hh"
+
+class G4Run;
+class Run;
+class MemoryMonitorMessenger;
+
+/**
+ * Memory instrumentation of the event loop.
+ *
+ * After every event each thread samples the resident set size of the
+ * process and the size of the G4Allocator pools it owns (tracks, dynamic
+ * particles, touchables, trajectories and their points) and of its event
+ * arena, where the hits live. Every
+ * reportEvery events of the run the RSS, its growth since the previous
+ * report and the pool sizes are printed; the run summary gives the peaks
+ * and a linear fit of RSS against the event count. Pools are expected to
+ * plateau, RSS to flatten once the caches are warm. The samples of the
+ * run are kept by the Run, which merges them over the threads.
+ *
+ * The event arena statistics (allocations, reuse, high water mark, chunks
+ * and page faults of the event loop) are printed for every run.
+ *
+ * With leakCheck on, a run whose RSS still grows linearly after the first
+ * tenth of its events (slope above the threshold and a good fit) ends
+ * with a fatal exception, so leak tests fail loudly.
+ */
+class MemoryMonitor
+{
+
+public:
+	MemoryMonitor();
+	~MemoryMonitor();
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(Run*);
+
+	void	SetEnabled(G4bool value)		{enabled = value;};
+	void	SetReportEvery(G4int n)			{reportEvery = n > 0 ? n : 1;};
+	void	SetLeakCheck(G4bool value)		{leakCheck = value;};
+	void	SetLeakThreshold(G4double bytes)	{leakThreshold = bytes;};
+
+	G4bool	IsActive() const			{return enabled || leakCheck;};
+
+	//Least squares fit of y against x, accumulated online
+	struct Fit
+	{
+		G4double n;
+		G4double meanX;
+		G4double meanY;
+		G4double cXX;
+		G4double cXY;
+		G4double cYY;
+
+		void	Clear()		{n = meanX = meanY = cXX = cXY = cYY = 0;};
+		void	Add(G4double x, G4double y);
+		void	Merge(const Fit&);
+		G4double Slope() const;
+		G4double R2() const;
+	};
+
+	enum {kPools = 6};
+
+	//Samples of a run, peaks and fit over all threads, pools summed
+	struct Samples
+	{
+		G4double peak;
+		Fit fit;
+		G4double pools[kPools];		//after the last event of a thread
+		G4double poolPeaks[kPools];
+
+		void	Clear();
+		void	Merge(const Samples&);
+	};
+
+private:
+	void	Report(G4long events, G4double rss, const Samples&);
+
+	MemoryMonitorMessenger* messenger;
+	G4bool enabled;
+	G4int reportEvery;
+	G4bool leakCheck;
+	G4double leakThreshold;
+};
+
+#endif
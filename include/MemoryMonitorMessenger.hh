@@ -0,0 +1,35 @@
+#ifndef MemoryMonitorMessenger_h
+#define MemoryMonitorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class MemoryMonitor;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+
+class MemoryMonitorMessenger : public G4UImessenger
+{
+
+public:
+	MemoryMonitorMessenger(MemoryMonitor*);
+	~MemoryMonitorMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	MemoryMonitor* monitor;
+
+	G4UIdirectory*		memoryDir;
+	G4UIcmdWithABool*	enableCmd;
+	G4UIcmdWithAnInteger*	reportEveryCmd;
+	G4UIcmdWithABool*	leakCheckCmd;
+	G4UIcmdWithADouble*	leakThresholdCmd;
+	G4UIcmdWithAnInteger*	arenaChunkCmd;
+	G4UIcmdWithABool*	hugePagesCmd;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef PhaseSpaceReader_h
+#define PhaseSpaceReader_h 1
+
+#include "globals.hh"
+#include "MappedFile.hh"
+#include "G4ThreeVector.hh"
+
+#include <stdint.h>
+
+/**
+ * Binary phase-space file layout (little endian):
+ *
+ *   PhaseSpaceHeader   magic "MTXPSF1", version, record size, record count
+ *   PhaseSpaceRecord[] one per particle
+ *
+ * Positions are in mm (world frame), energy in MeV, time in ns.
+ */
+struct PhaseSpaceHeader
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	recordSize;
+	uint64_t	nRecords;
+};
+
+struct PhaseSpaceRecord
+{
+	int32_t	pdg;
+	float	x, y, z;
+	float	dx, dy, dz;
+	float	energy;
+	float	time;
+	float	weight;
+};
+
+/**
+ * Sequential reader over a memory mapped phase-space file.
+ *
+ * Each reader walks its own disjoint slice of the records. A record can be
+ * reused several times; with rotation enabled every reuse is turned by a
+ * further 90 deg around the beam (z) axis, which keeps the square matrix
+ * symmetric while multiplying the statistics of the input.
+ */
+class PhaseSpaceReader
+{
+
+public:
+	PhaseSpaceReader();
+	~PhaseSpaceReader();
+
+	G4bool	Open(const G4String& fileName);
+	void	Close();
+
+	void	SetSlice(G4int index, G4int count);
+	void	SetRecycle(G4int n)			{recycle = n > 0 ? n : 1;};
+	void	SetRotate(G4bool value)			{rotate = value;};
+	void	SetReadAhead(std::size_t bytes)		{readAhead = bytes;};
+
+	//Fills the next particle, applying recycling rotation. Wraps around
+	//the slice when exhausted.
+	void	Next(G4int& pdg, G4ThreeVector& pos, G4ThreeVector& dir,
+		     G4double& energy, G4double& time, G4double& weight);
+
+	//Moves on as if Next() had been called n times
+	void	Skip(uint64_t n);
+
+	G4bool	IsOpen() const			{return file.IsOpen();};
+	uint64_t GetNumberOfRecords() const	{return nRecords;};
+	uint64_t GetSliceBegin() const		{return sliceBegin;};
+	uint64_t GetSliceEnd() const		{return sliceEnd;};
+	G4int	GetNumberOfWraps() const	{return nWraps;};
+
+private:
+	void	Rewind();
+
+	MappedFile file;
+	const PhaseSpaceRecord* records;
+	uint64_t nRecords;
+
+	G4int sliceIndex;
+	G4int sliceCount;
+	uint64_t sliceBegin;
+	uint64_t sliceEnd;
+
+	uint64_t cursor;
+	uint64_t prefetched;
+	G4int use;
+	G4int recycle;
+	G4bool rotate;
+	std::size_t readAhead;
+	G4int nWraps;
+};
+
+#endif
@@ -3,6 +3,9 @@
 
 #include "G4VUserPhysicsList.hh"
 
+class PhysicsListMessenger;
+class PhysicsTableCache;
+
 class PhysicsList: public G4VUserPhysicsList
 {
 
@@ -11,6 +14,15 @@ public:
 	PhysicsList();
 	~PhysicsList();
 
+	PhysicsTableCache* GetTableCache() const	{return tableCache;};
+
+	//Wraps the gamma processes for generic biasing, before initialization
+	void SetForcedInteraction(G4bool value)	{forcedInteraction = value;};
+
+	//"delta" or "exponential", applied to every thread at its next run
+	void SetWLSTimeProfile(const G4String& name)	{wlsTimeProfile = name;};
+	void ApplyWLSTimeProfile() const;
+
 private:
 
 	void ConstructParticle();
@@ -20,6 +32,12 @@ private:
 	void ConstructEM();
 	void ConstructOp();
 	void ConstructScintillation();
+	void ConstructBiasing();
+
+	PhysicsListMessenger* messenger;
+	PhysicsTableCache* tableCache;
+	G4bool forcedInteraction;
+	G4String wlsTimeProfile;
 
 };
 
@@ -0,0 +1,52 @@
+#ifndef PhysicsTableCache_h
+#define PhysicsTableCache_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+#include <chrono>
+
+class G4VUserPhysicsList;
+
+/**
+ * On-disk cache of the physics tables.
+ *
+ * When the kernel initializes the first run, the configuration (Geant4
+ * version, processes, materials with their property tables, cuts) is
+ * hashed. If <directory>/<hash> holds a complete set of tables they are
+ * retrieved instead of built; otherwise they are built and stored there
+ * for the next job. Entries are written to a private directory and
+ * renamed into place, so concurrent jobs sharing the cache never see a
+ * partial entry. Any configuration change gives a new hash.
+ */
+class PhysicsTableCache : public G4VStateDependent
+{
+
+public:
+	PhysicsTableCache(G4VUserPhysicsList*);
+	~PhysicsTableCache();
+
+	G4bool	Notify(G4ApplicationState requestedState);
+
+	void	SetDirectory(const G4String& dir)	{directory = dir;};
+	const G4String& GetDirectory() const		{return directory;};
+
+	//Hash of everything the tables depend on
+	G4String ComputeKey() const;
+
+private:
+	void	BeginTables();
+	void	EndTables();
+	void	Store(G4double buildSeconds);
+	G4double ReadBuildTime(const G4String& entry) const;
+
+	G4VUserPhysicsList* physicsList;
+	G4String directory;
+	G4String key;
+	G4bool timing;
+	G4bool done;
+	G4bool retrieved;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PrimaryForceCollision_h
+#define PrimaryForceCollision_h 1
+
+#include "globals.hh"
+#include "G4VBiasingOperator.hh"
+
+class G4BOptrForceCollision;
+
+/**
+ * Forced interaction of the primary gammas only (matrix --force-interaction).
+ *
+ * Wraps a G4BOptrForceCollision and hands it the primary tracks and the
+ * clones it makes of them at the volume entry; every other track, such as
+ * fluorescence or annihilation gammas from the crystal, is tracked
+ * analog. The wrapped operator gets its run and tracking calls from the
+ * biasing interface directly, like any other operator.
+ *
+ * Thread local, attached to the crystals.
+ */
+class PrimaryForceCollision : public G4VBiasingOperator
+{
+
+public:
+	PrimaryForceCollision(const G4String& particle, const G4String& name = "PrimaryForceCollision");
+	virtual ~PrimaryForceCollision();
+
+	virtual void	StartTracking(const G4Track* track);
+
+private:
+	virtual G4VBiasingOperation*	ProposeNonPhysicsBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess);
+	virtual G4VBiasingOperation*	ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess);
+	virtual G4VBiasingOperation*	ProposeFinalStateBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess);
+
+	virtual void	OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase biasingCase,
+					 G4VBiasingOperation* operationApplied, const G4VParticleChange* particleChangeProduced);
+	virtual void	OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase biasingCase,
+					 G4VBiasingOperation* occurenceOperationApplied, G4double weightForOccurenceInteraction,
+					 G4VBiasingOperation* finalStateOperationApplied, const G4VParticleChange* particleChangeProduced);
+
+	G4BOptrForceCollision* forceCollision;
+	//The current track is a primary or a clone of one
+	G4bool forced;
+};
+
+#endif
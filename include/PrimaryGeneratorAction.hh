@@ -4,9 +4,35 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4ParticleGun.hh"
 #include "G4Event.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "AliasTable.hh"
+#include "DetectorParameters.hh"
 
+#include <vector>
+#include <cmath>
 
-class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
+class G4ParticleDefinition;
+class G4PrimaryVertex;
+class PhaseSpaceReader;
+class DepositReplay;
+class PrimaryGeneratorMessenger;
+
+/**
+ * Primary source for the preshower matrix.
+ *
+ * The particle gun holds the particle, energy, position and direction set
+ * with /gun/; the /matrix/source/ commands spread them with light-weight
+ * position, angular and energy distributions. Spectra are sampled from a
+ * precomputed alias table. Alternatively primaries are read from a
+ * phase-space file, or an event is the scintillation light of recorded
+ * crystal deposits (DepositReplay).
+ *
+ * An event holds a fixed number of independent primaries, or a Poisson
+ * number of them at random times inside a pile-up window. Every primary
+ * particle carries its index in a PrimaryInformation.
+ */
+class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction, private DetectorParameters
 {
 
 public:
@@ -15,9 +41,76 @@ public:
 	~PrimaryGeneratorAction();
 	void GeneratePrimaries(G4Event*);
 
+	void SetSourceType(const G4String&);
+	void SetPhaseSpaceFile(const G4String& name)	{phaseSpaceFile = name; phaseSpaceOpen = false;};
+	void SetPhaseSpaceSlice(G4int index, G4int count);
+	PhaseSpaceReader* GetPhaseSpaceReader() const	{return phaseSpace;};
+	void SetDepositFile(const G4String& name);
+
+	void SetPositionShape(const G4String&);
+	void SetSpotHalfSize(G4double value)		{spotHalfSize = spotHalfSizeY = value;};
+	void SetSpotSigma(G4double value)		{spotSigma = value;};
+	void SetAngularShape(const G4String&);
+	void SetConeHalfAngle(G4double value)		{coneCosMin = std::cos(value);};
+	void SetEnergySpectrum(const G4String& fileName);
+	void SetMonoEnergetic()				{spectrumLow.clear(); spectrumWidth.clear(); spectrum.Clear();};
+	void SetPairs(G4bool value)			{pairs = value;};
+	void SetPrimariesPerEvent(G4int n)		{primariesPerEvent = n;};
+	void SetPileupRate(G4double rate)		{pileupRate = rate;};
+	void SetPileupWindow(G4double window)		{pileupWindow = window;};
+	void SetFirstEventID(G4int id)			{firstEventID = id; phaseSpaceOpen = false;};
+	G4int GetFirstEventID() const			{return firstEventID;};
+
 private:
 
+	enum SourceType {kGun, kPhaseSpace, kDeposits};
+	enum PositionShape {kPoint, kSquare, kGaussian, kRaster};
+	enum AngularShape {kBeam, kIsotropic, kCone};
+
+	G4PrimaryVertex* GenerateBeam(G4long serial);
+	G4ThreeVector SamplePosition(G4long serial) const;
+	G4ThreeVector SampleDirection() const;
+	G4double SampleEnergy() const;
+
+	void OpenPhaseSpace();
+	G4PrimaryVertex* GeneratePhaseSpace();
+	G4ParticleDefinition* FindParticle(G4int pdg);
+
 	G4ParticleGun* particleGun;
+	PrimaryGeneratorMessenger* messenger;
+	SourceType sourceType;
+
+	//Distributions around the gun settings
+	PositionShape positionShape;
+	AngularShape angularShape;
+	G4double spotHalfSize;
+	G4double spotHalfSizeY;
+	G4double spotSigma;
+	G4double coneCosMin;
+	G4bool pairs;
+
+	//Primaries per event
+	G4int primariesPerEvent;
+	G4double pileupRate;
+	G4double pileupWindow;
+	G4int firstEventID;
+
+	//Tabulated energy spectrum
+	std::vector<G4double> spectrumLow;
+	std::vector<G4double> spectrumWidth;
+	AliasTable spectrum;
+
+	//Phase-space source
+	PhaseSpaceReader* phaseSpace;
+	G4String phaseSpaceFile;
+	G4bool phaseSpaceOpen;
+	G4int sliceIndex;
+	G4int sliceCount;
+	G4int lastPdg;
+	G4ParticleDefinition* lastParticle;
+
+	//Deposit replay source
+	DepositReplay* deposits;
 };
 
 #endif
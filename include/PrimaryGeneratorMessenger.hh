@@ -0,0 +1,63 @@
+#ifndef PrimaryGeneratorMessenger_h
+#define PrimaryGeneratorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class PrimaryGeneratorAction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+class PrimaryGeneratorMessenger : public G4UImessenger
+{
+
+public:
+	PrimaryGeneratorMessenger(PrimaryGeneratorAction*);
+	~PrimaryGeneratorMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	PrimaryGeneratorAction* generator;
+
+	G4UIdirectory*		matrixDir;
+	G4UIdirectory*		sourceDir;
+	G4UIcmdWithAString*	typeCmd;
+	G4UIcmdWithABool*	pairsCmd;
+	G4UIcmdWithAnInteger*	primariesCmd;
+	G4UIcmdWithAnInteger*	firstEventCmd;
+
+	G4UIdirectory*		pileupDir;
+	G4UIcmdWithADoubleAndUnit* rateCmd;
+	G4UIcmdWithADoubleAndUnit* windowCmd;
+
+	G4UIdirectory*		positionDir;
+	G4UIcmdWithAString*	positionShapeCmd;
+	G4UIcmdWithADoubleAndUnit* halfSizeCmd;
+	G4UIcmdWithADoubleAndUnit* sigmaCmd;
+
+	G4UIdirectory*		angleDir;
+	G4UIcmdWithAString*	angleShapeCmd;
+	G4UIcmdWithADoubleAndUnit* coneCmd;
+
+	G4UIdirectory*		energyDir;
+	G4UIcmdWithAString*	spectrumCmd;
+	G4UIcmdWithoutParameter* monoCmd;
+
+	G4UIdirectory*		phaseSpaceDir;
+	G4UIcmdWithAString*	fileCmd;
+	G4UIcmdWithAnInteger*	recycleCmd;
+	G4UIcmdWithABool*	rotateCmd;
+	G4UIcmdWithAnInteger*	readAheadCmd;
+	G4UIcommand*		sliceCmd;
+
+	G4UIdirectory*		depositsDir;
+	G4UIcmdWithAString*	depositFileCmd;
+};
+
+#endif
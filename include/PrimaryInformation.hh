@@ -0,0 +1,26 @@
+#ifndef PrimaryInformation_h
+#define PrimaryInformation_h 1
+
+#include "G4VUserPrimaryParticleInformation.hh"
+#include "globals.hh"
+
+/**
+ * Tags a primary particle with its index inside a multi-primary event.
+ * Both photons of a back-to-back pair share the same index.
+ */
+class PrimaryInformation : public G4VUserPrimaryParticleInformation
+{
+
+public:
+	PrimaryInformation(G4int Index) : index(Index) {};
+	~PrimaryInformation() {};
+
+	void	Print() const;
+
+	G4int	getIndex() const	{return index;};
+
+private:
+	G4int index;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef Run_h
+#define Run_h 1
+
+#include "G4Run.hh"
+#include "globals.hh"
+#include "BiasingMonitor.hh"
+#include "MemoryMonitor.hh"
+
+#include <algorithm>
+
+/**
+ * Run with the counters that are summed over worker threads.
+ */
+class Run : public G4Run
+{
+
+public:
+	Run();
+	~Run();
+
+	void Merge(const G4Run*);
+
+	enum KillReason {kEscaped, kTimeWindow, kReflections, kNumberOfKillReasons};
+
+	void	AddKilled(KillReason reason, G4long n = 1)	{killed[reason] += n;};
+	G4long	GetKilled(KillReason reason) const	{return killed[reason];};
+
+	void	AddPrimaries(G4long n)			{primaries += n;};
+	G4long	GetPrimaries() const			{return primaries;};
+
+	//Channel timing (TimingRecorder)
+	void	AddReadouts(G4long n)			{readouts += n;};
+	void	AddLeadingEdge(G4double t)		{edges++; sumLE += t; sumLE2 += t*t;};
+	void	AddLatePhotons(G4long n)		{latePhotons += n;};
+	G4long	GetReadouts() const			{return readouts;};
+	G4long	GetLeadingEdges() const			{return edges;};
+	G4double GetLeadingEdgeSum() const		{return sumLE;};
+	G4double GetLeadingEdgeSum2() const		{return sumLE2;};
+	G4long	GetLatePhotons() const			{return latePhotons;};
+
+	//Deposit file (DepositRecorder)
+	void	AddDeposits(G4long n)			{deposits += n; depositEvents++;};
+	G4long	GetDeposits() const			{return deposits;};
+	G4long	GetDepositEvents() const		{return depositEvents;};
+
+	//Track stack (StackLimiter): peaks over all events, spilled photons summed
+	void	AddStackPeak(G4long depth, G4double bytes)	{stackPeakDepth = std::max(stackPeakDepth, depth); stackPeakBytes = std::max(stackPeakBytes, bytes);};
+	void	AddSpilled(G4long n)			{spilled += n; if(n > 0) spilledEvents++;};
+	G4long	GetStackPeakDepth() const		{return stackPeakDepth;};
+	G4double GetStackPeakBytes() const		{return stackPeakBytes;};
+	G4long	GetSpilled() const			{return spilled;};
+	G4long	GetSpilledEvents() const		{return spilledEvents;};
+
+	//Forced interaction efficiency (BiasingMonitor)
+	BiasingMonitor::Sums&	GetBiasingSums()		{return biasing;};
+	const BiasingMonitor::Sums& GetBiasingSums() const	{return biasing;};
+
+	//Memory samples (MemoryMonitor)
+	MemoryMonitor::Samples&	GetMemorySamples()		{return memory;};
+	const MemoryMonitor::Samples& GetMemorySamples() const	{return memory;};
+
+private:
+	G4long killed[kNumberOfKillReasons];
+	G4long primaries;
+
+	G4long readouts;
+	G4long edges;
+	G4double sumLE;
+	G4double sumLE2;
+	G4long latePhotons;
+
+	G4long deposits;
+	G4long depositEvents;
+
+	G4long stackPeakDepth;
+	G4double stackPeakBytes;
+	G4long spilled;
+	G4long spilledEvents;
+
+	BiasingMonitor::Sums biasing;
+	MemoryMonitor::Samples memory;
+};
+
+#endif
@@ -5,6 +5,17 @@
 #include "G4UserRunAction.hh"
 
 class G4Run;
+class G4Timer;
+class RunCheckpoint;
+class ConvergenceMonitor;
+class LiveMonitor;
+class SubEventScheduler;
+class MemoryMonitor;
+class StackLimiter;
+class BiasingMonitor;
+class DepositRecorder;
+class TimingRecorder;
+class RunActionMessenger;
 
 class RunAction : public G4UserRunAction
 {
@@ -12,9 +23,35 @@ public:
 	RunAction();
 	~RunAction();
 
+	G4Run* GenerateRun();
 	void BeginOfRunAction(const G4Run*);
 	void   EndOfRunAction(const G4Run*);
+
+	RunCheckpoint* GetCheckpoint() const	{return checkpoint;};
+	ConvergenceMonitor* GetConvergenceMonitor() const	{return convergence;};
+	LiveMonitor* GetLiveMonitor() const	{return liveMonitor;};
+	SubEventScheduler* GetSubEventScheduler() const	{return subEvents;};
+	MemoryMonitor* GetMemoryMonitor() const	{return memory;};
+	StackLimiter* GetStackLimiter() const	{return stackLimiter;};
+	BiasingMonitor* GetBiasingMonitor() const	{return biasing;};
+	DepositRecorder* GetDepositRecorder() const	{return deposits;};
+	TimingRecorder* GetTimingRecorder() const	{return timing;};
+	void SetFileName(const G4String& name)	{fileName = name;};
+	const G4String& GetFileName() const	{return fileName;};
+
+private:
+	RunActionMessenger* messenger;
+	G4String fileName;
+	G4Timer* timer;
+	RunCheckpoint* checkpoint;
+	ConvergenceMonitor* convergence;
+	LiveMonitor* liveMonitor;
+	SubEventScheduler* subEvents;
+	MemoryMonitor* memory;
+	StackLimiter* stackLimiter;
+	BiasingMonitor* biasing;
+	DepositRecorder* deposits;
+	TimingRecorder* timing;
 };
 
 #endif
-
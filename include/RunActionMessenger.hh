@@ -0,0 +1,28 @@
+#ifndef RunActionMessenger_h
+#define RunActionMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class RunAction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+
+class RunActionMessenger : public G4UImessenger
+{
+
+public:
+	RunActionMessenger(RunAction*);
+	~RunActionMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	RunAction* runAction;
+
+	G4UIdirectory*		outputDir;
+	G4UIcmdWithAString*	fileCmd;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RunCheckpoint_h
+#define RunCheckpoint_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <cstdio>
+#include <ctime>
+
+class G4Run;
+class RunCheckpointMessenger;
+
+/**
+ * Periodic checkpoints of a long run, and resume from the last one.
+ *
+ * While enabled, every ntuple row is also appended to a binary journal in
+ * the checkpoint directory. A checkpoint flushes the journal and writes
+ * the engine status, the next event ID, the journal length and the
+ * histogram contents. On resume the journal is replayed into the fresh
+ * output, the engine status restored and event IDs continue where they
+ * stopped, so the final output equals that of an uninterrupted run.
+ *
+ * Sequential mode only: under MT the worker event order is not
+ * reproducible and checkpointing is disabled.
+ */
+class RunCheckpoint
+{
+
+public:
+	RunCheckpoint();
+	~RunCheckpoint();
+
+	struct Row
+	{
+		G4int event;
+		G4int module;
+		G4int axis;
+		G4int channel;
+		G4int primary;
+		G4double weight;
+	};
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(G4int eventID);
+
+	inline void Record(G4int event, G4int module, G4int axis, G4int channel, G4int primary, G4double weight);
+
+	void	SetDirectory(const G4String& dir)	{directory = dir;};
+	const G4String& GetDirectory() const	{return directory;};
+	void	SetEveryEvents(G4int n)			{everyEvents = n;};
+	void	SetEveryMinutes(G4double m)		{everyMinutes = m;};
+	void	SetResume(G4bool value)			{resume = value;};
+
+	G4bool	IsActive() const			{return journal != 0;};
+
+private:
+	void	Write(G4int nextEvent);
+	void	Resume();
+	void	FillRow(const Row&) const;
+	G4String Path(const G4String& name) const	{return directory + "/" + name;};
+
+	RunCheckpointMessenger* messenger;
+
+	G4String directory;
+	G4int everyEvents;
+	G4double everyMinutes;
+	G4bool resume;
+
+	std::FILE* journal;
+	std::vector<Row> pending;
+	//Event IDs of the run are firstEvent .. firstEvent + totalEvents - 1
+	G4int firstEvent;
+	G4int totalEvents;
+	G4int lastEvent;
+	std::time_t lastTime;
+};
+
+inline void RunCheckpoint::Record(G4int event, G4int module, G4int axis, G4int channel, G4int primary, G4double weight)
+{
+
+	Row row = {event, module, axis, channel, primary, weight};
+	pending.push_back(row);
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RunCheckpointMessenger_h
+#define RunCheckpointMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class RunCheckpoint;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+
+class RunCheckpointMessenger : public G4UImessenger
+{
+
+public:
+	RunCheckpointMessenger(RunCheckpoint*);
+	~RunCheckpointMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	RunCheckpoint* checkpoint;
+
+	G4UIdirectory*		checkpointDir;
+	G4UIcmdWithAString*	directoryCmd;
+	G4UIcmdWithAnInteger*	eventsCmd;
+	G4UIcmdWithADouble*	minutesCmd;
+	G4UIcmdWithABool*	resumeCmd;
+};
+
+#endif
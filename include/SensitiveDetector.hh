@@ -17,11 +17,11 @@ public:
   
 	void	Initialize(G4HCofThisEvent*);
 	G4bool	ProcessHits(G4Step*, G4TouchableHistory*);
-	void	EndOfEvent(G4HCofThisEvent*);
 
 private:
 	G4StepPoint* point;
 	HitsCollection* hitsCollection;	
+	G4int hcID;
 	G4double energy;
 	G4ThreeVector pos;
 	G4double eDep;
@@ -0,0 +1,95 @@
+#ifndef StackLimiter_h
+#define StackLimiter_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4Run;
+class Run;
+class G4Track;
+class G4VProcess;
+class G4StackManager;
+class StackLimiterMessenger;
+
+/**
+ * Keeps the track stack of an event under a memory cap.
+ *
+ * Scintillation and Cerenkov track their secondaries first, so a GeV
+ * shower can stack millions of optical photons at once. Once the stacked
+ * tracks would take more than the cap, new optical photons are not stacked
+ * but spilled as compact records, kept in memory or written to a scratch
+ * file. When the stack runs dry (NewStage) they are pushed back in batches
+ * that fill it up to the cap again, oldest first, until none is left.
+ *
+ * The peak stack depth and its estimated memory are followed per event,
+ * printed per event on request and folded into the Run, which keeps the
+ * peaks and spilled photons of all threads for the end of run summary.
+ */
+class StackLimiter
+{
+
+public:
+	StackLimiter();
+	~StackLimiter();
+
+	void	EndOfRun(const G4Run*);
+	void	BeginOfEvent();
+	void	EndOfEvent(G4int eventID, Run*);
+
+	//True if the track was spilled, the caller kills it
+	G4bool	Spill(const G4Track*, G4StackManager*);
+	//Refills the stack once it is empty
+	void	Reload(G4StackManager*);
+
+	void	SetMemoryCap(G4double bytes);
+	void	SetSpillToDisk(G4bool value)		{spillToDisk = value;};
+	void	SetSpillDirectory(const G4String& dir)	{spillDirectory = dir;};
+	void	SetReport(G4bool value)			{report = value;};
+
+	//Memory held by one stacked track
+	static G4double TrackBytes();
+
+private:
+	struct Record
+	{
+		G4ThreeVector position;
+		G4ThreeVector direction;
+		G4ThreeVector polarization;
+		G4double energy;
+		G4double time;
+		G4double weight;
+		G4int trackID;
+		G4int parentID;
+		const G4VProcess* creator;
+	};
+
+	G4long	Pending() const;
+	G4bool	OpenFile();
+	void	FlushBuffer();
+	G4long	ReadFile(std::vector<Record>&, G4long max);
+	void	Push(const Record&, G4StackManager*);
+
+	StackLimiterMessenger* messenger;
+	G4double memoryCap;
+	G4long capTracks;
+	G4bool spillToDisk;
+	G4String spillDirectory;
+	G4bool report;
+
+	//Spilled photons: the file holds the oldest ones
+	std::vector<Record> buffer;
+	std::size_t readIndex;
+	int fd;
+	G4long fileRead;
+	G4long fileWritten;
+	G4bool reloading;
+
+	//This event
+	G4long peakDepth;
+	G4double peakBytes;
+	G4long spilled;
+};
+
+#endif
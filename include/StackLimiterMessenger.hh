@@ -0,0 +1,33 @@
+#ifndef StackLimiterMessenger_h
+#define StackLimiterMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class StackLimiter;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithABool;
+
+class StackLimiterMessenger : public G4UImessenger
+{
+
+public:
+	StackLimiterMessenger(StackLimiter*);
+	~StackLimiterMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	StackLimiter* limiter;
+
+	G4UIdirectory*		stackDir;
+	G4UIcmdWithADouble*	memoryCapCmd;
+	G4UIcmdWithAString*	spillCmd;
+	G4UIcmdWithAString*	spillDirectoryCmd;
+	G4UIcmdWithABool*	reportCmd;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef StackingAction_h
+#define StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class RunAction;
+
+/**
+ * Hands the optical photons of an event to the SubEventScheduler when
+ * batched tracking is enabled, and otherwise keeps the stack under the
+ * memory cap of the StackLimiter.
+ */
+class StackingAction : public G4UserStackingAction
+{
+
+public:
+	StackingAction(RunAction*);
+	~StackingAction();
+
+	G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*);
+	void NewStage();
+	void PrepareNewEvent();
+
+private:
+	RunAction* runAction;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef StartupTimer_h
+#define StartupTimer_h 1
+
+#include "globals.hh"
+
+/**
+ * Wall clock since the start of main(), used to report the
+ * initialization time and the time to the first event.
+ */
+class StartupTimer
+{
+
+public:
+	static void	Start();
+	static G4double	Elapsed();
+
+	//Reports the time to first event, once per process
+	static void	FirstEvent();
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef SteppingAction_h
+#define SteppingAction_h 1
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <set>
+
+class SteppingActionMessenger;
+class G4OpBoundaryProcess;
+class Run;
+class RunAction;
+struct PhotonBatch;
+
+/**
+ * Termination policies for optical photons.
+ *
+ * A photon is killed when it enters one of the escape volumes (e.g. the
+ * air of World and Detector, where it can never reach a fiber), when its
+ * global time leaves the time window, or when it has been reflected more
+ * than the allowed number of times at optical boundaries. Every policy is
+ * off by default; kills are counted per reason in the Run.
+ *
+ * Energy deposits in the crystals are handed to the DepositRecorder
+ * while it records.
+ */
+class SteppingAction : public G4UserSteppingAction
+{
+
+public:
+	SteppingAction(RunAction*);
+	~SteppingAction();
+
+	void UserSteppingAction(const G4Step*);
+
+	void	AddEscapeVolume(const G4String& name)	{escapeVolumes.insert(name);};
+	void	ClearEscapeVolumes()			{escapeVolumes.clear();};
+	void	SetTimeWindow(G4double t)		{timeWindow = t;};
+	void	SetMaxReflections(G4int n)		{maxReflections = n;};
+
+private:
+	G4OpBoundaryProcess* FindBoundaryProcess() const;
+	void	Kill(Run*, PhotonBatch*, G4int reason) const;
+
+	SteppingActionMessenger* messenger;
+	RunAction* runAction;
+
+	std::set<G4String> escapeVolumes;
+	G4double timeWindow;
+	G4int maxReflections;
+
+	G4OpBoundaryProcess* boundary;
+	G4int nReflections;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SteppingActionMessenger_h
+#define SteppingActionMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class SteppingAction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+
+class SteppingActionMessenger : public G4UImessenger
+{
+
+public:
+	SteppingActionMessenger(SteppingAction*);
+	~SteppingActionMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	SteppingAction* steppingAction;
+
+	G4UIdirectory*			policyDir;
+	G4UIcmdWithAString*		escapeCmd;
+	G4UIcmdWithoutParameter*	clearEscapeCmd;
+	G4UIcmdWithADoubleAndUnit*	timeWindowCmd;
+	G4UIcmdWithAnInteger*		reflectionsCmd;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SubEventMessenger_h
+#define SubEventMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class SubEventScheduler;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+
+class SubEventMessenger : public G4UImessenger
+{
+
+public:
+	SubEventMessenger(SubEventScheduler*);
+	~SubEventMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	SubEventScheduler* scheduler;
+
+	G4UIdirectory*		subEventDir;
+	G4UIcmdWithAnInteger*	batchSizeCmd;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SubEventScheduler_h
+#define SubEventScheduler_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "Hits.hh"
+#include "EventArena.hh"
+#include "Run.hh"
+
+#include <vector>
+#include <atomic>
+
+class G4Track;
+class SubEventMessenger;
+namespace CLHEP { class HepRandomEngine; }
+
+/**
+ * Optical photons of one event, tracked as a unit with their own seed.
+ */
+struct PhotonBatch
+{
+	PhotonBatch();
+
+	struct Photon
+	{
+		G4ThreeVector position;
+		G4ThreeVector direction;
+		G4ThreeVector polarization;
+		G4double energy;
+		G4double time;
+		G4double weight;
+		G4int trackID;
+		G4int parentID;
+		G4int primary;
+	};
+
+	long seed;
+	//Reserved once by the owner, from its event arena
+	std::vector<Photon, ArenaAllocator<Photon> > photons;
+
+	//Results, read by the owner once done is set
+	std::vector<Hits> hits;
+	G4long tracked;
+	G4long killed[Run::kNumberOfKillReasons];
+	G4int currentPrimary;
+	std::atomic<bool> done;
+};
+
+/**
+ * Sub-event parallelism for the optical photons of large events.
+ *
+ * While enabled, the StackingAction hands every optical photon to the
+ * scheduler instead of the stack. Photons are cut into batches of a fixed
+ * size, each seeded from the event's random stream and its batch index.
+ * Full batches are queued on the owning thread's deque right away: the
+ * owner pops from the back, idle threads steal from the front, including
+ * workers that ran out of events and would otherwise wait for the run to
+ * end. Detected photons are recorded in the batch and turned into hits of
+ * the owning event in batch order once all of its batches are done, so for
+ * a given batch size and seed the event result does not depend on which
+ * thread tracked what. It is not the result of unbatched tracking, which
+ * draws every photon from the event's single stream: the two agree only
+ * statistically, see tools/validate_subevents.sh.
+ *
+ * Batches stolen at the end of the run are tracked with no current event
+ * on the stealing thread. Code reached from Track() takes the event it
+ * works for from CurrentBatch(), never from the event or run manager.
+ *
+ * One instance per thread, owned by the RunAction.
+ */
+class SubEventScheduler
+{
+
+public:
+	SubEventScheduler();
+	~SubEventScheduler();
+
+	void	SetBatchSize(G4int n)			{batchSize = n;};
+	G4bool	IsEnabled() const			{return batchSize > 0;};
+
+	void	BeginOfRun();
+	void	EndOfRun();
+	void	BeginOfEvent();
+
+	//Takes over an optical photon of the current event
+	void	Divert(const G4Track*, G4int primary);
+
+	//Tracks the event's batches (helped by idle threads) and adds the
+	//detected photons to its hits. Returns the photons tracked.
+	G4long	FinishEvent(HitsCollection*, Run*);
+
+	//Batch tracked on this thread right now, 0 outside batches
+	static PhotonBatch* CurrentBatch();
+
+	//Batches queued by one thread
+	struct Deque;
+
+private:
+	void	Queue(PhotonBatch*);
+	PhotonBatch* PopOwn();
+	static PhotonBatch* Steal();
+	void	Track(PhotonBatch*);
+
+	SubEventMessenger* messenger;
+	G4int batchSize;
+	G4bool registered;
+
+	std::vector<PhotonBatch*> eventBatches;
+	PhotonBatch* open;
+	G4bool seeded;
+	unsigned long long eventKey;
+
+	Deque* deque;
+	CLHEP::HepRandomEngine* engine;
+};
+
+#endif
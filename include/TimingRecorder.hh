@@ -0,0 +1,84 @@
+#ifndef TimingRecorder_h
+#define TimingRecorder_h 1
+
+#include "globals.hh"
+#include "Hits.hh"
+#include "DetectorParameters.hh"
+
+#include <vector>
+
+class G4Run;
+class Run;
+class G4Event;
+class TimingRecorderMessenger;
+
+/**
+ * Photon arrival times per readout channel, reduced online to a timing
+ * summary instead of one row per photon.
+ *
+ * At the end of every event the hits of each channel are binned into a
+ * fixed-width time histogram over [0, window), or their first N arrival
+ * times are kept in order. From either the channel gets
+ *   first        earliest arrival
+ *   leadingEdge  time the cumulative photon count reaches the threshold,
+ *                interpolated within the bin in histogram mode
+ *   tot          time over threshold: how long the photons per bin stay
+ *                at or above totThreshold from their first crossing,
+ *                histogram mode only
+ * and one row of the "timing" ntuple. Leading edges also fill the
+ * Timing_LE histogram. Only channels that saw a photon are touched, so the
+ * cost follows the hits, not the number of channels. The readout and
+ * leading edge counts go to the Run, which merges them over the threads.
+ *
+ * One instance per thread, owned by the RunAction.
+ */
+class TimingRecorder
+{
+
+public:
+	TimingRecorder();
+	~TimingRecorder();
+
+	enum Mode {kHistogram, kFirstPhotons};
+
+	void	BeginOfRun(const G4Run*);
+	void	EndOfRun(const G4Run*);
+	void	EndOfEvent(const G4Event*, HitsCollection*, Run*);
+
+	void	SetEnabled(G4bool value)		{enabled = value;};
+	void	SetMode(Mode value)			{mode = value;};
+	void	SetBinWidth(G4double value)		{binWidth = value;};
+	void	SetWindow(G4double value)		{window = value;};
+	void	SetFirstPhotons(G4int n)		{firstPhotons = n > 0 ? n : 1;};
+	void	SetThreshold(G4double photons)		{threshold = photons;};
+	void	SetToTThreshold(G4double photons)	{totThreshold = photons;};
+
+	G4bool	IsActive() const			{return enabled;};
+
+private:
+	void	Summarize(G4int channel, G4double& photons, G4double& first, G4double& leadingEdge, G4double& tot) const;
+
+	TimingRecorderMessenger* messenger;
+	G4bool enabled;
+	Mode mode;
+	G4double binWidth;
+	G4double window;
+	G4int firstPhotons;
+	G4double threshold;
+	G4double totThreshold;
+
+	//Of the run, by global channel ID
+	G4int nBins;
+	G4int nKept;
+	G4int ntupleID;
+	G4int histoID;
+	std::vector<G4float> bins;		//nBins per channel
+	std::vector<G4double> times;		//nKept per channel, ascending
+	std::vector<G4int> kept;
+	std::vector<G4int> counts;
+	std::vector<G4double> photons;		//weighted
+	std::vector<G4double> earliest;
+	std::vector<G4int> touched;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TimingRecorderMessenger_h
+#define TimingRecorderMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class TimingRecorder;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+
+class TimingRecorderMessenger : public G4UImessenger
+{
+
+public:
+	TimingRecorderMessenger(TimingRecorder*);
+	~TimingRecorderMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	TimingRecorder* recorder;
+
+	G4UIdirectory*			timingDir;
+	G4UIcmdWithABool*		enableCmd;
+	G4UIcmdWithAString*		modeCmd;
+	G4UIcmdWithADoubleAndUnit*	binWidthCmd;
+	G4UIcmdWithADoubleAndUnit*	windowCmd;
+	G4UIcmdWithAnInteger*		firstPhotonsCmd;
+	G4UIcmdWithADouble*		thresholdCmd;
+	G4UIcmdWithADouble*		totThresholdCmd;
+};
+
+#endif
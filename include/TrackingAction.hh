@@ -0,0 +1,69 @@
+#ifndef TrackingAction_h
+#define TrackingAction_h 1
+
+#include "G4UserTrackingAction.hh"
+#include "globals.hh"
+
+#include <vector>
+#include <set>
+
+class TrackingActionMessenger;
+
+/**
+ * Follows which primary each track descends from.
+ *
+ * Track IDs are dense within an event and a parent is always started
+ * before its secondaries, so a flat table indexed by track ID is enough;
+ * no per-track user information is allocated.
+ *
+ * Also decides which trajectories are stored, before they reach the
+ * event: only the listed particle types, one optical photon in N, only
+ * photons detected in RO_X/RO_Y, and at most a number of points per
+ * trajectory. Thinned trajectories are plain ones, whatever the
+ * /tracking/storeTrajectory mode. Every filter is off by default.
+ */
+class TrackingAction : public G4UserTrackingAction
+{
+
+public:
+	TrackingAction();
+	~TrackingAction();
+
+	void PreUserTrackingAction(const G4Track*);
+	void PostUserTrackingAction(const G4Track*);
+
+	G4int getCurrentPrimary() const		{return currentPrimary;};
+	G4int getOpticalPhotons() const		{return opticalPhotons;};
+	//Largest track ID of the event so far, for tracks made outside the stack
+	G4int getLastTrackID() const		{return lastTrackID;};
+
+	//Trajectory storage policy
+	void	AddTrajectoryParticle(const G4String& name)	{trajectoryParticles.insert(name);};
+	void	ClearTrajectoryParticles()			{trajectoryParticles.clear();};
+	void	SetPhotonSampling(G4int n)			{photonSampling = n;};
+	void	SetDetectedOnly(G4bool value)			{detectedOnly = value;};
+	void	SetMaxTrajectoryPoints(G4int n)			{maxPoints = n;};
+
+private:
+	void	SelectTrajectory(const G4Track*);
+	G4bool	FiltersTrajectories() const;
+
+	TrackingActionMessenger* messenger;
+
+	std::vector<G4int> primaryOfTrack;
+	G4int currentPrimary;
+	G4int opticalPhotons;
+	G4int lastTrackID;
+
+	std::set<G4String> trajectoryParticles;
+	G4int photonSampling;
+	G4bool detectedOnly;
+	G4int maxPoints;
+
+	//User storage mode, and whether this track's was turned off here
+	G4int storeMode;
+	G4bool suppressed;
+	G4int photonSerial;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TrackingActionMessenger_h
+#define TrackingActionMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class TrackingAction;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithABool;
+
+class TrackingActionMessenger : public G4UImessenger
+{
+
+public:
+	TrackingActionMessenger(TrackingAction*);
+	~TrackingActionMessenger();
+
+	void SetNewValue(G4UIcommand*, G4String);
+
+private:
+	TrackingAction* trackingAction;
+
+	G4UIdirectory*			trajectoryDir;
+	G4UIcmdWithAString*		particleCmd;
+	G4UIcmdWithoutParameter*	clearParticlesCmd;
+	G4UIcmdWithAnInteger*		samplingCmd;
+	G4UIcmdWithABool*		detectedOnlyCmd;
+	G4UIcmdWithAnInteger*		maxPointsCmd;
+};
+
+#endif
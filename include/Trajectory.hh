@@ -0,0 +1,80 @@
+#ifndef Trajectory_h
+#define Trajectory_h 1
+
+#include "G4VTrajectory.hh"
+#include "G4TrajectoryPoint.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Allocator.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4Track;
+
+/**
+ * Trajectory holding at most maxPoints points.
+ *
+ * Points are kept every stride steps; when the buffer is full every other
+ * point is dropped and the stride doubles, so the points stay evenly
+ * spread along the track whatever its length. The vertex and the last
+ * position are always kept; the last one is a plain position until it is
+ * kept or the points are read.
+ */
+class Trajectory : public G4VTrajectory
+{
+
+public:
+	Trajectory(const G4Track*, G4int maxPoints);
+	~Trajectory();
+
+	inline void* operator new(size_t);
+	inline void  operator delete(void*);
+
+	G4int		GetTrackID() const		{return trackID;};
+	G4int		GetParentID() const		{return parentID;};
+	G4String	GetParticleName() const		{return particle->GetParticleName();};
+	G4double	GetCharge() const		{return particle->GetPDGCharge();};
+	G4int		GetPDGEncoding() const		{return particle->GetPDGEncoding();};
+	G4ThreeVector	GetInitialMomentum() const	{return initialMomentum;};
+
+	G4int		GetPointEntries() const		{return points.size() + (hasTail ? 1 : 0);};
+	G4VTrajectoryPoint* GetPoint(G4int i) const	{return i < (G4int)points.size() ? points[i] : TailPoint();};
+
+	void	AppendStep(const G4Step*);
+	void	MergeTrajectory(G4VTrajectory*);
+
+private:
+	void	Keep(const G4ThreeVector&);
+	void	Decimate();
+	G4TrajectoryPoint* TailPoint() const;
+
+	G4int trackID;
+	G4int parentID;
+	const G4ParticleDefinition* particle;
+	G4ThreeVector initialMomentum;
+
+	G4int maxPoints;
+	G4int stride;
+	G4int sinceKept;
+	std::vector<G4TrajectoryPoint*> points;
+	//Latest position, until it is kept
+	G4ThreeVector tail;
+	G4bool hasTail;
+	//Made of the tail when it is read
+	mutable G4TrajectoryPoint* tailPoint;
+};
+
+extern G4ThreadLocal G4Allocator<Trajectory>* TrajectoryAllocator;
+
+inline void* Trajectory::operator new(size_t){
+
+	if(!TrajectoryAllocator) TrajectoryAllocator = new G4Allocator<Trajectory>;
+	return (void*)TrajectoryAllocator->MallocSingle();
+}
+
+inline void Trajectory::operator delete(void* trajectory){
+
+	TrajectoryAllocator->FreeSingle((Trajectory*)trajectory);
+}
+
+#endif
@@ -1,79 +1,221 @@
 
 #include "globals.hh"
 #include "DetectorConstruction.hh"
+#include "DetectorParameters.hh"
 #include "PhysicsList.hh"
-#include "PrimaryGeneratorAction.hh"
-#include "RunAction.hh"
+#include "ActionInitialization.hh"
+#include "StartupTimer.hh"
+#include "ForkLauncher.hh"
 
 #include "G4RunManager.hh"
 #include "G4UImanager.hh"
 #include "Randomize.hh"
 #include <time.h>
+#include <cstdlib>
+#include <sstream>
 
-#ifdef G4VIS_USE
-#include "G4VisExecutive.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
 #endif
 
-#ifdef G4UI_USE
+#ifdef MATRIX_UIVIS
+#include "G4VisExecutive.hh"
 #include "G4UIExecutive.hh"
 #endif
 
+namespace {
+
+	void PrintUsage()
+	{
+		G4cerr<<"Usage: matrix [options] [macro]"<<G4endl
+		      <<"  -m, --macro <file>     macro to execute (batch mode)"<<G4endl
+		      <<"  -n, --events <N>       run N events after the macro"<<G4endl
+		      <<"  -t, --threads <N>      worker threads (MT builds of Geant4)"<<G4endl
+		      <<"      --fork <N>         run the events in N forked processes"<<G4endl
+		      <<"  -s, --seed <S>         random seed (default: time)"<<G4endl
+		      <<"  -o, --output <name>    output file, without extension"<<G4endl
+		      <<"  -g, --gdml <file>      read the geometry from GDML"<<G4endl
+		      <<"  -f, --force-interaction force the gamma to interact in the crystals"<<G4endl
+#ifdef MATRIX_RUNTIME_ARRAY
+		      <<"  -a, --array <N>        N x N crystals (default "<<MATRIX_ARRAY<<")"<<G4endl
+#endif
+		      <<"      --modules NX[xNY]  plane of NX x NY modules (default 1)"<<G4endl
+		      <<"  -v, --verbose <level>  /control, /run and /event verbosity"<<G4endl
+		      <<"  -i, --interactive      open the UI session even with a macro"<<G4endl
+		      <<"      --resume           continue from the last checkpoint"<<G4endl
+		      <<"  -h, --help             this message"<<G4endl
+		      <<"Without macro and events, an interactive session with vis.mac is started."<<G4endl;
+	}
 
+}
 
 int main(int argc,char** argv){
 
-	G4Random::setTheEngine(new CLHEP::RanecuEngine);
+	StartupTimer::Start();
+
+	G4String macro = "";
+	G4String output = "";
+	G4String gdml = "";
+	G4int nEvents = -1;
+	G4int nThreads = 1;
 	G4long seed = time(0);
+	G4int verbose = -1;
+	G4bool interactive = false;
+	G4bool resume = false;
+	G4bool forceInteraction = false;
+	G4int array = 0;
+	G4int modulesX = 1, modulesY = 1;
+	G4int nWorkers = 0;
+
+	for(G4int i = 1; i < argc; i++){
+		G4String arg = argv[i];
+		G4bool hasValue = (i + 1 < argc);
+		if(arg == "-h" || arg == "--help"){ PrintUsage(); return 0; }
+		else if(arg == "-i" || arg == "--interactive") interactive = true;
+		else if(arg == "--resume") resume = true;
+		else if(arg == "-f" || arg == "--force-interaction") forceInteraction = true;
+		else if((arg == "-m" || arg == "--macro") && hasValue) macro = argv[++i];
+		else if((arg == "-n" || arg == "--events") && hasValue) nEvents = std::atoi(argv[++i]);
+		else if(arg == "--fork" && hasValue) nWorkers = std::atoi(argv[++i]);
+		else if((arg == "-t" || arg == "--threads") && hasValue) nThreads = std::atoi(argv[++i]);
+		else if((arg == "-s" || arg == "--seed") && hasValue) seed = std::atol(argv[++i]);
+		else if((arg == "-o" || arg == "--output") && hasValue) output = argv[++i];
+		else if((arg == "-g" || arg == "--gdml") && hasValue) gdml = argv[++i];
+		else if((arg == "-a" || arg == "--array") && hasValue) array = std::atoi(argv[++i]);
+		else if(arg == "--modules" && hasValue){
+			//8 or 8x4
+			const char* tiling = argv[++i];
+			char* end;
+			modulesX = std::strtol(tiling, &end, 10);
+			modulesY = (*end == 'x') ? std::strtol(end + 1, &end, 10) : modulesX;
+			if(*end != '\0' || modulesX <= 0 || modulesY <= 0){
+				G4cerr<<"--modules needs NX or NXxNY, at least one module per side, not "<<tiling<<G4endl;
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if((arg == "-v" || arg == "--verbose") && hasValue) verbose = std::atoi(argv[++i]);
+		else if(arg[0] != '-' && macro == "") macro = arg;
+		else{
+			G4cerr<<"Unknown or incomplete option "<<arg<<G4endl;
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	//Array size and tiling are fixed before anything reads the dimensions
+	if(array){
+#ifdef MATRIX_RUNTIME_ARRAY
+		RuntimeMatrixParameters::SetArray(array, array);
+#else
+		G4cerr<<"matrix was built with a fixed "<<MATRIX_ARRAY<<"x"<<MATRIX_ARRAY
+		      <<" array (rebuild with WITH_RUNTIME_ARRAY=ON or MATRIX_ARRAY=<N>)"<<G4endl;
+		return 1;
+#endif
+	}
+	ModuleTiling::SetTiling(modulesX, modulesY);
+
+	//Forked workers run one batch run, sequentially each
+	if(nWorkers > 1){
+		if(nEvents <= 0 || resume || interactive){
+			G4cerr<<"--fork needs --events, in batch mode and without --resume"<<G4endl;
+			return 1;
+		}
+		nThreads = 1;
+	}
+
+	//UI and vis only exist in interactive sessions
+	if(macro == "" && nEvents < 0) interactive = true;
+#ifndef MATRIX_UIVIS
+	if(interactive){
+		G4cerr<<"matrix was built without UI and visualization (WITH_GEANT4_UIVIS=OFF)"<<G4endl;
+		if(macro == "" && nEvents < 0) return 1;
+		interactive = false;
+	}
+#endif
+
+#ifdef MATRIX_UIVIS
+	G4UIExecutive* ui = 0;
+	if(interactive) ui = new G4UIExecutive(argc,argv);
+#endif
+
+	G4Random::setTheEngine(new CLHEP::RanecuEngine);
 	G4Random::setTheSeed(seed);
 
+#ifdef G4MULTITHREADED
+	G4RunManager* runManager;
+	if(nThreads > 1){
+		G4MTRunManager* mtRunManager = new G4MTRunManager;
+		mtRunManager->SetNumberOfThreads(nThreads);
+		runManager = mtRunManager;
+	}
+	else runManager = new G4RunManager;
+#else
+	if(nThreads > 1) G4cerr<<"Geant4 built without multithreading, running sequentially"<<G4endl;
 	G4RunManager* runManager = new G4RunManager;
+#endif
 
 	PhysicsList* thePhysics = new PhysicsList();
+	thePhysics->SetForcedInteraction(forceInteraction);
 	runManager->SetUserInitialization(thePhysics);
 
 	DetectorConstruction* theDetector = new DetectorConstruction();
+	if(gdml != "") theDetector->SetGDMLFile(gdml);
+	theDetector->SetForcedInteraction(forceInteraction);
 	runManager->SetUserInitialization(theDetector);
-		
-	PrimaryGeneratorAction* theGenerator = new PrimaryGeneratorAction();
-	runManager->SetUserAction(theGenerator);
 
-	RunAction* runAction = new RunAction();
-	runManager->SetUserAction(runAction);
+	runManager->SetUserInitialization(new ActionInitialization());
+
+	// get the pointer to the User Interface manager
+	G4UImanager* UI = G4UImanager::GetUIpointer();
+
+	if(verbose >= 0){
+		std::ostringstream level;
+		level << verbose;
+		UI->ApplyCommand("/control/verbose " + level.str());
+		UI->ApplyCommand("/run/verbose " + level.str());
+		UI->ApplyCommand("/event/verbose " + level.str());
+	}
+
+	if(output != "") UI->ApplyCommand("/matrix/output/file " + output);
+
+	// continue an interrupted run from its last checkpoint
+	if(resume) UI->ApplyCommand("/matrix/checkpoint/resume true");
 
 	runManager->Initialize();
-     
-	// get the pointer to the User Interface manager 
-	G4UImanager* UI = G4UImanager::GetUIpointer();  
 
-	#ifdef G4VIS_USE
-	G4VisManager* visManager = new G4VisExecutive;
-	visManager->Initialize();
-	#endif
+	G4cout<<"Initialization done after "<<StartupTimer::Elapsed()<<" s"<<G4endl;
+
+#ifdef MATRIX_UIVIS
+	G4VisManager* visManager = 0;
+	if (ui)
+	{
+		visManager = new G4VisExecutive;
+		visManager->Initialize();
+	}
+#endif
 
-	if (argc!=1)   // batch mode  
-	{ 
+	if (macro != "")   // batch mode
+	{
 		G4String command = "/control/execute ";
-		G4String fileName = argv[1];
-		UI->ApplyCommand(command+fileName);  
+		UI->ApplyCommand(command+macro);
 	}
-    
-	else           // define visualization and UI terminal for interactive mode 
-	{ 
-	#ifdef G4UI_USE
-		G4UIExecutive * ui = new G4UIExecutive(argc,argv);      
-	#ifdef G4VIS_USE
-		UI->ApplyCommand("/control/execute vis.mac");       
-	#endif
+
+	G4int status = 0;
+	if (nWorkers > 1) status = ForkLauncher::Run(runManager, nWorkers, nEvents, seed);
+	else if (nEvents > 0) runManager->BeamOn(nEvents);
+
+#ifdef MATRIX_UIVIS
+	if (ui)           // define visualization and UI terminal for interactive mode
+	{
+		if (macro == "") UI->ApplyCommand("/control/execute vis.mac");
 		ui->SessionStart();
 		delete ui;
-	#endif
 	}
-	
-	#ifdef G4VIS_USE
 	delete visManager;
-	#endif     
+#endif
 
 	delete runManager;
 
-	return 0;
+	return status;
 }
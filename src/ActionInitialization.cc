@@ -0,0 +1,37 @@
+#include "ActionInitialization.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "TrackingAction.hh"
+#include "SteppingAction.hh"
+#include "StackingAction.hh"
+
+ActionInitialization::ActionInitialization()
+	: G4VUserActionInitialization()
+{}
+
+ActionInitialization::~ActionInitialization()
+{}
+
+void ActionInitialization::BuildForMaster() const
+{
+
+	//Merges the worker histograms and writes the output
+	SetUserAction(new RunAction());
+
+}
+
+void ActionInitialization::Build() const
+{
+
+	SetUserAction(new PrimaryGeneratorAction());
+
+	RunAction* runAction = new RunAction();
+	SetUserAction(runAction);
+
+	SetUserAction(new EventAction(runAction));
+	SetUserAction(new TrackingAction());
+	SetUserAction(new SteppingAction(runAction));
+	SetUserAction(new StackingAction(runAction));
+
+}
@@ -0,0 +1,74 @@
+#include "AliasTable.hh"
+
+AliasTable::AliasTable()
+{}
+
+AliasTable::~AliasTable()
+{}
+
+void AliasTable::Clear()
+{
+
+	probability.clear();
+	alias.clear();
+
+}
+
+void AliasTable::Build(const std::vector<G4double>& weights)
+{
+
+	Clear();
+
+	G4int n = weights.size();
+	G4double total = 0;
+	for(G4int i = 0; i < n; i++){
+		if(weights[i] < 0){
+			G4Exception("AliasTable::Build", "Alias001", FatalErrorInArgument,
+				    "Negative weight in sampling table");
+			return;
+		}
+		total += weights[i];
+	}
+	if(n == 0 || total <= 0){
+		G4Exception("AliasTable::Build", "Alias002", FatalErrorInArgument,
+			    "Sampling table has no positive weight");
+		return;
+	}
+
+	probability.resize(n);
+	alias.resize(n);
+
+	//Vose: scale to mean 1 and pair every short bin with a tall one
+	std::vector<G4int> small, large;
+	std::vector<G4double> scaled(n);
+	for(G4int i = 0; i < n; i++){
+		scaled[i] = weights[i]*n/total;
+		if(scaled[i] < 1.) small.push_back(i);
+		else large.push_back(i);
+	}
+
+	while(!small.empty() && !large.empty()){
+		G4int s = small.back(); small.pop_back();
+		G4int l = large.back(); large.pop_back();
+
+		probability[s] = scaled[s];
+		alias[s] = l;
+
+		scaled[l] = (scaled[l] + scaled[s]) - 1.;
+		if(scaled[l] < 1.) small.push_back(l);
+		else large.push_back(l);
+	}
+
+	//Leftovers are 1 up to rounding
+	while(!large.empty()){
+		probability[large.back()] = 1.;
+		alias[large.back()] = large.back();
+		large.pop_back();
+	}
+	while(!small.empty()){
+		probability[small.back()] = 1.;
+		alias[small.back()] = small.back();
+		small.pop_back();
+	}
+
+}
@@ -0,0 +1,113 @@
+#include "BiasingMonitor.hh"
+#include "Run.hh"
+
+#include "G4Threading.hh"
+#include "G4VBiasingOperator.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void BiasingMonitor::Sums::Clear()
+{
+	events = useful = analogUseful = 0;
+	score = score2 = analogScore2 = 0;
+	time = usefulTime = emptyTime = 0;
+	minTime = DBL_MAX;
+}
+
+void BiasingMonitor::Sums::Merge(const Sums& other)
+{
+	events += other.events;
+	useful += other.useful;
+	analogUseful += other.analogUseful;
+	score += other.score;
+	score2 += other.score2;
+	analogScore2 += other.analogScore2;
+	time += other.time;
+	usefulTime += other.usefulTime;
+	emptyTime += other.emptyTime;
+	minTime = std::min(minTime, other.minTime);
+}
+
+BiasingMonitor::BiasingMonitor()
+	: active(false)
+{}
+
+BiasingMonitor::~BiasingMonitor()
+{}
+
+void BiasingMonitor::BeginOfRun(const G4Run*)
+{
+
+	active = G4VBiasingOperator::GetBiasingOperators().size() > 0;
+
+}
+
+void BiasingMonitor::BeginOfEvent()
+{
+	if(active) eventStart = std::chrono::steady_clock::now();
+}
+
+void BiasingMonitor::EndOfEvent(HitsCollection* hits, Run* run)
+{
+
+	if(!active) return;
+
+	G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - eventStart).count();
+	G4int n = hits ? hits->entries() : 0;
+	G4double score = 0;
+	for(G4int i = 0; i < n; i++) score += (*hits)[i]->getWeight();
+
+	Sums& local = run->GetBiasingSums();
+	local.events++;
+	local.time += seconds;
+	local.minTime = std::min(local.minTime, seconds);
+	local.score += score;
+	local.score2 += score*score;
+	if(n > 0){
+		//Likelihood ratio of the event to analog: its mean photon weight
+		G4double weight = score/n;
+		local.useful++;
+		local.analogUseful += weight;
+		local.analogScore2 += weight*n*n;
+		local.usefulTime += seconds;
+	}
+	else local.emptyTime += seconds;
+
+}
+
+void BiasingMonitor::EndOfRun(const G4Run* run)
+{
+
+	//Reported once, from the run the workers were merged into
+	if(!active || !G4Threading::IsMasterThread()) return;
+
+	const Sums& total = static_cast<const Run*>(run)->GetBiasingSums();
+	if(total.events < 2) return;
+
+	G4double n = total.events;
+	G4double mean = total.score/n;
+	G4double biasedVariance = total.score2/n - mean*mean;
+	G4double analogVariance = total.analogScore2/n - mean*mean;
+	G4double biasedUseful = total.useful/n;
+	G4double analogUseful = total.analogUseful/n;
+
+	//Analog time per event: useful events cost what they cost here, empty
+	//ones at least as much as the cheapest event seen
+	G4double empty = n - total.useful;
+	G4double usefulTime = total.useful > 0 ? total.usefulTime/total.useful : 0;
+	G4double emptyTime = empty > 0 ? total.emptyTime/empty : total.minTime;
+	G4double biasedTime = total.time/n;
+	G4double analogTime = analogUseful*usefulTime + (1. - analogUseful)*emptyTime;
+
+	G4cout<<"Forced interaction: light yield "<<mean<<" +- "<<std::sqrt(std::max(biasedVariance, 0.)/n)
+	      <<" photons/event"<<G4endl
+	      <<"  useful events "<<100.*biasedUseful<<"% (analog "<<100.*analogUseful<<"%)"<<G4endl;
+	if(biasedUseful > 0 && analogUseful > 0)
+		G4cout<<"  time per useful event "<<biasedTime/biasedUseful<<" s (analog "<<analogTime/analogUseful<<" s)"<<G4endl;
+	if(biasedVariance > 0 && biasedTime > 0)
+		G4cout<<"  speedup of the light yield figure of merit "
+		      <<(analogVariance*analogTime)/(biasedVariance*biasedTime)<<G4endl;
+
+}
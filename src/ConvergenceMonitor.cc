@@ -0,0 +1,221 @@
+#include "ConvergenceMonitor.hh"
+#include "ConvergenceMonitorMessenger.hh"
+
+#include "G4Run.hh"
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <atomic>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+
+	//Totals shared by all threads of the run
+	G4Mutex sharedMutex = G4MUTEX_INITIALIZER;
+	std::vector<ConvergenceMonitor::Moments> shared;
+	std::atomic<bool> stopRequested(false);
+	std::chrono::steady_clock::time_point runStart;
+
+}
+
+void ConvergenceMonitor::Moments::Add(G4double x)
+{
+
+	n += 1;
+	G4double delta = x - mean;
+	mean += delta/n;
+	m2 += delta*(x - mean);
+
+}
+
+void ConvergenceMonitor::Moments::Merge(const Moments& other)
+{
+
+	if(other.n == 0) return;
+	G4double total = n + other.n;
+	G4double delta = other.mean - mean;
+	mean += delta*other.n/total;
+	m2 += other.m2 + delta*delta*n*other.n/total;
+	n = total;
+
+}
+
+G4double ConvergenceMonitor::Moments::RelativeError() const
+{
+
+	if(n < 2 || mean == 0) return DBL_MAX;
+	return std::sqrt(m2/(n - 1)/n)/std::fabs(mean);
+
+}
+
+ConvergenceMonitor::ConvergenceMonitor()
+	: messenger(0),
+	  target(0),
+	  timeBudget(0),
+	  checkEvery(1000),
+	  minEvents(1000),
+	  channelFraction(0.05),
+	  useChannels(true),
+	  useLightYield(true),
+	  useEfficiency(false),
+	  nChannels(0),
+	  sinceCheck(0),
+	  aborted(false)
+{
+	nChannels = ModuleTiling::NumberOfChannels();
+	messenger = new ConvergenceMonitorMessenger(this);
+}
+
+ConvergenceMonitor::~ConvergenceMonitor()
+{
+	delete messenger;
+}
+
+void ConvergenceMonitor::SetObservable(const G4String& name, G4bool enable)
+{
+
+	if(name == "channels" || name == "all") useChannels = enable;
+	if(name == "lightYield" || name == "all") useLightYield = enable;
+	if(name == "efficiency" || name == "all") useEfficiency = enable;
+
+}
+
+void ConvergenceMonitor::BeginOfRun(const G4Run*)
+{
+
+	//Channels, then light yield and efficiency
+	local.assign(nChannels + 2, Moments());
+	for(std::size_t i = 0; i < local.size(); i++) local[i].Clear();
+	counts.assign(nChannels, 0.);
+	sinceCheck = 0;
+	aborted = false;
+
+	//The master (or the only thread) starts before any worker
+	if(G4Threading::IsMasterThread()){
+		G4AutoLock lock(&sharedMutex);
+		shared = local;
+		stopRequested = false;
+		runStart = std::chrono::steady_clock::now();
+	}
+
+}
+
+void ConvergenceMonitor::EndOfEvent(const G4Event* event, HitsCollection* hits)
+{
+
+	if(!IsActive()) return;
+
+	std::fill(counts.begin(), counts.end(), 0.);
+	//Photons count with their weight when biasing is on
+	G4int nHits = hits ? hits->entries() : 0;
+	G4double yield = 0;
+	for(G4int i = 0; i < nHits; i++){
+		Hits* hit = (*hits)[i];
+		yield += hit->getWeight();
+		G4int index = ModuleTiling::ChannelID(hit->getModule(), hit->getAxis(), hit->getChannel());
+		if(hit->getAxis() > 0 && index >= 0 && index < nChannels) counts[index] += hit->getWeight();
+	}
+
+	for(G4int i = 0; i < nChannels; i++) local[i].Add(counts[i]);
+	local[nChannels].Add(yield);
+
+	if(useEfficiency){
+		//Brightest channel of each axis, over all modules, against the
+		//crystal below the vertex
+		G4int bestX = 0, bestY = nx;
+		for(G4int i = 0; i < nChannels; i++){
+			G4int& best = (i%(nx + ny) < nx) ? bestX : bestY;
+			if(counts[i] > counts[best]) best = i;
+		}
+		G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+		G4int module, trueX, trueY;
+		G4bool found = false;
+		if(vertex && nHits > 0 && ModuleTiling::Locate(vertex->GetX0(), vertex->GetY0(), module, trueX, trueY))
+			found = (bestX == ModuleTiling::ChannelID(module, 1, trueX) && bestY == ModuleTiling::ChannelID(module, 2, trueY));
+		local[nChannels + 1].Add(found ? 1. : 0.);
+	}
+
+	if(++sinceCheck >= checkEvery) Publish();
+
+	if(!aborted && stopRequested.load(std::memory_order_relaxed)){
+		aborted = true;
+		G4RunManager::GetRunManager()->AbortRun(true);
+	}
+
+}
+
+void ConvergenceMonitor::EndOfRun(const G4Run* run)
+{
+
+	if(!IsActive()) return;
+
+	//Workers hand in their last events before the master reports
+	if(!G4Threading::IsMasterThread() || !G4Threading::IsMultithreadedApplication()) Publish();
+	if(!G4Threading::IsMasterThread()) return;
+
+	G4AutoLock lock(&sharedMutex);
+	G4double worst = 0;
+	G4bool converged = Converged(worst);
+	G4double minutes = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - runStart).count()/60.;
+	G4cout<<"Convergence: "<<run->GetNumberOfEvent()<<" events, worst relative error "<<worst
+	      <<(converged ? " (target reached)" : " (target not reached)")<<" after "<<minutes<<" min"<<G4endl;
+	if(useLightYield && shared.size() > (std::size_t)nChannels)
+		G4cout<<"  light yield "<<shared[nChannels].mean<<" photons/event"<<G4endl;
+	if(useEfficiency && shared.size() > (std::size_t)nChannels + 1)
+		G4cout<<"  crystal identification efficiency "<<shared[nChannels + 1].mean<<G4endl;
+
+}
+
+void ConvergenceMonitor::Publish()
+{
+
+	G4AutoLock lock(&sharedMutex);
+
+	for(std::size_t i = 0; i < local.size(); i++){
+		shared[i].Merge(local[i]);
+		local[i].Clear();
+	}
+	sinceCheck = 0;
+
+	if(stopRequested) return;
+
+	G4double worst = 0;
+	G4bool converged = Converged(worst);
+	G4double elapsed = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - runStart).count();
+	if(converged){
+		G4cout<<"Target precision "<<target<<" reached after "<<(G4long)shared[nChannels].n<<" events"<<G4endl;
+		stopRequested = true;
+	}
+	else if(timeBudget > 0 && elapsed >= 60.*timeBudget){
+		G4cout<<"Time budget spent after "<<(G4long)shared[nChannels].n<<" events, relative error "<<worst<<G4endl;
+		stopRequested = true;
+	}
+
+}
+
+G4bool ConvergenceMonitor::Converged(G4double& worst) const
+{
+
+	//Called with the shared totals locked
+	worst = 0;
+	if(shared.size() < (std::size_t)nChannels + 2) return false;
+
+	if(useChannels){
+		G4double largest = 0;
+		for(G4int i = 0; i < nChannels; i++) largest = std::max(largest, shared[i].mean);
+		for(G4int i = 0; i < nChannels; i++)
+			if(largest > 0 && shared[i].mean >= channelFraction*largest)
+				worst = std::max(worst, shared[i].RelativeError());
+	}
+	if(useLightYield) worst = std::max(worst, shared[nChannels].RelativeError());
+	if(useEfficiency) worst = std::max(worst, shared[nChannels + 1].RelativeError());
+
+	return target > 0 && shared[nChannels].n >= minEvents && worst <= target;
+
+}
@@ -0,0 +1,101 @@
+#include "ConvergenceMonitorMessenger.hh"
+#include "ConvergenceMonitor.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+
+#include <sstream>
+
+ConvergenceMonitorMessenger::ConvergenceMonitorMessenger(ConvergenceMonitor* mon)
+	: G4UImessenger(),
+	  monitor(mon)
+{
+
+	convergenceDir = new G4UIdirectory("/matrix/convergence/");
+	convergenceDir->SetGuidance("Stop runs at a target statistical precision.");
+
+	targetCmd = new G4UIcmdWithADouble("/matrix/convergence/target", this);
+	targetCmd->SetGuidance("Relative uncertainty of the observables to stop at, 0 disables it.");
+	targetCmd->SetGuidance("Use a large /run/beamOn as upper limit.");
+	targetCmd->SetParameterName("precision", false);
+	targetCmd->SetRange("precision>=0.");
+	targetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	budgetCmd = new G4UIcmdWithADouble("/matrix/convergence/timeBudget", this);
+	budgetCmd->SetGuidance("Stop after M minutes of wall time, 0 disables it.");
+	budgetCmd->SetParameterName("M", false);
+	budgetCmd->SetRange("M>=0.");
+	budgetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	checkEveryCmd = new G4UIcmdWithAnInteger("/matrix/convergence/checkEvery", this);
+	checkEveryCmd->SetGuidance("Events each thread simulates between two checks.");
+	checkEveryCmd->SetParameterName("N", false);
+	checkEveryCmd->SetRange("N>0");
+	checkEveryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	minEventsCmd = new G4UIcmdWithAnInteger("/matrix/convergence/minEvents", this);
+	minEventsCmd->SetGuidance("Never stop on precision before N events.");
+	minEventsCmd->SetParameterName("N", false);
+	minEventsCmd->SetRange("N>=0");
+	minEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	fractionCmd = new G4UIcmdWithADouble("/matrix/convergence/channelFraction", this);
+	fractionCmd->SetGuidance("Channels below this fraction of the brightest one are not checked.");
+	fractionCmd->SetParameterName("fraction", false);
+	fractionCmd->SetRange("fraction>=0. && fraction<=1.");
+	fractionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	observableCmd = new G4UIcommand("/matrix/convergence/observable", this);
+	observableCmd->SetGuidance("Enable or disable an observable of the stopping rule.");
+	G4UIparameter* name = new G4UIparameter("name", 's', false);
+	name->SetParameterCandidates("channels lightYield efficiency all");
+	observableCmd->SetParameter(name);
+	G4UIparameter* enable = new G4UIparameter("enable", 'b', true);
+	enable->SetDefaultValue("true");
+	observableCmd->SetParameter(enable);
+	observableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+ConvergenceMonitorMessenger::~ConvergenceMonitorMessenger()
+{
+
+	delete observableCmd;
+	delete fractionCmd;
+	delete minEventsCmd;
+	delete checkEveryCmd;
+	delete budgetCmd;
+	delete targetCmd;
+	delete convergenceDir;
+
+}
+
+void ConvergenceMonitorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == targetCmd)
+		monitor->SetTarget(targetCmd->GetNewDoubleValue(newValue));
+
+	else if(command == budgetCmd)
+		monitor->SetTimeBudget(budgetCmd->GetNewDoubleValue(newValue));
+
+	else if(command == checkEveryCmd)
+		monitor->SetCheckEvery(checkEveryCmd->GetNewIntValue(newValue));
+
+	else if(command == minEventsCmd)
+		monitor->SetMinEvents(minEventsCmd->GetNewIntValue(newValue));
+
+	else if(command == fractionCmd)
+		monitor->SetChannelFraction(fractionCmd->GetNewDoubleValue(newValue));
+
+	else if(command == observableCmd){
+		std::istringstream is(newValue);
+		G4String name, enable;
+		is >> name >> enable;
+		monitor->SetObservable(name, G4UIcommand::ConvertToBool(enable));
+	}
+
+}
@@ -0,0 +1,405 @@
+#include "CrystalPhotonModel.hh"
+#include "CrystalPhotonModelMessenger.hh"
+#include "SubEventScheduler.hh"
+#include "TrackingAction.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4Box.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalSurface.hh"
+#include "G4SurfaceProperty.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4DynamicParticle.hh"
+#include "G4Track.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4VTrajectory.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace {
+	G4ThreadLocal CrystalPhotonModel* instance = 0;
+
+	//Survivors start this far beyond the exit face, outside the envelope
+	const G4double exitGap = 1.e-6*mm;
+}
+
+CrystalPhotonModel::CrystalPhotonModel(const G4String& name, G4Region* region, const G4Material* exit)
+	: G4VFastSimulationModel(name, region),
+	  messenger(0),
+	  enabled(false),
+	  batchSize(4096),
+	  maxBounces(10000),
+	  exitMaterial(exit),
+	  crystalMaterial(0),
+	  reflectivity(0),
+	  crystalIndex(0),
+	  crystalAbsorption(0),
+	  exitIndex(0),
+	  surfaceRead(false),
+	  halfSize(0., 0., 0.),
+	  batchPrimary(0),
+	  traced(0),
+	  transmitted(0),
+	  absorbedBulk(0),
+	  absorbedPaint(0),
+	  capped(0),
+	  bounces(0),
+	  seconds(0)
+{
+	instance = this;
+	messenger = new CrystalPhotonModelMessenger(this);
+}
+
+CrystalPhotonModel::~CrystalPhotonModel()
+{
+	delete messenger;
+	if(instance == this) instance = 0;
+}
+
+CrystalPhotonModel* CrystalPhotonModel::GetInstance()
+{
+	return instance;
+}
+
+G4bool CrystalPhotonModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+	return &particle == G4OpticalPhoton::OpticalPhotonDefinition();
+}
+
+G4bool CrystalPhotonModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+
+	if(!enabled) return false;
+
+	//Sub-event batches are tracked in full, possibly on another thread
+	if(SubEventScheduler::CurrentBatch()) return false;
+
+	if(!surfaceRead && !ReadSurface()) return false;
+	if(fastTrack.GetAffineTransformation()->IsRotated()) return false;
+
+	const G4Box* box = dynamic_cast<const G4Box*>(fastTrack.GetEnvelopeSolid());
+	if(!box) return false;
+	G4ThreeVector size(box->GetXHalfLength(), box->GetYHalfLength(), box->GetZHalfLength());
+	if(x.empty()) halfSize = size;
+	else if(size != halfSize) return false;
+
+	return ReadMaterial(fastTrack.GetEnvelopeMaterial());
+
+}
+
+void CrystalPhotonModel::DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+
+	const G4Track* track = fastTrack.GetPrimaryTrack();
+	const TrackingAction* trackingAction = static_cast<const TrackingAction*>(
+		G4EventManager::GetEventManager()->GetUserTrackingAction());
+	G4int primary = trackingAction ? trackingAction->getCurrentPrimary() : 0;
+
+	//A batch belongs to one primary
+	if(!x.empty() && primary != batchPrimary){
+		pending.push_back(std::vector<Survivor>());
+		Trace(pending.back());
+	}
+	if(x.empty()) batchPrimary = primary;
+
+	G4ThreeVector position = fastTrack.GetPrimaryTrackLocalPosition();
+	G4ThreeVector direction = fastTrack.GetPrimaryTrackLocalMomentum().unit();
+	G4ThreeVector offset = fastTrack.GetInverseAffineTransformation()->TransformPoint(G4ThreeVector());
+	G4double e = track->GetKineticEnergy();
+
+	x.push_back(position.x());	dx.push_back(direction.x());	offsetX.push_back(offset.x());
+	y.push_back(position.y());	dy.push_back(direction.y());	offsetY.push_back(offset.y());
+	z.push_back(position.z());	dz.push_back(direction.z());	offsetZ.push_back(offset.z());
+	energy.push_back(e);
+	time.push_back(track->GetGlobalTime());
+	weight.push_back(track->GetWeight());
+	trackIDs.push_back(track->GetTrackID());
+	parentIDs.push_back(track->GetParentID());
+
+	G4double n1 = crystalIndex->Value(e);
+	G4double absorption = crystalAbsorption ? crystalAbsorption->Value(e) : DBL_MAX;
+	path.push_back(-absorption*std::log(G4UniformRand()));
+	invSpeed.push_back(n1/c_light);
+	reflect.push_back(reflectivity->Value(e));
+	eta.push_back(n1/exitIndex->Value(e));
+
+	fastStep.KillPrimaryTrack();
+	fastStep.ProposePrimaryTrackPathLength(0.);
+
+	if((G4int)x.size() < batchSize) return;
+
+	//Full: the survivors leave as secondaries of this photon
+	std::vector<Survivor> survivors;
+	Trace(survivors);
+	fastStep.SetNumberOfSecondaryTracks(survivors.size());
+	for(std::size_t i = 0; i < survivors.size(); i++){
+		G4DynamicParticle particle(G4OpticalPhoton::OpticalPhoton(), survivors[i].direction, survivors[i].energy);
+		G4ThreeVector polarization = Polarization(survivors[i].direction);
+		particle.SetPolarization(polarization.x(), polarization.y(), polarization.z());
+		G4Track* secondary = fastStep.CreateSecondaryTrack(particle, survivors[i].position, survivors[i].time, false);
+		secondary->SetWeight(survivors[i].weight);
+	}
+
+}
+
+void CrystalPhotonModel::FlushEvent()
+{
+
+	G4EventManager* eventManager = G4EventManager::GetEventManager();
+	G4TrackingManager* trackingManager = eventManager->GetTrackingManager();
+	const TrackingAction* trackingAction = static_cast<const TrackingAction*>(eventManager->GetUserTrackingAction());
+	std::vector<G4Track*> stack;
+
+	//The stack is done with the event, secondaries get IDs after its last
+	G4int lastTrackID = trackingAction ? trackingAction->getLastTrackID() : 0;
+
+	//Survivors may come back into a crystal and start a new batch
+	for(;;){
+		if(!x.empty()){
+			pending.push_back(std::vector<Survivor>());
+			Trace(pending.back());
+		}
+		if(pending.empty()) break;
+
+		std::vector<std::vector<Survivor> > work;
+		work.swap(pending);
+		for(std::size_t p = 0; p < work.size(); p++){
+			for(std::size_t i = 0; i < work[p].size(); i++){
+				const Survivor& survivor = work[p][i];
+				G4DynamicParticle* particle = new G4DynamicParticle(G4OpticalPhoton::OpticalPhoton(),
+										     survivor.direction, survivor.energy);
+				G4ThreeVector polarization = Polarization(survivor.direction);
+				particle->SetPolarization(polarization.x(), polarization.y(), polarization.z());
+				G4Track* track = new G4Track(particle, survivor.time, survivor.position);
+				//The photon carries on under its own ID, so the primary tag follows its parent
+				track->SetTrackID(survivor.trackID);
+				track->SetParentID(survivor.parentID);
+				track->SetWeight(survivor.weight);
+				stack.push_back(track);
+
+				while(!stack.empty()){
+					G4Track* current = stack.back();
+					stack.pop_back();
+					trackingManager->ProcessOneTrack(current);
+
+					G4VTrajectory* trajectory = trackingManager->GimmeTrajectory();
+					if(trajectory){
+						delete trajectory;
+						trackingManager->SetTrajectory(0);
+					}
+
+					G4TrackVector* secondaries = trackingManager->GimmeSecondaries();
+					for(std::size_t k = 0; secondaries && k < secondaries->size(); k++){
+						(*secondaries)[k]->SetParentID(current->GetTrackID());
+						(*secondaries)[k]->SetTrackID(++lastTrackID);
+						stack.push_back((*secondaries)[k]);
+					}
+					if(secondaries) secondaries->clear();
+
+					delete current;
+				}
+			}
+		}
+	}
+
+}
+
+void CrystalPhotonModel::Trace(std::vector<Survivor>& survivors)
+{
+
+	G4int n = x.size();
+	if(n == 0) return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	uniform.resize(n);
+	face.resize(n);
+	status.assign(n, 0);
+	const G4double h[3] = {halfSize.x(), halfSize.y(), halfSize.z()};
+
+	G4int nActive = n;
+	for(G4int bounce = 0; nActive > 0 && bounce <= maxBounces; bounce++){
+		G4Random::getTheEngine()->flatArray(nActive, &uniform[0]);
+
+		//Every active photon straight to its next face or absorption point
+		for(G4int i = 0; i < nActive; i++){
+			G4double tx = dx[i] != 0. ? ((dx[i] > 0. ? h[0] : -h[0]) - x[i])/dx[i] : DBL_MAX;
+			G4double ty = dy[i] != 0. ? ((dy[i] > 0. ? h[1] : -h[1]) - y[i])/dy[i] : DBL_MAX;
+			G4double tz = dz[i] != 0. ? ((dz[i] > 0. ? h[2] : -h[2]) - z[i])/dz[i] : DBL_MAX;
+			G4double t = std::min(tx, std::min(ty, tz));
+			G4double s = std::min(t, path[i]);
+			face[i] = (path[i] < t) ? -1 : ((tx <= t) ? 0 : ((ty <= t) ? 1 : 2));
+			x[i] += s*dx[i];
+			y[i] += s*dy[i];
+			z[i] += s*dz[i];
+			time[i] += s*invSpeed[i];
+			path[i] -= s;
+		}
+
+		//Face interactions
+		for(G4int i = 0; i < nActive; i++){
+			if(face[i] < 0){
+				status[i] = 1;
+				absorbedBulk++;
+			}
+			else if(face[i] == 2 && dz[i] > 0.){
+				//Plate side, Fresnel for unpolarized light
+				G4double cosI = dz[i];
+				G4double sin2T = eta[i]*eta[i]*(1. - cosI*cosI);
+				if(sin2T < 1.){
+					G4double cosT = std::sqrt(1. - sin2T);
+					G4double rs = (eta[i]*cosI - cosT)/(eta[i]*cosI + cosT);
+					G4double rp = (eta[i]*cosT - cosI)/(eta[i]*cosT + cosI);
+					if(uniform[i] >= 0.5*(rs*rs + rp*rp)){
+						Survivor survivor;
+						survivor.position = G4ThreeVector(x[i] + offsetX[i], y[i] + offsetY[i], h[2] + exitGap + offsetZ[i]);
+						survivor.direction = G4ThreeVector(eta[i]*dx[i], eta[i]*dy[i], cosT).unit();
+						survivor.energy = energy[i];
+						survivor.time = time[i];
+						survivor.weight = weight[i];
+						survivor.trackID = trackIDs[i];
+						survivor.parentID = parentIDs[i];
+						survivors.push_back(survivor);
+						status[i] = 2;
+						transmitted++;
+						continue;
+					}
+				}
+				dz[i] = -dz[i];
+				bounces++;
+			}
+			else if(uniform[i] < reflect[i]){
+				//Painted, specular
+				if(face[i] == 0) dx[i] = -dx[i];
+				else if(face[i] == 1) dy[i] = -dy[i];
+				else dz[i] = -dz[i];
+				bounces++;
+			}
+			else{
+				status[i] = 1;
+				absorbedPaint++;
+			}
+		}
+
+		//Keep the active photons in front
+		G4int j = 0;
+		for(G4int i = 0; i < nActive; i++){
+			if(status[i] != 0) continue;
+			if(i != j){
+				x[j] = x[i]; y[j] = y[i]; z[j] = z[i];
+				dx[j] = dx[i]; dy[j] = dy[i]; dz[j] = dz[i];
+				energy[j] = energy[i]; time[j] = time[i]; weight[j] = weight[i]; path[j] = path[i];
+				invSpeed[j] = invSpeed[i]; reflect[j] = reflect[i]; eta[j] = eta[i];
+				offsetX[j] = offsetX[i]; offsetY[j] = offsetY[i]; offsetZ[j] = offsetZ[i];
+				trackIDs[j] = trackIDs[i]; parentIDs[j] = parentIDs[i];
+				status[j] = 0;
+			}
+			j++;
+		}
+		nActive = j;
+	}
+
+	capped += nActive;
+	traced += n;
+	seconds += std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+	Clear();
+
+}
+
+void CrystalPhotonModel::Clear()
+{
+
+	x.clear(); y.clear(); z.clear();
+	dx.clear(); dy.clear(); dz.clear();
+	energy.clear(); time.clear(); weight.clear(); path.clear();
+	invSpeed.clear(); reflect.clear(); eta.clear();
+	offsetX.clear(); offsetY.clear(); offsetZ.clear();
+	trackIDs.clear(); parentIDs.clear();
+
+}
+
+G4ThreeVector CrystalPhotonModel::Polarization(const G4ThreeVector& direction) const
+{
+
+	//Random linear polarization, perpendicular to the direction
+	G4ThreeVector perpendicular = direction.orthogonal().unit();
+	G4double phi = twopi*G4UniformRand();
+	return std::cos(phi)*perpendicular + std::sin(phi)*direction.cross(perpendicular);
+
+}
+
+G4bool CrystalPhotonModel::ReadSurface()
+{
+
+	surfaceRead = true;
+	const G4SurfacePropertyTable* surfaces = G4SurfaceProperty::GetSurfacePropertyTable();
+	for(std::size_t i = 0; i < surfaces->size(); i++){
+		G4OpticalSurface* surface = dynamic_cast<G4OpticalSurface*>((*surfaces)[i]);
+		if(!surface || surface->GetName() != "CrystalOpticalSurface") continue;
+		G4MaterialPropertiesTable* mpt = surface->GetMaterialPropertiesTable();
+		if(surface->GetFinish() == polishedfrontpainted && mpt) reflectivity = mpt->GetProperty("REFLECTIVITY");
+	}
+
+	if(!reflectivity){
+		G4Exception("CrystalPhotonModel::ReadSurface", "CrystalTracer001", JustWarning,
+			    "No polished front painted CrystalOpticalSurface with REFLECTIVITY, tracer disabled");
+		enabled = false;
+	}
+	return reflectivity != 0;
+
+}
+
+G4bool CrystalPhotonModel::ReadMaterial(const G4Material* material)
+{
+
+	if(material == crystalMaterial) return true;
+	if(crystalMaterial) return false;
+
+	G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+	G4MaterialPropertiesTable* exitMpt = exitMaterial ? exitMaterial->GetMaterialPropertiesTable() : 0;
+	if(!mpt || !exitMpt || !mpt->GetProperty("RINDEX") || !exitMpt->GetProperty("RINDEX")){
+		G4Exception("CrystalPhotonModel::ReadMaterial", "CrystalTracer002", JustWarning,
+			    "Crystal or plate material without RINDEX, tracer disabled");
+		enabled = false;
+		return false;
+	}
+
+	crystalMaterial = material;
+	crystalIndex = mpt->GetProperty("RINDEX");
+	crystalAbsorption = mpt->GetProperty("ABSLENGTH");
+	exitIndex = exitMpt->GetProperty("RINDEX");
+	return true;
+
+}
+
+void CrystalPhotonModel::BeginOfRun()
+{
+
+	traced = transmitted = absorbedBulk = absorbedPaint = capped = bounces = seconds = 0;
+
+}
+
+void CrystalPhotonModel::EndOfRun()
+{
+
+	if(traced == 0) return;
+
+	G4cout<<"Crystal tracer: "<<traced<<" photons in "<<seconds<<" s";
+	if(seconds > 0) G4cout<<" ("<<traced/seconds<<" photons/s)";
+	G4cout<<G4endl
+	      <<"  transmitted "<<transmitted/traced
+	      <<", absorbed in bulk "<<absorbedBulk/traced
+	      <<", at paint "<<absorbedPaint/traced
+	      <<", bounce limit "<<capped/traced
+	      <<", "<<bounces/traced<<" reflections/photon"<<G4endl;
+
+}
@@ -0,0 +1,58 @@
+#include "CrystalPhotonModelMessenger.hh"
+#include "CrystalPhotonModel.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+CrystalPhotonModelMessenger::CrystalPhotonModelMessenger(CrystalPhotonModel* tracer)
+	: G4UImessenger(),
+	  model(tracer)
+{
+
+	tracerDir = new G4UIdirectory("/matrix/crystalTracer/");
+	tracerDir->SetGuidance("Batched optical photon transport inside the crystals.");
+
+	enableCmd = new G4UIcmdWithABool("/matrix/crystalTracer/enable", this);
+	enableCmd->SetGuidance("Trace photons in the crystals in batches instead of with the navigator.");
+	enableCmd->SetParameterName("enable", true);
+	enableCmd->SetDefaultValue(true);
+	enableCmd->AvailableForStates(G4State_Idle);
+
+	batchSizeCmd = new G4UIcmdWithAnInteger("/matrix/crystalTracer/batchSize", this);
+	batchSizeCmd->SetGuidance("Photons gathered before a batch is traced.");
+	batchSizeCmd->SetParameterName("N", false);
+	batchSizeCmd->SetRange("N>0");
+	batchSizeCmd->AvailableForStates(G4State_Idle);
+
+	maxBouncesCmd = new G4UIcmdWithAnInteger("/matrix/crystalTracer/maxBounces", this);
+	maxBouncesCmd->SetGuidance("Photons still inside after N reflections are dropped.");
+	maxBouncesCmd->SetParameterName("N", false);
+	maxBouncesCmd->SetRange("N>0");
+	maxBouncesCmd->AvailableForStates(G4State_Idle);
+
+}
+
+CrystalPhotonModelMessenger::~CrystalPhotonModelMessenger()
+{
+
+	delete maxBouncesCmd;
+	delete batchSizeCmd;
+	delete enableCmd;
+	delete tracerDir;
+
+}
+
+void CrystalPhotonModelMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == enableCmd)
+		model->SetEnabled(enableCmd->GetNewBoolValue(newValue));
+
+	else if(command == batchSizeCmd)
+		model->SetBatchSize(batchSizeCmd->GetNewIntValue(newValue));
+
+	else if(command == maxBouncesCmd)
+		model->SetMaxBounces(maxBouncesCmd->GetNewIntValue(newValue));
+
+}
@@ -0,0 +1,74 @@
+#include "DepositReader.hh"
+
+#include <cstring>
+
+DepositReader::DepositReader()
+{}
+
+DepositReader::~DepositReader()
+{}
+
+G4bool DepositReader::Open(const G4String& fileName)
+{
+
+	Close();
+
+	if(!file.Open(fileName)){
+		G4ExceptionDescription msg;
+		msg << "Cannot map deposit file " << fileName;
+		G4Exception("DepositReader::Open", "Deposit001", JustWarning, msg);
+		return false;
+	}
+
+	const DepositHeader* header = reinterpret_cast<const DepositHeader*>(file.GetData());
+	if(file.GetSize() < sizeof(DepositHeader)
+	   || std::strncmp(header->magic, "MTXDEP1", 8) != 0
+	   || header->recordSize != sizeof(DepositRecord)){
+		G4ExceptionDescription msg;
+		msg << fileName << " is not a valid deposit file (MTXDEP1 header with "
+		    << sizeof(DepositRecord) << " byte records expected)";
+		G4Exception("DepositReader::Open", "Deposit002", JustWarning, msg);
+		file.Close();
+		return false;
+	}
+
+	//A truncated last event (interrupted recording) is left out
+	uint64_t offset = sizeof(DepositHeader);
+	uint64_t size = file.GetSize();
+	while(offset + sizeof(DepositEventHeader) <= size){
+		const DepositEventHeader* event = reinterpret_cast<const DepositEventHeader*>(file.GetData() + offset);
+		uint64_t next = offset + sizeof(DepositEventHeader) + (uint64_t)event->nDeposits*sizeof(DepositRecord);
+		if(next > size) break;
+		offsets.push_back(offset);
+		offset = next;
+	}
+
+	if(offsets.empty()){
+		G4ExceptionDescription msg;
+		msg << "No events in deposit file " << fileName;
+		G4Exception("DepositReader::Open", "Deposit003", JustWarning, msg);
+		file.Close();
+		return false;
+	}
+
+	return true;
+}
+
+void DepositReader::Close()
+{
+
+	file.Close();
+	offsets.clear();
+
+}
+
+const DepositRecord* DepositReader::GetEvent(G4int i, G4int& eventID, G4int& nDeposits) const
+{
+
+	const char* data = file.GetData() + offsets[i];
+	const DepositEventHeader* event = reinterpret_cast<const DepositEventHeader*>(data);
+	eventID = event->event;
+	nDeposits = event->nDeposits;
+	return reinterpret_cast<const DepositRecord*>(data + sizeof(DepositEventHeader));
+
+}
@@ -0,0 +1,160 @@
+#include "DepositRecorder.hh"
+#include "DepositRecorderMessenger.hh"
+#include "TrackingAction.hh"
+#include "DetectorParameters.hh"
+#include "Run.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4EventManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4VTouchable.hh"
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+	//Output of all threads, opened by the master
+	G4Mutex sharedMutex = G4MUTEX_INITIALIZER;
+	std::FILE* sharedFile = 0;
+	G4String sharedName = "";
+
+}
+
+DepositRecorder::DepositRecorder()
+	: messenger(0),
+	  fileName(""),
+	  active(false),
+	  crystal(0)
+{
+	messenger = new DepositRecorderMessenger(this);
+}
+
+DepositRecorder::~DepositRecorder()
+{
+
+	delete messenger;
+
+	if(G4Threading::IsMasterThread()){
+		G4AutoLock lock(&sharedMutex);
+		if(sharedFile) std::fclose(sharedFile);
+		sharedFile = 0;
+		sharedName = "";
+	}
+
+}
+
+void DepositRecorder::BeginOfRun(const G4Run*)
+{
+
+	buffer.clear();
+	active = (fileName != "");
+	if(!active) return;
+
+	crystal = G4LogicalVolumeStore::GetInstance()->GetVolume("CrystalLogical", false);
+	if(!crystal){
+		G4Exception("DepositRecorder::BeginOfRun", "Deposit004", JustWarning,
+			    "No CrystalLogical volume, nothing is recorded.");
+		active = false;
+		return;
+	}
+
+	//The master (or the only thread) opens the file before any worker starts
+	if(!G4Threading::IsMasterThread()) return;
+	G4AutoLock lock(&sharedMutex);
+	if(sharedFile && sharedName == fileName) return;
+
+	if(sharedFile) std::fclose(sharedFile);
+	sharedFile = std::fopen(fileName.c_str(), "wb");
+	sharedName = fileName;
+	if(!sharedFile){
+		G4ExceptionDescription msg;
+		msg << "Cannot create deposit file " << fileName;
+		G4Exception("DepositRecorder::BeginOfRun", "Deposit005", FatalException, msg);
+		return;
+	}
+
+	DepositHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::strncpy(header.magic, "MTXDEP1", sizeof(header.magic));
+	header.version = 1;
+	header.recordSize = sizeof(DepositRecord);
+	std::fwrite(&header, sizeof(header), 1, sharedFile);
+
+}
+
+void DepositRecorder::Record(const G4Step* step)
+{
+
+	const G4StepPoint* pre = step->GetPreStepPoint();
+	const G4VTouchable* touchable = pre->GetTouchable();
+	if(touchable->GetVolume()->GetLogicalVolume() != crystal) return;
+
+	const G4Track* track = step->GetTrack();
+	const G4StepPoint* post = step->GetPostStepPoint();
+	const TrackingAction* trackingAction = static_cast<const TrackingAction*>(
+		G4EventManager::GetEventManager()->GetUserTrackingAction());
+
+	DepositRecord record;
+	//Crystal in its gap cell (YDiv replica) in the column (XSegment
+	//replica), in the module (Y replica) of a module column (X replica)
+	G4int depth = touchable->GetHistoryDepth();
+	record.ix = depth >= 2 ? touchable->GetReplicaNumber(2) : 0;
+	record.iy = depth >= 1 ? touchable->GetReplicaNumber(1) : 0;
+	if(depth >= 5){
+		record.ix += touchable->GetReplicaNumber(5)*DetectorParameters::nx;
+		record.iy += touchable->GetReplicaNumber(4)*DetectorParameters::ny;
+	}
+	record.primary = trackingAction ? trackingAction->getCurrentPrimary() : 0;
+	record.x0 = pre->GetPosition().x()/mm;
+	record.y0 = pre->GetPosition().y()/mm;
+	record.z0 = pre->GetPosition().z()/mm;
+	record.x1 = post->GetPosition().x()/mm;
+	record.y1 = post->GetPosition().y()/mm;
+	record.z1 = post->GetPosition().z()/mm;
+	record.t0 = pre->GetGlobalTime()/ns;
+	record.t1 = post->GetGlobalTime()/ns;
+	record.edep = step->GetTotalEnergyDeposit()/MeV;
+	record.weight = track->GetWeight();
+	buffer.push_back(record);
+
+}
+
+void DepositRecorder::EndOfEvent(G4int eventID, Run* run)
+{
+
+	if(!active) return;
+
+	DepositEventHeader header;
+	header.event = eventID;
+	header.nDeposits = buffer.size();
+	run->AddDeposits(buffer.size());
+
+	G4AutoLock lock(&sharedMutex);
+	if(sharedFile){
+		std::fwrite(&header, sizeof(header), 1, sharedFile);
+		if(!buffer.empty()) std::fwrite(&buffer[0], sizeof(DepositRecord), buffer.size(), sharedFile);
+	}
+	lock.unlock();
+
+	buffer.clear();
+
+}
+
+void DepositRecorder::EndOfRun(const G4Run* aRun)
+{
+
+	//Reported once, from the run the workers were merged into
+	if(!active || !G4Threading::IsMasterThread()) return;
+
+	const Run* run = static_cast<const Run*>(aRun);
+	G4AutoLock lock(&sharedMutex);
+	if(sharedFile) std::fflush(sharedFile);
+	G4cout<<"Deposits: "<<run->GetDeposits()<<" steps of "<<run->GetDepositEvents()<<" events appended to "<<sharedName<<G4endl;
+
+}
@@ -0,0 +1,46 @@
+#include "DepositRecorderMessenger.hh"
+#include "DepositRecorder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+DepositRecorderMessenger::DepositRecorderMessenger(DepositRecorder* deposits)
+	: G4UImessenger(),
+	  recorder(deposits)
+{
+
+	depositDir = new G4UIdirectory("/matrix/deposits/");
+	depositDir->SetGuidance("Recording of crystal energy deposits for optical replay.");
+
+	recordCmd = new G4UIcmdWithAString("/matrix/deposits/record", this);
+	recordCmd->SetGuidance("Record the deposits of the following runs to this file.");
+	recordCmd->SetGuidance("Replay them with /matrix/source/type deposits.");
+	recordCmd->SetParameterName("file", false);
+	recordCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	stopCmd = new G4UIcmdWithoutParameter("/matrix/deposits/stop", this);
+	stopCmd->SetGuidance("Stop recording deposits.");
+	stopCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+DepositRecorderMessenger::~DepositRecorderMessenger()
+{
+
+	delete stopCmd;
+	delete recordCmd;
+	delete depositDir;
+
+}
+
+void DepositRecorderMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == recordCmd)
+		recorder->SetFileName(newValue);
+
+	else if(command == stopCmd)
+		recorder->SetFileName("");
+
+}
@@ -0,0 +1,148 @@
+#include "DepositReplay.hh"
+#include "PrimaryInformation.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+#include "G4Poisson.hh"
+
+#include <algorithm>
+#include <cmath>
+
+DepositReplay::DepositReplay()
+	: fileName(""),
+	  ready(false),
+	  wrapped(false),
+	  yield(0),
+	  resolution(1.),
+	  decayTime(0)
+{}
+
+DepositReplay::~DepositReplay()
+{}
+
+void DepositReplay::Open()
+{
+
+	if(!reader.Open(fileName)){
+		G4ExceptionDescription msg;
+		msg << "Deposit source selected but " << fileName << " cannot be used";
+		G4Exception("DepositReplay::Open", "Deposit006", FatalException, msg);
+		return;
+	}
+	ReadScintillation();
+	ready = true;
+	wrapped = false;
+
+	G4cout<<"Deposits "<<fileName<<": "<<reader.GetNumberOfEvents()<<" events"<<G4endl;
+
+}
+
+void DepositReplay::ReadScintillation()
+{
+
+	//Same constants the scintillation process uses in the first stage
+	G4Material* lyso = G4Material::GetMaterial("LYSO", false);
+	G4MaterialPropertiesTable* table = lyso ? lyso->GetMaterialPropertiesTable() : 0;
+	G4MaterialPropertyVector* fast = table ? table->GetProperty("FASTCOMPONENT") : 0;
+	if(!fast || fast->GetVectorLength() < 2 || !table->ConstPropertyExists("SCINTILLATIONYIELD")){
+		G4Exception("DepositReplay::ReadScintillation", "Deposit007", FatalException,
+			    "The LYSO material lacks the scintillation properties to replay deposits.");
+		return;
+	}
+
+	yield = table->GetConstProperty("SCINTILLATIONYIELD");
+	resolution = table->ConstPropertyExists("RESOLUTIONSCALE") ? table->GetConstProperty("RESOLUTIONSCALE") : 1.;
+	decayTime = table->ConstPropertyExists("FASTTIMECONSTANT") ? table->GetConstProperty("FASTTIMECONSTANT") : 0.;
+
+	//Emission spectrum as bins between the tabulated energies
+	std::vector<G4double> content;
+	spectrumLow.clear();
+	spectrumWidth.clear();
+	for(std::size_t i = 0; i + 1 < fast->GetVectorLength(); i++){
+		G4double low = fast->Energy(i), high = fast->Energy(i + 1);
+		spectrumLow.push_back(low);
+		spectrumWidth.push_back(high - low);
+		content.push_back(0.5*((*fast)[i] + (*fast)[i + 1])*(high - low));
+	}
+	spectrum.Build(content);
+
+}
+
+G4int DepositReplay::SamplePhotons(G4double edep) const
+{
+
+	G4double mean = yield*edep;
+	if(mean <= 10.) return G4Poisson(mean);
+
+	G4double sigma = resolution*std::sqrt(mean);
+	return std::max(0, (G4int)std::floor(G4RandGauss::shoot(mean, sigma) + 0.5));
+
+}
+
+G4double DepositReplay::SampleEnergy() const
+{
+
+	G4int bin = spectrum.Sample(G4UniformRand());
+	return spectrumLow[bin] + spectrumWidth[bin]*G4UniformRand();
+
+}
+
+void DepositReplay::GeneratePrimaries(G4Event* event)
+{
+
+	if(!ready) Open();
+	if(!ready) return;
+
+	//Replaying more events than recorded starts the file over
+	G4int nEvents = reader.GetNumberOfEvents();
+	if(event->GetEventID() >= nEvents && !wrapped){
+		G4ExceptionDescription msg;
+		msg << "More events than the " << nEvents << " recorded in " << fileName << ", reusing them";
+		G4Exception("DepositReplay::GeneratePrimaries", "Deposit008", JustWarning, msg);
+		wrapped = true;
+	}
+
+	G4int eventID, nDeposits;
+	const DepositRecord* deposits = reader.GetEvent(event->GetEventID()%nEvents, eventID, nDeposits);
+
+	G4ParticleDefinition* photon = G4OpticalPhoton::OpticalPhoton();
+	for(G4int d = 0; d < nDeposits; d++){
+		const DepositRecord& deposit = deposits[d];
+		G4ThreeVector start(deposit.x0*mm, deposit.y0*mm, deposit.z0*mm);
+		G4ThreeVector step = G4ThreeVector(deposit.x1*mm, deposit.y1*mm, deposit.z1*mm) - start;
+		G4double t0 = deposit.t0*ns, dt = (deposit.t1 - deposit.t0)*ns;
+
+		G4int n = SamplePhotons(deposit.edep*MeV);
+		for(G4int i = 0; i < n; i++){
+			G4double u = G4UniformRand();
+			G4double time = t0 + u*dt;
+			if(decayTime > 0) time -= decayTime*std::log(G4UniformRand());
+
+			G4double cosTheta = 2.*G4UniformRand() - 1.;
+			G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+			G4double phi = twopi*G4UniformRand();
+			G4ThreeVector dir(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+			G4ThreeVector polarization = dir.orthogonal().unit();
+			polarization.rotate(twopi*G4UniformRand(), dir);
+
+			G4PrimaryParticle* particle = new G4PrimaryParticle(photon);
+			particle->SetMomentumDirection(dir);
+			particle->SetKineticEnergy(SampleEnergy());
+			particle->SetPolarization(polarization);
+			particle->SetWeight(deposit.weight);
+			particle->SetUserInformation(new PrimaryInformation(deposit.primary));
+
+			G4PrimaryVertex* vertex = new G4PrimaryVertex(start + u*step, time);
+			vertex->SetPrimary(particle);
+			event->AddPrimaryVertex(vertex);
+		}
+	}
+
+}
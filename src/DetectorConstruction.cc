@@ -9,6 +9,10 @@
 #include "DetectorConstruction.hh"
 #include "SensitiveDetector.hh"
 #include "DetectorROGeometry.hh"
+#include "CrystalPhotonModel.hh"
+#include "DetectorMessenger.hh"
+#include "GeometryBenchmark.hh"
+#include "PrimaryForceCollision.hh"
 
 #include "G4Material.hh"
 #include "G4NistManager.hh"
@@ -29,18 +33,88 @@
 #include "G4SDParticleFilter.hh"
 #include "G4OpticalSurface.hh"
 #include "G4LogicalBorderSurface.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4GeometryManager.hh"
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
+#include "G4UIcommand.hh"
+
+#ifdef MATRIX_GDML
+#include "G4GDMLParser.hh"
+#endif
+
+#include <sstream>
+#include <sys/stat.h>
 
 DetectorConstruction::DetectorConstruction()
-	: pSD(0),
-	  pWorldPhys(0)
+	: pWorldPhys(0),
+	  pRODivLog_X(0),
+	  pRODivLog_Y(0),
+	  plateMaterial(0),
+	  gdmlFile(""),
+	  forcedInteraction(false),
+	  messenger(0)
 {
-#include "DetectorParameterDef.icc"
+	messenger = new DetectorMessenger(this);
 }
 
 DetectorConstruction::~DetectorConstruction()
-{}
+{
+	delete messenger;
+}
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
+{
+
+    G4Timer timer;
+    timer.Start();
+
+    if(gdmlFile != ""){
+        pWorldPhys = ReadGDML();
+        CheckTiling();
+    }
+    else pWorldPhys = ConstructMatrix();
+
+    //Everything below is bound by volume name, whatever built the volumes
+    if(G4LogicalBorderSurface::GetNumberOfBorderSurfaces() == 0) ConstructSurfaces();
+
+    G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+    G4LogicalVolume* pCryLog = volumes->GetVolume("CrystalLogical", false);
+    G4LogicalVolume* pPlateLog = volumes->GetVolume("PlateLogical", false);
+    pRODivLog_X = volumes->GetVolume("RODivLogical_X", false);
+    pRODivLog_Y = volumes->GetVolume("RODivLogical_Y", false);
+    if(!pCryLog || !pPlateLog || !pRODivLog_X || !pRODivLog_Y){
+        G4ExceptionDescription msg;
+        msg << "The geometry lacks CrystalLogical, PlateLogical or the RODivLogical_X/Y readout volumes";
+        G4Exception("DetectorConstruction::Construct", "Geometry001", FatalException, msg);
+    }
+
+    //Envelope of the fast photon tracer
+    G4Region* crystalRegion = G4RegionStore::GetInstance()->GetRegion("CrystalRegion", false);
+    if(!crystalRegion){
+        crystalRegion = new G4Region("CrystalRegion");
+        crystalRegion->AddRootLogicalVolume(pCryLog);
+        crystalRegion->SetProductionCuts(G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts());
+    }
+    plateMaterial = pPlateLog->GetMaterial();
+
+    ApplyVolumeSettings();
+
+    timer.Stop();
+    G4cout<<"Geometry "<<(gdmlFile != "" ? "read from " + gdmlFile : G4String("built"))
+          <<" in "<<timer.GetRealElapsed()<<" s"<<G4endl;
+    G4cout<<"  "<<ModuleTiling::nModulesX<<"x"<<ModuleTiling::nModulesY<<" modules, "
+          <<ModuleTiling::NumberOfModules()*nx*ny<<" crystals, "
+          <<ModuleTiling::NumberOfChannels()<<" readout channels"<<G4endl;
+
+    return pWorldPhys;
+}
+
+G4VPhysicalVolume* DetectorConstruction::ConstructMatrix()
 {
 
     //LYSO Material____________________________________________________________
@@ -269,24 +343,46 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
     //Volumes Definition________________________________________
 
+    G4ThreeVector Id_tr(0., 0., 0.);
+    G4RotationMatrix* Id_rot = new G4RotationMatrix();
+    G4RotationMatrix* rot = 0;
+
     //World
-    G4Box* pWorldSolid = new G4Box("WorldBox", Wx, Wy, Wz);
+    G4Box* pWorldSolid = new G4Box("WorldBox", ModuleTiling::WorldX(), ModuleTiling::WorldY(), Wz);
     G4LogicalVolume* pWorldLog = new G4LogicalVolume(pWorldSolid, Air, "WorldLogical");
     pWorldPhys = new G4PVPlacement(Id_rot, Id_tr, pWorldLog, "World", 0, false, 0);
     pWorldLog->SetVisAttributes(G4VisAttributes(false));
 
     //Detector
-    G4Box* pDetSolid = new G4Box("DetBox", Dx, Dy, Dz);
+    G4Box* pDetSolid = new G4Box("DetBox", ModuleTiling::DetectorX(), ModuleTiling::DetectorY(), Dz);
     G4LogicalVolume* pDetLog = new G4LogicalVolume(pDetSolid, Air, "DetLogical");
     G4PVPlacement* pDetPhys = new G4PVPlacement(Id_rot, Id_tr, pDetLog, "Detector", pWorldLog, false, 0);
     G4VisAttributes* pDetVA = new G4VisAttributes(false);
     pDetVA->SetForceWireframe(true);
     pDetLog->SetVisAttributes(pDetVA);
 
+    //Module plane: nested replicas, so locating a module costs the same
+    //whatever the number of modules
+    G4double modX = ModuleTiling::ModuleX(), modY = ModuleTiling::ModuleY(), modZ = ModuleTiling::ModuleZ();
+    G4Box* pPlaneSolid = new G4Box("PlaneBox", ModuleTiling::PlaneX(), ModuleTiling::PlaneY(), modZ);
+    G4LogicalVolume* pPlaneLog = new G4LogicalVolume(pPlaneSolid, Air, "PlaneLogical");
+    G4PVPlacement* pPlanePhys = new G4PVPlacement(Id_rot, G4ThreeVector(0., 0., Dz-modZ), pPlaneLog, "Plane", pDetLog, false, 0);
+    pPlaneLog->SetVisAttributes(G4VisAttributes(false));
+
+    G4Box* pColumnSolid = new G4Box("ModuleColumnBox", modX, ModuleTiling::PlaneY(), modZ);
+    G4LogicalVolume* pColumnLog = new G4LogicalVolume(pColumnSolid, Air, "ModuleColumnLogical");
+    G4VPhysicalVolume* pColumnPhys = new G4PVReplica("ModuleColumn", pColumnLog, pPlanePhys, kXAxis, ModuleTiling::nModulesX, 2.*modX);
+    pColumnLog->SetVisAttributes(G4VisAttributes(false));
+
+    G4Box* pModuleSolid = new G4Box("ModuleBox", modX, modY, modZ);
+    G4LogicalVolume* pModuleLog = new G4LogicalVolume(pModuleSolid, Air, "ModuleLogical");
+    new G4PVReplica("Module", pModuleLog, pColumnPhys, kYAxis, ModuleTiling::nModulesY, 2.*modY);
+    pModuleLog->SetVisAttributes(G4VisAttributes(false));
+
     //Acrylic Plate
     G4Box* pPlateSolid = new G4Box("PlateBox", Px, Py, Pz);
     G4LogicalVolume* pPlateLog = new G4LogicalVolume(pPlateSolid, UVTAcrylic, "PlateLogical");
-    G4PVPlacement* pPlatePhys = new G4PVPlacement(Id_rot, G4ThreeVector(0,0,Dz-Pz), pPlateLog, "Plate", pDetLog, false, 0);
+    G4PVPlacement* pPlatePhys = new G4PVPlacement(Id_rot, G4ThreeVector(0,0,modZ-Pz), pPlateLog, "Plate", pModuleLog, false, 0);
     G4VisAttributes* plateVA = new G4VisAttributes(true, G4Colour::White());
     plateVA->SetForceWireframe(true);
     pPlateLog->SetVisAttributes(plateVA);
@@ -326,7 +422,7 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     //Matrix
     G4Box* pMatrixSolid = new G4Box("MatrixBox", Mx, My, Mz);
     G4LogicalVolume* pMatrixLog = new G4LogicalVolume(pMatrixSolid, Air, "MatrixLogical");
-    G4PVPlacement* pMatrixPhys = new G4PVPlacement(Id_rot, G4ThreeVector(0., 0., Dz-2*Pz-Mz), pMatrixLog, "Matrix", pDetLog, false, 0);
+    G4PVPlacement* pMatrixPhys = new G4PVPlacement(Id_rot, G4ThreeVector(0., 0., modZ-2*Pz-Mz), pMatrixLog, "Matrix", pModuleLog, false, 0);
     G4VisAttributes* matrixVA = new G4VisAttributes(false);
     matrixVA->SetForceWireframe(true);
     pMatrixLog->SetVisAttributes(matrixVA);
@@ -361,8 +457,8 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     rot = new G4RotationMatrix();
     rot->rotateX(90*deg);
     G4AssemblyVolume* slot_assembly = new G4AssemblyVolume(pFiberLog, Id_tr, rot);
-    for(x = -12; x <= 12; x++){
-    	tr = G4ThreeVector( x*2*CSx, 0., 0.);
+    for(x = 0; x < nx; x++){
+    	tr = G4ThreeVector((x - 0.5*(nx - 1))*2*CSx, 0., 0.);
     	slot_assembly->AddPlacedVolume(pFiberLog, tr, rot);
     }
     tr =  G4ThreeVector(0., 0., -Pz+Sz);
@@ -384,30 +480,46 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     pReadoutLog_X->SetVisAttributes(readout_VA);
     pReadoutLog_Y->SetVisAttributes(readout_VA);
 
-    G4PVPlacement* ROPhys_X = new G4PVPlacement(Id_rot, G4ThreeVector(0., Px+ROh, Dz-Pz), pReadoutLog_X, "Readout_X", pDetLog, false, 0);
-    G4PVPlacement* ROPhys_Y = new G4PVPlacement(Id_rot, G4ThreeVector(Py+ROh, 0., Dz-Pz), pReadoutLog_Y, "Readout_Y", pDetLog, false, 0);
+    G4PVPlacement* ROPhys_X = new G4PVPlacement(Id_rot, G4ThreeVector(0., Px+ROh, modZ-Pz), pReadoutLog_X, "Readout_X", pModuleLog, false, 0);
+    G4PVPlacement* ROPhys_Y = new G4PVPlacement(Id_rot, G4ThreeVector(Py+ROh, 0., modZ-Pz), pReadoutLog_Y, "Readout_Y", pModuleLog, false, 0);
 
-    //Readout Division: 25 slices
+    //Readout Division: one slice per crystal
     G4Box* pRODivSolid_X = new G4Box("RODivBox_X", RODiv, ROh, ROd);
     G4Box* pRODivSolid_Y = new G4Box("RODivBox_Y", ROh, RODiv, ROd);
-    G4LogicalVolume* pRODivLog_X = new G4LogicalVolume(pRODivSolid_X, Air, "RODivLogical_X");
-    G4LogicalVolume* pRODivLog_Y = new G4LogicalVolume(pRODivSolid_Y, Air, "RODivLogical_Y");
+    pRODivLog_X = new G4LogicalVolume(pRODivSolid_X, Air, "RODivLogical_X");
+    pRODivLog_Y = new G4LogicalVolume(pRODivSolid_Y, Air, "RODivLogical_Y");
     pRODivLog_X->SetVisAttributes(G4VisAttributes(true, G4Colour::Grey()));
     pRODivLog_Y->SetVisAttributes(G4VisAttributes(true, G4Colour::Grey()));
     G4VPhysicalVolume* pRODivPhys_X = new G4PVReplica("RO_X", pRODivLog_X, ROPhys_X, kXAxis, nx, 2.*RODiv);
     G4VPhysicalVolume* pRODivPhys_Y = new G4PVReplica("RO_Y", pRODivLog_Y, ROPhys_Y, kYAxis, ny, 2.*RODiv);	
 
-    //Sensitive Detector_______________________________________________________
-
-    pSD = new SensitiveDetector("LYSO/SensitiveDetector","LYSOHitsCollection");
-    G4SDParticleFilter* particleFilter = new G4SDParticleFilter("PhotonFilter","opticalphoton");
-    pSD->SetFilter(particleFilter);
+    return pWorldPhys;
+}
 
-    G4SDManager* sdm = G4SDManager::GetSDMpointer();
-    sdm->AddNewDetector(pSD);
+void DetectorConstruction::ConstructSurfaces()
+{
 
-    pRODivLog_X->SetSensitiveDetector(pSD);
-    pRODivLog_Y->SetSensitiveDetector(pSD);
+    //Volumes the surfaces sit between
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    G4VPhysicalVolume* pDetPhys     = store->GetVolume("Detector", false);
+    G4VPhysicalVolume* pModulePhys  = store->GetVolume("Module", false);
+    G4VPhysicalVolume* pPlatePhys   = store->GetVolume("Plate", false);
+    G4VPhysicalVolume* pCrystalPhys = store->GetVolume("Crystal", false);
+    G4VPhysicalVolume* pCSurfPhys   = store->GetVolume("YDiv", false);
+    G4VPhysicalVolume* pRODivPhys_X = store->GetVolume("RO_X", false);
+    G4VPhysicalVolume* pRODivPhys_Y = store->GetVolume("RO_Y", false);
+    G4VPhysicalVolume* pCorePhys    = store->GetVolume("Core", false);
+    G4VPhysicalVolume* pClad1Phys   = store->GetVolume("Cladding1", false);
+    G4VPhysicalVolume* pClad2Phys   = store->GetVolume("Cladding2", false);
+    if(!pDetPhys || !pPlatePhys || !pCrystalPhys || !pCSurfPhys || !pRODivPhys_X || !pRODivPhys_Y
+       || !pCorePhys || !pClad1Phys || !pClad2Phys){
+        G4ExceptionDescription msg;
+        msg << "Cannot find the volumes of the optical surfaces by name";
+        G4Exception("DetectorConstruction::ConstructSurfaces", "Geometry002", FatalException, msg);
+        return;
+    }
+    //Geometries from before the module tiling hold the matrix in Detector
+    if(!pModulePhys) pModulePhys = pDetPhys;
 
     //Material Properties Tables Attached to Optical Surfaces___________________
 
@@ -442,6 +554,12 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     plateOpSurface->SetType(dielectric_dielectric);
     plateOpSurface->SetFinish(groundfrontpainted);
     plateOpSurface->SetMaterialPropertiesTable(PMPT);
+    //The plate top is flush with every mother up to the world
+    const char* plateMothers[] = {"Module", "ModuleColumn", "Plane"};
+    for(G4int i = 0; i < 3; i++){
+        G4VPhysicalVolume* mother = store->GetVolume(plateMothers[i], false);
+        if(mother) new G4LogicalBorderSurface("PlateSurface",pPlatePhys,mother,plateOpSurface);
+    }
     new G4LogicalBorderSurface("PlateSurface",pPlatePhys,pDetPhys,plateOpSurface);
     new G4LogicalBorderSurface("PlateSurface",pPlatePhys,pWorldPhys,plateOpSurface);
     new G4LogicalBorderSurface("PlateSurfaceX",pPlatePhys,pRODivPhys_X,plateOpSurface);
@@ -453,9 +571,204 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
     fiberOpSurface->SetType(dielectric_dielectric);
     fiberOpSurface->SetFinish(polishedfrontpainted);
     fiberOpSurface->SetMaterialPropertiesTable(FMPT);
-    new G4LogicalBorderSurface("PaintedCore", pCorePhys, pDetPhys,fiberOpSurface);
-    new G4LogicalBorderSurface("PaintedClad1",pClad1Phys,pDetPhys,fiberOpSurface);
-    new G4LogicalBorderSurface("PaintedClad2",pClad2Phys,pDetPhys,fiberOpSurface);
+    new G4LogicalBorderSurface("PaintedCore", pCorePhys, pModulePhys,fiberOpSurface);
+    new G4LogicalBorderSurface("PaintedClad1",pClad1Phys,pModulePhys,fiberOpSurface);
+    new G4LogicalBorderSurface("PaintedClad2",pClad2Phys,pModulePhys,fiberOpSurface);
+
+}
+
+G4VPhysicalVolume* DetectorConstruction::ReadGDML()
+{
+
+#ifdef MATRIX_GDML
+    //Names are stripped of the pointer suffixes the writer appends
+    G4GDMLParser parser;
+    parser.Read(gdmlFile, false);
+
+    //Volume settings stored with the layout, commands take precedence
+    const G4GDMLAuxMapType* auxMap = parser.GetAuxMap();
+    for(G4GDMLAuxMapType::const_iterator it = auxMap->begin(); it != auxMap->end(); ++it){
+        const G4String& name = it->first->GetName();
+        for(std::size_t i = 0; i < it->second.size(); i++){
+            const G4GDMLAuxStructType& aux = it->second[i];
+            if(aux.type == "Smartless" && smartless.find(name) == smartless.end())
+                smartless[name] = G4UIcommand::ConvertToDouble(aux.value);
+            else if(aux.type == "Voxelize" && voxelize.find(name) == voxelize.end())
+                voxelize[name] = G4UIcommand::ConvertToBool(aux.value);
+        }
+    }
+
+    return parser.GetWorldVolume();
+#else
+    G4ExceptionDescription msg;
+    msg << "Cannot read " << gdmlFile << ": matrix was built without GDML support (WITH_GDML=OFF)";
+    G4Exception("DetectorConstruction::ReadGDML", "Geometry003", FatalException, msg);
+    return 0;
+#endif
+
+}
+
+void DetectorConstruction::CheckTiling() const
+{
+
+    //Channel buffers, histograms and the source are sized from --modules,
+    //so a plane read from a file must have the same tiling
+    G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+    G4VPhysicalVolume* pColumnPhys = store->GetVolume("ModuleColumn", false);
+    G4VPhysicalVolume* pModulePhys = store->GetVolume("Module", false);
+    G4int mx = 1, my = 1;
+    EAxis axis;
+    G4double width, offset;
+    G4bool consuming;
+    if(pColumnPhys && pColumnPhys->IsReplicated()) pColumnPhys->GetReplicationData(axis, mx, width, offset, consuming);
+    if(pModulePhys && pModulePhys->IsReplicated()) pModulePhys->GetReplicationData(axis, my, width, offset, consuming);
+
+    if(mx != ModuleTiling::nModulesX || my != ModuleTiling::nModulesY){
+        G4ExceptionDescription msg;
+        msg << gdmlFile << " holds " << mx << "x" << my << " modules but the run is set up for "
+            << ModuleTiling::nModulesX << "x" << ModuleTiling::nModulesY << "; run with --modules " << mx << "x" << my;
+        G4Exception("DetectorConstruction::CheckTiling", "Geometry005", FatalException, msg);
+    }
+
+}
+
+void DetectorConstruction::ExportGDML(const G4String& file)
+{
+
+#ifdef MATRIX_GDML
+    //The writer aborts on an existing file
+    struct stat info;
+    if(stat(file.c_str(), &info) == 0){
+        G4ExceptionDescription msg;
+        msg << file << " already exists, geometry not exported";
+        G4Exception("DetectorConstruction::ExportGDML", "Geometry004", JustWarning, msg);
+        return;
+    }
+
+    G4GDMLParser parser;
+    G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+    for(std::map<G4String, G4double>::const_iterator it = smartless.begin(); it != smartless.end(); ++it){
+        G4LogicalVolume* volume = volumes->GetVolume(it->first, false);
+        if(!volume) continue;
+        std::ostringstream value;
+        value << it->second;
+        G4GDMLAuxStructType aux;
+        aux.type = "Smartless";
+        aux.value = value.str();
+        aux.unit = "";
+        aux.auxList = 0;
+        parser.AddVolumeAuxiliary(aux, volume);
+    }
+    for(std::map<G4String, G4bool>::const_iterator it = voxelize.begin(); it != voxelize.end(); ++it){
+        G4LogicalVolume* volume = volumes->GetVolume(it->first, false);
+        if(!volume) continue;
+        G4GDMLAuxStructType aux;
+        aux.type = "Voxelize";
+        aux.value = it->second ? "true" : "false";
+        aux.unit = "";
+        aux.auxList = 0;
+        parser.AddVolumeAuxiliary(aux, volume);
+    }
+
+    parser.Write(file, pWorldPhys);
+    G4cout<<"Geometry exported to "<<file<<G4endl;
+#else
+    G4ExceptionDescription msg;
+    msg << "Cannot write " << file << ": matrix was built without GDML support (WITH_GDML=OFF)";
+    G4Exception("DetectorConstruction::ExportGDML", "Geometry003", JustWarning, msg);
+#endif
+
+}
+
+void DetectorConstruction::SetSmartless(const G4String& volume, G4double value)
+{
+
+    smartless[volume] = value;
+
+    //Once built, the volume changes now and is voxelized again
+    if(pWorldPhys){
+        ApplyVolumeSettings();
+        G4RunManager::GetRunManager()->GeometryHasBeenModified();
+    }
+
+}
+
+void DetectorConstruction::SetVoxelization(const G4String& volume, G4bool value)
+{
+
+    voxelize[volume] = value;
+
+    if(pWorldPhys){
+        ApplyVolumeSettings();
+        G4RunManager::GetRunManager()->GeometryHasBeenModified();
+    }
+
+}
+
+void DetectorConstruction::ApplyVolumeSettings()
+{
+
+    G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+
+    for(std::map<G4String, G4double>::const_iterator it = smartless.begin(); it != smartless.end(); ++it){
+        G4LogicalVolume* volume = volumes->GetVolume(it->first, false);
+        if(volume) volume->SetSmartless(it->second);
+        else G4cout<<"Smartless: no logical volume "<<it->first<<G4endl;
+    }
+    for(std::map<G4String, G4bool>::const_iterator it = voxelize.begin(); it != voxelize.end(); ++it){
+        G4LogicalVolume* volume = volumes->GetVolume(it->first, false);
+        if(volume) volume->SetOptimisation(it->second);
+        else G4cout<<"Voxelize: no logical volume "<<it->first<<G4endl;
+    }
+
+}
+
+void DetectorConstruction::BenchmarkNavigation(G4int nRays)
+{
+
+    if(!pWorldPhys) return;
+
+    //Voxels are built when the geometry closes
+    G4GeometryManager* geometry = G4GeometryManager::GetInstance();
+    G4bool wasClosed = geometry->IsGeometryClosed();
+    if(wasClosed) geometry->OpenGeometry();
+
+    G4Timer timer;
+    timer.Start();
+    geometry->CloseGeometry(true);
+    timer.Stop();
+    G4cout<<"Navigation benchmark of the "<<(gdmlFile != "" ? "GDML" : "C++")<<" geometry"<<G4endl
+          <<"  voxelization "<<timer.GetRealElapsed()<<" s"<<G4endl;
+
+    GeometryBenchmark::Run(pWorldPhys, nRays);
+
+    if(!wasClosed) geometry->OpenGeometry();
+
+}
+
+void DetectorConstruction::ConstructSDandField()
+{
+
+    //Sensitive Detector_______________________________________________________
+
+    //One instance per thread
+    SensitiveDetector* pSD = new SensitiveDetector("LYSO/SensitiveDetector","LYSOHitsCollection");
+    G4SDParticleFilter* particleFilter = new G4SDParticleFilter("PhotonFilter","opticalphoton");
+    pSD->SetFilter(particleFilter);
+
+    G4SDManager* sdm = G4SDManager::GetSDMpointer();
+    sdm->AddNewDetector(pSD);
+
+    SetSensitiveDetector(pRODivLog_X, pSD);
+    SetSensitiveDetector(pRODivLog_Y, pSD);
+
+    //Biasing operators are thread local as well
+    if(forcedInteraction){
+        PrimaryForceCollision* forceCollision = new PrimaryForceCollision("gamma", "ForceCollision");
+        forceCollision->AttachTo(G4LogicalVolumeStore::GetInstance()->GetVolume("CrystalLogical"));
+    }
+
+    //Fast photon tracer, off unless /matrix/crystalTracer/enable
+    new CrystalPhotonModel("CrystalPhotonModel", G4RegionStore::GetInstance()->GetRegion("CrystalRegion"), plateMaterial);
 
-    return pWorldPhys;
 }
@@ -0,0 +1,91 @@
+#include "DetectorMessenger.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIparameter.hh"
+
+#include <sstream>
+
+DetectorMessenger::DetectorMessenger(DetectorConstruction* det)
+	: G4UImessenger(),
+	  detector(det)
+{
+
+	//The geometry lives in the master, nothing to broadcast
+	geometryDir = new G4UIdirectory("/matrix/geometry/");
+	geometryDir->SetGuidance("Geometry export and navigation settings.");
+
+	exportCmd = new G4UIcmdWithAString("/matrix/geometry/export", this);
+	exportCmd->SetGuidance("Write the geometry to a GDML file (matrix --gdml reads it back).");
+	exportCmd->SetParameterName("file", false);
+	exportCmd->AvailableForStates(G4State_Idle);
+	exportCmd->SetToBeBroadcasted(false);
+
+	smartlessCmd = new G4UIcommand("/matrix/geometry/smartless", this);
+	smartlessCmd->SetGuidance("Smartless of a logical volume: voxels per daughter (default 2).");
+	G4UIparameter* volume = new G4UIparameter("volume", 's', false);
+	smartlessCmd->SetParameter(volume);
+	G4UIparameter* value = new G4UIparameter("value", 'd', false);
+	value->SetParameterRange("value>0.");
+	smartlessCmd->SetParameter(value);
+	smartlessCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	smartlessCmd->SetToBeBroadcasted(false);
+
+	voxelizeCmd = new G4UIcommand("/matrix/geometry/voxelize", this);
+	voxelizeCmd->SetGuidance("Enable or disable voxelization of a logical volume.");
+	volume = new G4UIparameter("volume", 's', false);
+	voxelizeCmd->SetParameter(volume);
+	G4UIparameter* enable = new G4UIparameter("enable", 'b', true);
+	enable->SetDefaultValue("true");
+	voxelizeCmd->SetParameter(enable);
+	voxelizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	voxelizeCmd->SetToBeBroadcasted(false);
+
+	benchmarkCmd = new G4UIcmdWithAnInteger("/matrix/geometry/benchmark", this);
+	benchmarkCmd->SetGuidance("Time voxelization and the navigation of N random straight rays.");
+	benchmarkCmd->SetParameterName("N", true);
+	benchmarkCmd->SetDefaultValue(100000);
+	benchmarkCmd->SetRange("N>0");
+	benchmarkCmd->AvailableForStates(G4State_Idle);
+	benchmarkCmd->SetToBeBroadcasted(false);
+
+}
+
+DetectorMessenger::~DetectorMessenger()
+{
+
+	delete benchmarkCmd;
+	delete voxelizeCmd;
+	delete smartlessCmd;
+	delete exportCmd;
+	delete geometryDir;
+
+}
+
+void DetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == exportCmd)
+		detector->ExportGDML(newValue);
+
+	else if(command == smartlessCmd){
+		std::istringstream is(newValue);
+		G4String name;
+		G4double value;
+		is >> name >> value;
+		detector->SetSmartless(name, value);
+	}
+
+	else if(command == voxelizeCmd){
+		std::istringstream is(newValue);
+		G4String name, enable;
+		is >> name >> enable;
+		detector->SetVoxelization(name, G4UIcommand::ConvertToBool(enable));
+	}
+
+	else if(command == benchmarkCmd)
+		detector->BenchmarkNavigation(benchmarkCmd->GetNewIntValue(newValue));
+
+}
@@ -0,0 +1,123 @@
+#include "DetectorParameters.hh"
+
+#include <cmath>
+
+//Out of class definitions for odr-used constants (C++11)
+constexpr G4double MatrixDimensions::CoreR;
+constexpr G4double MatrixDimensions::Clad1R;
+constexpr G4double MatrixDimensions::Clad2R;
+constexpr G4double MatrixDimensions::Phi;
+constexpr G4double MatrixDimensions::Cx;
+constexpr G4double MatrixDimensions::Cy;
+constexpr G4double MatrixDimensions::Cz;
+constexpr G4double MatrixDimensions::CG;
+constexpr G4double MatrixDimensions::CSx;
+constexpr G4double MatrixDimensions::CSy;
+constexpr G4double MatrixDimensions::CSz;
+constexpr G4double MatrixDimensions::Pz;
+constexpr G4double MatrixDimensions::ROh;
+constexpr G4double MatrixDimensions::ROd;
+constexpr G4double MatrixDimensions::MG;
+constexpr G4double MatrixDimensions::Tol;
+constexpr G4double MatrixDimensions::Sx;
+constexpr G4double MatrixDimensions::Sz;
+constexpr G4double MatrixDimensions::Mz;
+constexpr G4double MatrixDimensions::Dx;
+constexpr G4double MatrixDimensions::Dy;
+constexpr G4double MatrixDimensions::Dz;
+constexpr G4double MatrixDimensions::Wx;
+constexpr G4double MatrixDimensions::Wy;
+constexpr G4double MatrixDimensions::Wz;
+
+constexpr G4int RuntimeMatrixParameters::maxX;
+constexpr G4int RuntimeMatrixParameters::maxY;
+
+//Same array as the compile-time default until SetArray
+G4int RuntimeMatrixParameters::nx = MATRIX_ARRAY;
+G4int RuntimeMatrixParameters::ny = MATRIX_ARRAY;
+G4double RuntimeMatrixParameters::Px = MATRIX_ARRAY*CSx;
+G4double RuntimeMatrixParameters::Py = MATRIX_ARRAY*CSy;
+G4double RuntimeMatrixParameters::ROw = MATRIX_ARRAY*CSx;
+G4double RuntimeMatrixParameters::RODiv = CSx;
+G4double RuntimeMatrixParameters::Sy = MATRIX_ARRAY*CSy;
+G4double RuntimeMatrixParameters::Mx = MATRIX_ARRAY*CSx;
+G4double RuntimeMatrixParameters::My = MATRIX_ARRAY*CSy;
+
+void RuntimeMatrixParameters::SetArray(G4int x, G4int y)
+{
+
+	//Same checks as the static_asserts of MatrixParameters
+	if(x <= 0 || y <= 0 || x > maxX || y > maxY){
+		G4ExceptionDescription msg;
+		msg<<"Array of "<<x<<"x"<<y<<" crystals, 1 to "<<maxX<<"x"<<maxY<<" supported.";
+		G4Exception("RuntimeMatrixParameters::SetArray", "Parameters001", FatalException, msg);
+		return;
+	}
+	if(x != y){
+		G4Exception("RuntimeMatrixParameters::SetArray", "Parameters002", FatalException,
+			    "The fiber planes need a square array.");
+		return;
+	}
+	if(x*CSx >= Dx || y*CSy >= Dy){
+		G4Exception("RuntimeMatrixParameters::SetArray", "Parameters003", FatalException,
+			    "Matrix wider than the detector.");
+		return;
+	}
+
+	nx = x;
+	ny = y;
+	Px = nx*CSx;
+	Py = ny*CSy;
+	ROw = Px;
+	RODiv = ROw/nx;
+	Sy = Py;
+	Mx = nx*CSx;
+	My = ny*CSy;
+
+}
+
+//A single module unless SetTiling
+G4int ModuleTiling::nModulesX = 1;
+G4int ModuleTiling::nModulesY = 1;
+
+void ModuleTiling::SetTiling(G4int mx, G4int my)
+{
+
+	if(mx <= 0 || my <= 0){
+		G4ExceptionDescription msg;
+		msg<<"Tiling of "<<mx<<"x"<<my<<" modules, at least one per side needed.";
+		G4Exception("ModuleTiling::SetTiling", "Parameters004", FatalException, msg);
+		return;
+	}
+
+	nModulesX = mx;
+	nModulesY = my;
+
+}
+
+void ModuleTiling::DecodeChannel(G4int id, G4int& module, G4int& axis, G4int& channel)
+{
+
+	module = id/(nx + ny);
+	channel = id%(nx + ny);
+	axis = 1;
+	if(channel >= nx){
+		axis = 2;
+		channel -= nx;
+	}
+
+}
+
+G4bool ModuleTiling::Locate(G4double x, G4double y, G4int& module, G4int& ix, G4int& iy)
+{
+
+	G4int mx = (G4int)std::floor((x + PlaneX())/(2.*ModuleX()));
+	G4int my = (G4int)std::floor((y + PlaneY())/(2.*ModuleY()));
+	if(mx < 0 || mx >= nModulesX || my < 0 || my >= nModulesY) return false;
+
+	module = Module(mx, my);
+	ix = (G4int)std::floor((x - ModuleCentreX(mx) + Mx)/(2.*CSx));
+	iy = (G4int)std::floor((y - ModuleCentreY(my) + My)/(2.*CSy));
+	return ix >= 0 && ix < nx && iy >= 0 && iy < ny;
+
+}
@@ -10,16 +10,12 @@
 
 DetectorROGeometry::DetectorROGeometry()
   : G4VReadOutGeometry()
-{
-#include "DetectorParameterDef.icc"
-}
+{}
 
 
 DetectorROGeometry::DetectorROGeometry(G4String aString)
   : G4VReadOutGeometry(aString)
-{
-#include "DetectorParameterDef.icc"
-}
+{}
 
 DetectorROGeometry::~DetectorROGeometry()
 {}
@@ -33,17 +29,17 @@ G4VPhysicalVolume* DetectorROGeometry::Build()
 	//Builds the readout world:
 	G4Box* pROWorldSolid = new G4Box("ROWorldSolid", Wx, Wy, Wz);
 	G4LogicalVolume* pROWorldLog = new G4LogicalVolume(pROWorldSolid, dummyMat, "ROWorldLogical");
-	G4PVPlacement* pROWorldPhys = new G4PVPlacement(Id_rot,Id_tr,"ROWorldPhysical",pROWorldLog,0,false,0);
+	G4PVPlacement* pROWorldPhys = new G4PVPlacement(0,G4ThreeVector(),"ROWorldPhysical",pROWorldLog,0,false,0);
 
 	//Readout geometry
 	G4Box* pROSolid_X = new G4Box("ROBox_X", ROw, ROh, ROd);
 	G4Box* pROSolid_Y = new G4Box("ROBox_Y", ROh, ROw, ROd);
 	G4LogicalVolume* pROLog_X = new G4LogicalVolume(pROSolid_X, dummyMat, "ROLogical_X");
 	G4LogicalVolume* pROLog_Y = new G4LogicalVolume(pROSolid_Y, dummyMat, "ROLogical_Y");
-	G4VPhysicalVolume* ROPhys_X = new G4PVPlacement(Id_rot, Id_tr, pROLog_X, "RO_X", pROWorldLog, false, 0);
-	G4VPhysicalVolume* ROPhys_Y = new G4PVPlacement(Id_rot, Id_tr, pROLog_Y, "RO_Y", pROWorldLog, false, 0);
+	G4VPhysicalVolume* ROPhys_X = new G4PVPlacement(0, G4ThreeVector(), pROLog_X, "RO_X", pROWorldLog, false, 0);
+	G4VPhysicalVolume* ROPhys_Y = new G4PVPlacement(0, G4ThreeVector(), pROLog_Y, "RO_Y", pROWorldLog, false, 0);
 	
-	//Readout Division: 25 slices
+	//Readout Division: one slice per crystal
 	G4Box* pRODivSolid_X = new G4Box("RODivBox_X", RODiv, ROh, ROd);
 	G4Box* pRODivSolid_Y = new G4Box("RODivBox_Y", ROh, RODiv, ROd);
 	G4LogicalVolume* pRODivLog_X = new G4LogicalVolume(pRODivSolid_X, dummyMat, "RODivLogical_X");
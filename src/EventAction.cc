@@ -1,7 +1,32 @@
+#include "Analysis.hh"
 #include "EventAction.hh"
+#include "RunAction.hh"
+#include "RunCheckpoint.hh"
+#include "ConvergenceMonitor.hh"
+#include "LiveMonitor.hh"
+#include "TrackingAction.hh"
+#include "SubEventScheduler.hh"
+#include "MemoryMonitor.hh"
+#include "StackLimiter.hh"
+#include "BiasingMonitor.hh"
+#include "DepositRecorder.hh"
+#include "TimingRecorder.hh"
+#include "Run.hh"
+#include "CrystalPhotonModel.hh"
+#include "Hits.hh"
+#include "EventArena.hh"
+#include "StartupTimer.hh"
+#include "DetectorParameters.hh"
 #include "G4Event.hh"
+#include "G4RunManager.hh"
+#include "G4EventManager.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
 
-EventAction::EventAction()
+EventAction::EventAction(RunAction* run)
+	: G4UserEventAction(),
+	  runAction(run),
+	  hcID(-1)
 {}
 
 EventAction::~EventAction()
@@ -9,10 +34,82 @@ EventAction::~EventAction()
 
 void EventAction::BeginOfEventAction(const G4Event* event){
 
-	G4cout<<"Event "<<event->GetEventID()<<" start."<<G4endl;
+	StartupTimer::FirstEvent();
+
+	//Hits and batches of the previous event are gone by now
+	EventArena::Instance()->Reset();
+
+	runAction->GetSubEventScheduler()->BeginOfEvent();
+	runAction->GetBiasingMonitor()->BeginOfEvent();
+
+	G4int printModulo = G4RunManager::GetRunManager()->GetPrintProgress();
+	if(printModulo > 0 && event->GetEventID()%printModulo == 0)
+		G4cout<<"Event "<<event->GetEventID()<<" start."<<G4endl;
 }
 
 void EventAction::EndOfEventAction(const G4Event* event){
 
-	G4cout<<"Event "<<event->GetEventID()<<" done."<<G4endl;
+	Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	run->AddPrimaries(event->GetNumberOfPrimaryVertex());
+
+	//Photons still gathered in the crystal tracer finish first
+	CrystalPhotonModel* tracer = CrystalPhotonModel::GetInstance();
+	if(tracer) tracer->FlushEvent();
+
+	HitsCollection* hits = GetHits(event);
+
+	//Batched optical photons are tracked before the event is read out
+	G4long batchPhotons = 0;
+	SubEventScheduler* scheduler = runAction->GetSubEventScheduler();
+	if(scheduler->IsEnabled())
+		batchPhotons = scheduler->FinishEvent(hits, run);
+
+	RunCheckpoint* checkpoint = runAction->GetCheckpoint();
+	if(hits) FillOutput(event, hits, checkpoint->IsActive() ? checkpoint : 0);
+	checkpoint->EndOfEvent(event->GetEventID());
+
+	runAction->GetConvergenceMonitor()->EndOfEvent(event, hits);
+	runAction->GetTimingRecorder()->EndOfEvent(event, hits, run);
+
+	LiveMonitor* monitor = runAction->GetLiveMonitor();
+	if(monitor->IsActive()){
+		const TrackingAction* tracking = static_cast<const TrackingAction*>(G4EventManager::GetEventManager()->GetUserTrackingAction());
+		monitor->EndOfEvent(hits, batchPhotons + (tracking ? tracking->getOpticalPhotons() : 0));
+	}
+
+	runAction->GetStackLimiter()->EndOfEvent(event->GetEventID(), run);
+	runAction->GetBiasingMonitor()->EndOfEvent(hits, run);
+	runAction->GetDepositRecorder()->EndOfEvent(event->GetEventID(), run);
+	runAction->GetMemoryMonitor()->EndOfEvent(run);
+}
+
+HitsCollection* EventAction::GetHits(const G4Event* event){
+
+	G4HCofThisEvent* hce = event->GetHCofThisEvent();
+	if(!hce) return 0;
+	if(hcID < 0) hcID = G4SDManager::GetSDMpointer()->GetCollectionID("LYSOHitsCollection");
+	return static_cast<HitsCollection*>(hce->GetHC(hcID));
+}
+
+void EventAction::FillOutput(const G4Event* event, HitsCollection* hits, RunCheckpoint* journal){
+
+	//One row per detected photon, tagged with the primary it came from
+	G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
+	G4int eventID = event->GetEventID();
+	G4int nHits = hits->entries();
+	for(G4int i = 0; i < nHits; i++){
+		Hits* hit = (*hits)[i];
+		analysisManager->FillNtupleIColumn(0,eventID);
+		analysisManager->FillNtupleIColumn(1,hit->getAxis());
+		analysisManager->FillNtupleIColumn(2,hit->getChannel());
+		analysisManager->FillNtupleIColumn(3,hit->getPrimary());
+		analysisManager->FillNtupleDColumn(4,hit->getWeight());
+		analysisManager->FillNtupleIColumn(5,hit->getModule());
+		analysisManager->AddNtupleRow();
+
+		//Channels of all modules, one axis per histogram
+		analysisManager->FillH1(hit->getAxis(),ModuleTiling::AxisChannel(hit->getModule(),hit->getAxis(),hit->getChannel()),hit->getWeight());
+
+		if(journal) journal->Record(eventID, hit->getModule(), hit->getAxis(), hit->getChannel(), hit->getPrimary(), hit->getWeight());
+	}
 }
@@ -0,0 +1,209 @@
+#include "EventArena.hh"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+namespace {
+
+	//Settings for chunks mapped from now on, shared by all threads
+	std::size_t chunkSize = 4*1024*1024;
+	G4bool hugePages = false;
+
+	const std::size_t kHugePage = 2*1024*1024;
+
+	//Never deleted, blocks of kept events may outlive the thread
+	G4ThreadLocal EventArena* arena = 0;
+
+	void PageFaults(long& minor, long& major)
+	{
+		struct rusage usage;
+#ifdef RUSAGE_THREAD
+		G4int who = RUSAGE_THREAD;
+#else
+		G4int who = RUSAGE_SELF;
+#endif
+		if(getrusage(who, &usage) != 0){
+			minor = major = 0;
+			return;
+		}
+		minor = usage.ru_minflt;
+		major = usage.ru_majflt;
+	}
+
+}
+
+void EventArena::Statistics::Clear()
+{
+	allocations = bytes = reusedBytes = highWater = resets = deferred = 0;
+	chunks = hugeChunks = reserved = minorFaults = majorFaults = 0;
+}
+
+void EventArena::Statistics::Merge(const Statistics& other)
+{
+	allocations += other.allocations;
+	bytes += other.bytes;
+	reusedBytes += other.reusedBytes;
+	highWater = std::max(highWater, other.highWater);
+	resets += other.resets;
+	deferred += other.deferred;
+	chunks += other.chunks;
+	hugeChunks += other.hugeChunks;
+	reserved += other.reserved;
+	minorFaults += other.minorFaults;
+	majorFaults += other.majorFaults;
+}
+
+EventArena* EventArena::Instance()
+{
+	if(!arena) arena = new EventArena();
+	return arena;
+}
+
+EventArena::EventArena()
+	: current(-1),
+	  base(0),
+	  offset(0),
+	  limit(0),
+	  touched(0),
+	  used(0),
+	  reserved(0),
+	  live(0),
+	  allocations(0),
+	  bytes(0),
+	  reusedBytes(0),
+	  highWater(0),
+	  resets(0),
+	  deferred(0),
+	  minorFaults(0),
+	  majorFaults(0)
+{
+	statistics.Clear();
+}
+
+void EventArena::SetChunkSize(G4double value)
+{
+	chunkSize = value > 64*1024 ? (std::size_t)value : 64*1024;
+}
+
+void EventArena::SetHugePages(G4bool value)
+{
+	hugePages = value;
+}
+
+void EventArena::Reset()
+{
+
+	highWater = std::max(highWater, used);
+
+	if(live.load(std::memory_order_acquire) != 0){
+		deferred++;
+		return;
+	}
+
+	if(current >= 0) chunks[current].touched = touched;
+	current = -1;
+	base = 0;
+	offset = limit = touched = 0;
+	used = 0;
+	resets++;
+
+}
+
+void* EventArena::Grow(std::size_t need)
+{
+
+	//The rest of the chunk is lost until the next rewind
+	if(current >= 0){
+		chunks[current].touched = touched;
+		used += limit - offset;
+	}
+
+	G4int next = current + 1;
+	while(next < (G4int)chunks.size() && chunks[next].size < need) next++;
+	if(next == (G4int)chunks.size()) Map(need);
+	Select(next);
+
+	return Take(need);
+
+}
+
+void EventArena::Select(G4int index)
+{
+	current = index;
+	base = chunks[index].base;
+	offset = 0;
+	limit = chunks[index].size;
+	touched = chunks[index].touched;
+}
+
+void EventArena::Map(std::size_t need)
+{
+
+	Chunk chunk;
+	chunk.size = std::max(need, chunkSize);
+	chunk.touched = 0;
+	chunk.huge = false;
+	chunk.base = 0;
+
+	if(hugePages){
+		chunk.size = (chunk.size + kHugePage - 1)/kHugePage*kHugePage;
+#ifdef MAP_HUGETLB
+		//Reserved huge pages first, see /proc/sys/vm/nr_hugepages
+		void* p = mmap(0, chunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if(p != MAP_FAILED){
+			chunk.base = static_cast<char*>(p);
+			chunk.huge = true;
+		}
+#endif
+	}
+
+	if(!chunk.base){
+		void* p = mmap(0, chunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(p == MAP_FAILED){
+			G4ExceptionDescription msg;
+			msg << "Cannot map an arena chunk of " << chunk.size << " bytes";
+			G4Exception("EventArena::Map", "Arena001", FatalException, msg);
+			return;
+		}
+		chunk.base = static_cast<char*>(p);
+#ifdef MADV_HUGEPAGE
+		//Otherwise transparent huge pages, where the kernel allows them
+		if(hugePages) madvise(p, chunk.size, MADV_HUGEPAGE);
+#endif
+	}
+
+	chunks.push_back(chunk);
+	reserved += chunk.size;
+
+}
+
+void EventArena::BeginOfRun()
+{
+	allocations = bytes = reusedBytes = 0;
+	highWater = used;
+	resets = deferred = 0;
+	PageFaults(minorFaults, majorFaults);
+}
+
+const EventArena::Statistics& EventArena::EndOfRun()
+{
+
+	long minor = 0, major = 0;
+	PageFaults(minor, major);
+
+	statistics.Clear();
+	statistics.allocations = allocations;
+	statistics.bytes = bytes;
+	statistics.reusedBytes = reusedBytes;
+	statistics.highWater = std::max(highWater, used);
+	statistics.resets = resets;
+	statistics.deferred = deferred;
+	statistics.chunks = chunks.size();
+	for(std::size_t i = 0; i < chunks.size(); i++)
+		if(chunks[i].huge) statistics.hugeChunks++;
+	statistics.reserved = reserved;
+	statistics.minorFaults = minor - minorFaults;
+	statistics.majorFaults = major - majorFaults;
+	return statistics;
+
+}
@@ -0,0 +1,117 @@
+#include "ForkLauncher.hh"
+#include "RunAction.hh"
+#include "RunCheckpoint.hh"
+#include "DepositRecorder.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include "TFileMerger.h"
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+G4int ForkLauncher::Run(G4RunManager* runManager, G4int nWorkers, G4int nEvents, long seed)
+{
+
+	//Physics tables are built before the fork, once
+	runManager->BeamOn(0);
+
+	const RunAction* runAction = static_cast<const RunAction*>(runManager->GetUserRunAction());
+	G4String fileName = runAction->GetFileName();
+
+	//Buffered output would be written again by every worker
+	G4cout.flush();
+	std::fflush(0);
+
+	std::vector<pid_t> workers;
+	for(G4int k = 0; k < nWorkers; k++){
+		pid_t pid = fork();
+		if(pid < 0){
+			G4Exception("ForkLauncher::Run", "Fork001", JustWarning, "fork failed, running fewer workers.");
+			break;
+		}
+		if(pid == 0){
+			RunWorker(runManager, k, nWorkers, nEvents, seed);
+			_exit(0);
+		}
+		workers.push_back(pid);
+	}
+
+	G4int failed = nWorkers - (G4int)workers.size();
+	for(std::size_t k = 0; k < workers.size(); k++){
+		int status = 0;
+		if(waitpid(workers[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+			G4ExceptionDescription msg;
+			msg << "Worker " << k << " (pid " << workers[k] << ") failed, its output is not merged.";
+			G4Exception("ForkLauncher::Run", "Fork002", JustWarning, msg);
+			failed++;
+		}
+	}
+	if(failed) return 1;
+
+	return Merge(fileName, nWorkers) ? 0 : 1;
+
+}
+
+void ForkLauncher::RunWorker(G4RunManager* runManager, G4int worker, G4int nWorkers, G4int nEvents, long seed)
+{
+
+	G4int first = (G4int)((long long)nEvents*worker/nWorkers);
+	G4int last = (G4int)((long long)nEvents*(worker + 1)/nWorkers);
+
+	G4Random::setTheSeed(seed + worker);
+
+	RunAction* runAction = const_cast<RunAction*>(static_cast<const RunAction*>(runManager->GetUserRunAction()));
+	std::ostringstream suffix;
+	suffix << "_p" << worker;
+	runAction->SetFileName(runAction->GetFileName() + suffix.str());
+	RunCheckpoint* checkpoint = runAction->GetCheckpoint();
+	checkpoint->SetDirectory(checkpoint->GetDirectory() + suffix.str());
+	DepositRecorder* deposits = runAction->GetDepositRecorder();
+	if(deposits->GetFileName() != "") deposits->SetFileName(deposits->GetFileName() + suffix.str());
+
+	std::ostringstream firstEvent;
+	firstEvent << "/matrix/source/firstEvent " << first;
+	G4UImanager::GetUIpointer()->ApplyCommand(firstEvent.str());
+
+	G4cout<<"Worker "<<worker<<" (pid "<<getpid()<<"): events "<<first<<" to "<<last - 1<<G4endl;
+	if(last > first) runManager->BeamOn(last - first);
+
+	G4cout.flush();
+	std::fflush(0);
+
+}
+
+G4bool ForkLauncher::Merge(const G4String& fileName, G4int nWorkers)
+{
+
+	TFileMerger merger(false);
+	if(!merger.OutputFile((fileName + ".root").c_str(), "RECREATE")){
+		G4Exception("ForkLauncher::Merge", "Fork003", JustWarning, "Cannot create the merged output.");
+		return false;
+	}
+
+	std::vector<G4String> parts;
+	for(G4int k = 0; k < nWorkers; k++){
+		std::ostringstream part;
+		part << fileName << "_p" << k << ".root";
+		parts.push_back(part.str());
+		merger.AddFile(part.str().c_str(), false);
+	}
+
+	if(!merger.Merge()){
+		G4Exception("ForkLauncher::Merge", "Fork004", JustWarning, "Merging the worker outputs failed, they are kept.");
+		return false;
+	}
+	for(std::size_t k = 0; k < parts.size(); k++) std::remove(parts[k].c_str());
+
+	G4cout<<"Merged the output of "<<nWorkers<<" workers into "<<fileName<<".root"<<G4endl;
+	return true;
+
+}
@@ -0,0 +1,62 @@
+#include "GeometryBenchmark.hh"
+
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4VSolid.hh"
+#include "G4VisExtent.hh"
+#include "G4ThreeVector.hh"
+#include "G4Timer.hh"
+#include "G4PhysicalConstants.hh"
+#include "CLHEP/Random/MixMaxRng.h"
+
+#include <cmath>
+
+void GeometryBenchmark::Run(G4VPhysicalVolume* world, G4int nRays)
+{
+
+	//Rays start in the detector envelope, or anywhere in the world
+	G4VPhysicalVolume* envelope = G4PhysicalVolumeStore::GetInstance()->GetVolume("Detector", false);
+	if(!envelope || envelope->GetMotherLogical() != world->GetLogicalVolume()) envelope = world;
+	G4VisExtent extent = envelope->GetLogicalVolume()->GetSolid()->GetExtent();
+	G4ThreeVector offset = envelope == world ? G4ThreeVector() : envelope->GetTranslation();
+
+	G4Navigator navigator;
+	navigator.SetWorldVolume(world);
+	CLHEP::MixMaxRng engine(12345);
+
+	const G4int maxSteps = 100000;
+	G4long steps = 0;
+	G4Timer timer;
+	timer.Start();
+
+	for(G4int i = 0; i < nRays; i++){
+		G4ThreeVector position(extent.GetXmin() + engine.flat()*(extent.GetXmax() - extent.GetXmin()),
+				       extent.GetYmin() + engine.flat()*(extent.GetYmax() - extent.GetYmin()),
+				       extent.GetZmin() + engine.flat()*(extent.GetZmax() - extent.GetZmin()));
+		position += offset;
+		G4double cosTheta = 2.*engine.flat() - 1.;
+		G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+		G4double phi = twopi*engine.flat();
+		G4ThreeVector direction(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+
+		G4VPhysicalVolume* volume = navigator.LocateGlobalPointAndSetup(position, &direction, false, false);
+		for(G4int n = 0; volume && n < maxSteps; n++){
+			G4double safety = 0;
+			G4double step = navigator.ComputeStep(position, direction, kInfinity, safety);
+			if(step == kInfinity) break;
+			position += step*direction;
+			navigator.SetGeometricallyLimitedStep();
+			volume = navigator.LocateGlobalPointAndSetup(position, &direction, true, false);
+			steps++;
+		}
+	}
+
+	timer.Stop();
+	G4double seconds = timer.GetRealElapsed();
+	G4cout<<"  "<<nRays<<" rays, "<<steps<<" steps in "<<seconds<<" s";
+	if(seconds > 0) G4cout<<" ("<<steps/seconds<<" steps/s)";
+	G4cout<<G4endl;
+
+}
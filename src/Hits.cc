@@ -7,19 +7,29 @@
 
 #include <iomanip>
 
-G4Allocator<Hits> HitAllocator;
-
 Hits::Hits()
 	: G4VHit(),
 	  energy(0),
-	  pos(G4ThreeVector())
+	  pos(G4ThreeVector()),
+	  time(0),
+	  module(0),
+	  axis(0),
+	  channel(0),
+	  primary(0),
+	  weight(1.)
 {}
 
-Hits::Hits(G4double Energy, G4ThreeVector Pos){
-
-	energy	= Energy;
-	pos = Pos;
-}
+Hits::Hits(G4double Energy, G4ThreeVector Pos)
+	: G4VHit(),
+	  energy(Energy),
+	  pos(Pos),
+	  time(0),
+	  module(0),
+	  axis(0),
+	  channel(0),
+	  primary(0),
+	  weight(1.)
+{}
 
 Hits::~Hits()
 {}
@@ -41,5 +51,7 @@ void Hits::Draw(){
 
 void Hits::Print()
 {
-	G4cout<<"Energy: "<<std::setw(7) << G4BestUnit(energy,"Energy")<<G4endl;
+	G4cout<<"Energy: "<<std::setw(7) << G4BestUnit(energy,"Energy")
+	      <<"\tTime: "<<G4BestUnit(time,"Time")
+	      <<"\tModule: "<<module<<"\tAxis: "<<axis<<"\tChannel: "<<channel<<"\tPrimary: "<<primary<<"\tWeight: "<<weight<<G4endl;
 }
@@ -0,0 +1,212 @@
+#include "LiveMonitor.hh"
+#include "LiveMonitorSegment.hh"
+#include "LiveMonitorMessenger.hh"
+
+#include "G4Run.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//The shared segment holds every channel of the largest array
+static_assert(DetectorParameters::maxX <= LiveMonitorSegment::kMaxChannels
+	      && DetectorParameters::maxY <= LiveMonitorSegment::kMaxChannels, "channels beyond the live monitor segment");
+
+namespace {
+
+	//Segment of this process, created by the master thread
+	std::atomic<LiveMonitorSegment*> segment(0);
+	G4String segmentOwned = "";
+
+	int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t ResidentBytes()
+	{
+		unsigned long size = 0, resident = 0;
+		std::FILE* statm = std::fopen("/proc/self/statm", "r");
+		if(!statm) return 0;
+		if(std::fscanf(statm, "%lu %lu", &size, &resident) != 2) resident = 0;
+		std::fclose(statm);
+		return (uint64_t)resident*sysconf(_SC_PAGESIZE);
+	}
+
+}
+
+LiveMonitor::LiveMonitor()
+	: messenger(0),
+	  segmentName(""),
+	  interval(1.),
+	  owner(false),
+	  events(0),
+	  tracked(0),
+	  detected(0),
+	  sinceCheck(0)
+{
+	channelX.fill(0);
+	channelY.fill(0);
+	messenger = new LiveMonitorMessenger(this);
+}
+
+LiveMonitor::~LiveMonitor()
+{
+
+	delete messenger;
+
+	//The segment outlives the run so the viewer can show the final state,
+	//it goes away with the job
+	if(owner){
+		LiveMonitorSegment* shm = segment.exchange(0);
+		if(shm) munmap(shm, sizeof(LiveMonitorSegment));
+		shm_unlink(segmentOwned.c_str());
+		segmentOwned = "";
+	}
+
+}
+
+G4bool LiveMonitor::IsActive() const
+{
+	return segment.load(std::memory_order_relaxed) != 0;
+}
+
+G4bool LiveMonitor::Create()
+{
+
+	if(segmentOwned == segmentName) return true;
+
+	LiveMonitorSegment* old = segment.exchange(0);
+	if(old){
+		munmap(old, sizeof(LiveMonitorSegment));
+		shm_unlink(segmentOwned.c_str());
+		segmentOwned = "";
+	}
+	if(segmentName == "") return false;
+
+	int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if(fd < 0 || ftruncate(fd, sizeof(LiveMonitorSegment)) != 0){
+		if(fd >= 0) close(fd);
+		G4ExceptionDescription msg;
+		msg << "Cannot create shared-memory segment " << segmentName;
+		G4Exception("LiveMonitor::Create", "Monitor001", JustWarning, msg);
+		return false;
+	}
+	void* address = mmap(0, sizeof(LiveMonitorSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED){
+		shm_unlink(segmentName.c_str());
+		G4ExceptionDescription msg;
+		msg << "Cannot map shared-memory segment " << segmentName;
+		G4Exception("LiveMonitor::Create", "Monitor002", JustWarning, msg);
+		return false;
+	}
+
+	//A fresh segment is zero filled, which is a valid initial state
+	LiveMonitorSegment* shm = static_cast<LiveMonitorSegment*>(address);
+	std::strncpy(shm->magic, "MTXMON1", sizeof(shm->magic));
+	shm->version = 1;
+	shm->pid = getpid();
+
+	segmentOwned = segmentName;
+	owner = true;
+	segment.store(shm);
+
+	G4cout<<"Live monitor published in shared memory "<<segmentName<<G4endl;
+	return true;
+
+}
+
+void LiveMonitor::BeginOfRun(const G4Run* run)
+{
+
+	events = tracked = detected = 0;
+	channelX.fill(0);
+	channelY.fill(0);
+	sinceCheck = 0;
+	lastFlush = std::chrono::steady_clock::now();
+
+	//The master starts every run before the workers
+	if(!G4Threading::IsMasterThread() || !Create()) return;
+
+	LiveMonitorSegment* shm = segment.load();
+	shm->nChannelsX = nx;
+	shm->nChannelsY = ny;
+	shm->runID.store(run->GetRunID());
+	shm->eventsRequested.store(run->GetNumberOfEventToBeProcessed());
+	shm->events.store(0);
+	shm->photonsTracked.store(0);
+	shm->photonsDetected.store(0);
+	for(G4int i = 0; i < LiveMonitorSegment::kMaxChannels; i++){
+		shm->channelX[i].store(0);
+		shm->channelY[i].store(0);
+	}
+	shm->residentBytes.store(ResidentBytes());
+	shm->startTime.store(Now());
+	shm->state.store(LiveMonitorSegment::kRunning);
+	shm->updateTime.store(Now(), std::memory_order_release);
+
+}
+
+void LiveMonitor::EndOfEvent(HitsCollection* hits, G4int photonsTracked)
+{
+
+	if(!IsActive()) return;
+
+	events++;
+	tracked += photonsTracked;
+	G4int nHits = hits ? hits->entries() : 0;
+	detected += nHits;
+	//The segment has a fixed layout: channels of all modules add up
+	for(G4int i = 0; i < nHits; i++){
+		Hits* hit = (*hits)[i];
+		G4int channel = hit->getChannel();
+		if(channel < 0) continue;
+		if(hit->getAxis() == 1 && channel < nx) channelX[channel]++;
+		else if(hit->getAxis() == 2 && channel < ny) channelY[channel]++;
+	}
+
+	//The clock is read only every few events
+	if(++sinceCheck < 16) return;
+	sinceCheck = 0;
+	if(std::chrono::duration<G4double>(std::chrono::steady_clock::now() - lastFlush).count() >= interval) Flush();
+
+}
+
+void LiveMonitor::EndOfRun(const G4Run*)
+{
+
+	if(!IsActive()) return;
+
+	Flush();
+	if(owner) segment.load()->state.store(LiveMonitorSegment::kDone);
+
+}
+
+void LiveMonitor::Flush()
+{
+
+	LiveMonitorSegment* shm = segment.load();
+	if(!shm) return;
+
+	shm->events.fetch_add(events, std::memory_order_relaxed);
+	shm->photonsTracked.fetch_add(tracked, std::memory_order_relaxed);
+	shm->photonsDetected.fetch_add(detected, std::memory_order_relaxed);
+	for(G4int i = 0; i < nx; i++)
+		if(channelX[i]){ shm->channelX[i].fetch_add(channelX[i], std::memory_order_relaxed); channelX[i] = 0; }
+	for(G4int i = 0; i < ny; i++)
+		if(channelY[i]){ shm->channelY[i].fetch_add(channelY[i], std::memory_order_relaxed); channelY[i] = 0; }
+	events = tracked = detected = 0;
+
+	shm->residentBytes.store(ResidentBytes(), std::memory_order_relaxed);
+	shm->updateTime.store(Now(), std::memory_order_release);
+	lastFlush = std::chrono::steady_clock::now();
+
+}
@@ -0,0 +1,51 @@
+#include "LiveMonitorMessenger.hh"
+#include "LiveMonitor.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+
+LiveMonitorMessenger::LiveMonitorMessenger(LiveMonitor* mon)
+	: G4UImessenger(),
+	  monitor(mon)
+{
+
+	monitorDir = new G4UIdirectory("/matrix/monitor/");
+	monitorDir->SetGuidance("Live monitoring through shared memory (tools/matrix_monitor).");
+
+	segmentCmd = new G4UIcmdWithAString("/matrix/monitor/segment", this);
+	segmentCmd->SetGuidance("Name of the shared-memory segment, e.g. /matrix, none disables it.");
+	segmentCmd->SetGuidance("Takes effect at the next run.");
+	segmentCmd->SetParameterName("name", false);
+	segmentCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	intervalCmd = new G4UIcmdWithADouble("/matrix/monitor/interval", this);
+	intervalCmd->SetGuidance("Seconds between two updates of the segment by a thread.");
+	intervalCmd->SetParameterName("seconds", false);
+	intervalCmd->SetRange("seconds>0.");
+	intervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+LiveMonitorMessenger::~LiveMonitorMessenger()
+{
+
+	delete intervalCmd;
+	delete segmentCmd;
+	delete monitorDir;
+
+}
+
+void LiveMonitorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == segmentCmd){
+		if(newValue == "none") newValue = "";
+		else if(newValue[0] != '/') newValue = "/" + newValue;
+		monitor->SetSegmentName(newValue);
+	}
+
+	else if(command == intervalCmd)
+		monitor->SetInterval(intervalCmd->GetNewDoubleValue(newValue));
+
+}
@@ -0,0 +1,70 @@
+#include "MappedFile.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile()
+	: fileName(""),
+	  data(0),
+	  size(0)
+{}
+
+MappedFile::~MappedFile()
+{
+
+	Close();
+
+}
+
+G4bool MappedFile::Open(const G4String& name)
+{
+
+	Close();
+
+	int fd = open(name.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size <= 0){
+		close(fd);
+		return false;
+	}
+
+	void* address = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED) return false;
+
+	//The whole file is normally walked front to back
+	madvise(address, info.st_size, MADV_SEQUENTIAL);
+
+	fileName = name;
+	data = static_cast<const char*>(address);
+	size = info.st_size;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+
+	if(data) munmap(const_cast<char*>(data), size);
+	data = 0;
+	size = 0;
+	fileName = "";
+
+}
+
+void MappedFile::Prefetch(std::size_t offset, std::size_t length) const
+{
+
+	if(!data || offset >= size) return;
+	if(length > size - offset) length = size - offset;
+
+	//madvise needs a page aligned start
+	std::size_t page = sysconf(_SC_PAGESIZE);
+	std::size_t start = offset - offset % page;
+	madvise(const_cast<char*>(data) + start, length + (offset - start), MADV_WILLNEED);
+
+}
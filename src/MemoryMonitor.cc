@@ -0,0 +1,268 @@
+#include "MemoryMonitor.hh"
+#include "MemoryMonitorMessenger.hh"
+#include "EventArena.hh"
+#include "Run.hh"
+
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Trajectory.hh"
+#include "G4TrajectoryPoint.hh"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace {
+
+	const char* poolNames[] = {"tracks", "particles", "touchables", "trajectories", "points", "arena"};
+	const G4int nPools = MemoryMonitor::kPools;
+
+	//Progress of the run, shared by all threads for the reports
+	G4Mutex sharedMutex = G4MUTEX_INITIALIZER;
+	std::atomic<G4long> eventsDone(0);
+	G4long warmupEvents = 0;
+	G4long lastReportEvents = 0;
+	G4double lastReportRSS = 0;
+	//Only complete once a thread leaves the run, after its Run is merged
+	EventArena::Statistics sharedArena;
+
+	//Kept open, a pread per event is cheaper than reopening the file
+	G4ThreadLocal int statm = -1;
+
+	G4double ResidentBytes()
+	{
+		if(statm < 0) statm = open("/proc/self/statm", O_RDONLY);
+		if(statm < 0) return 0;
+		char buffer[128];
+		ssize_t n = pread(statm, buffer, sizeof(buffer) - 1, 0);
+		if(n <= 0) return 0;
+		buffer[n] = '\0';
+		unsigned long size = 0, resident = 0;
+		if(std::sscanf(buffer, "%lu %lu", &size, &resident) != 2) return 0;
+		return (G4double)resident*sysconf(_SC_PAGESIZE);
+	}
+
+	G4double MB(G4double bytes)
+	{
+		return bytes/(1024.*1024.);
+	}
+
+	template <class T> G4double PoolBytes(G4Allocator<T>* allocator)
+	{
+		return allocator ? (G4double)allocator->GetAllocatedSize() : 0.;
+	}
+
+	//Pools of the calling thread
+	void SamplePools(G4double* pools)
+	{
+		pools[0] = PoolBytes(aTrackAllocator());
+		pools[1] = PoolBytes(pDynamicParticleAllocator());
+		pools[2] = PoolBytes(aTouchableHistoryAllocator());
+		pools[3] = PoolBytes(aTrajectoryAllocator());
+		pools[4] = PoolBytes(aTrajectoryPointAllocator());
+		pools[5] = EventArena::Instance()->GetReservedBytes();
+	}
+
+	void PrintPools(const G4double* pools)
+	{
+		G4double total = 0;
+		for(G4int i = 0; i < nPools; i++) total += pools[i];
+		G4cout<<MB(total)<<" MB (";
+		for(G4int i = 0; i < nPools; i++)
+			G4cout<<(i ? ", " : "")<<poolNames[i]<<" "<<MB(pools[i]);
+		G4cout<<")";
+	}
+
+	void PrintArena(const EventArena::Statistics& arena)
+	{
+		G4cout<<"Event arena: "<<(G4long)arena.allocations<<" allocations, "<<MB(arena.bytes)<<" MB";
+		if(arena.bytes > 0) G4cout<<", "<<100.*arena.reusedBytes/arena.bytes<<"% reused";
+		G4cout<<", high water "<<MB(arena.highWater)<<" MB per event"<<G4endl
+		      <<"  "<<(G4long)arena.chunks<<" chunks of "<<MB(arena.reserved)<<" MB ("<<(G4long)arena.hugeChunks<<" on huge pages), "
+		      <<(G4long)arena.resets<<" rewinds, "<<(G4long)arena.deferred<<" deferred, page faults "
+		      <<(G4long)arena.minorFaults<<" minor "<<(G4long)arena.majorFaults<<" major"<<G4endl;
+	}
+
+}
+
+void MemoryMonitor::Fit::Add(G4double x, G4double y)
+{
+
+	n += 1;
+	G4double dx = x - meanX;
+	meanX += dx/n;
+	G4double dy = y - meanY;
+	meanY += dy/n;
+	cXX += dx*(x - meanX);
+	cXY += dx*(y - meanY);
+	cYY += dy*(y - meanY);
+
+}
+
+void MemoryMonitor::Fit::Merge(const Fit& other)
+{
+
+	if(other.n == 0) return;
+	G4double total = n + other.n;
+	G4double dx = other.meanX - meanX;
+	G4double dy = other.meanY - meanY;
+	G4double weight = n*other.n/total;
+	meanX += dx*other.n/total;
+	meanY += dy*other.n/total;
+	cXX += other.cXX + dx*dx*weight;
+	cXY += other.cXY + dx*dy*weight;
+	cYY += other.cYY + dy*dy*weight;
+	n = total;
+
+}
+
+G4double MemoryMonitor::Fit::Slope() const
+{
+	return cXX > 0 ? cXY/cXX : 0;
+}
+
+G4double MemoryMonitor::Fit::R2() const
+{
+	return (cXX > 0 && cYY > 0) ? cXY*cXY/(cXX*cYY) : 0;
+}
+
+void MemoryMonitor::Samples::Clear()
+{
+	peak = 0;
+	fit.Clear();
+	std::fill(pools, pools + kPools, 0.);
+	std::fill(poolPeaks, poolPeaks + kPools, 0.);
+}
+
+void MemoryMonitor::Samples::Merge(const Samples& other)
+{
+	peak = std::max(peak, other.peak);
+	fit.Merge(other.fit);
+	for(G4int i = 0; i < kPools; i++){
+		pools[i] += other.pools[i];
+		poolPeaks[i] += other.poolPeaks[i];
+	}
+}
+
+MemoryMonitor::MemoryMonitor()
+	: messenger(0),
+	  enabled(false),
+	  reportEvery(1000),
+	  leakCheck(false),
+	  leakThreshold(100.)
+{
+	messenger = new MemoryMonitorMessenger(this);
+}
+
+MemoryMonitor::~MemoryMonitor()
+{
+	delete messenger;
+}
+
+void MemoryMonitor::BeginOfRun(const G4Run* run)
+{
+
+	EventArena::Instance()->BeginOfRun();
+
+	//The master (or the only thread) starts before any worker and knows
+	//the size of the whole run
+	if(G4Threading::IsMasterThread()){
+		G4AutoLock lock(&sharedMutex);
+		eventsDone = 0;
+		warmupEvents = run->GetNumberOfEventToBeProcessed()/10;
+		lastReportEvents = 0;
+		lastReportRSS = ResidentBytes();
+		sharedArena.Clear();
+	}
+
+}
+
+void MemoryMonitor::EndOfEvent(Run* run)
+{
+
+	if(!IsActive()) return;
+
+	G4long events = eventsDone.fetch_add(1, std::memory_order_relaxed) + 1;
+	G4double rss = ResidentBytes();
+	Samples& samples = run->GetMemorySamples();
+	samples.peak = std::max(samples.peak, rss);
+	if(events > warmupEvents) samples.fit.Add(events, rss);
+
+	SamplePools(samples.pools);
+	for(G4int i = 0; i < nPools; i++) samples.poolPeaks[i] = std::max(samples.poolPeaks[i], samples.pools[i]);
+
+	if(enabled && events%reportEvery == 0) Report(events, rss, samples);
+
+}
+
+void MemoryMonitor::Report(G4long events, G4double rss, const Samples& samples)
+{
+
+	G4AutoLock lock(&sharedMutex);
+
+	G4cout<<"Memory after "<<events<<" events: RSS "<<MB(rss)<<" MB";
+	if(lastReportEvents > 0 || lastReportRSS > 0)
+		G4cout<<" ("<<(rss >= lastReportRSS ? "+" : "")<<MB(rss - lastReportRSS)
+		      <<" MB over "<<events - lastReportEvents<<" events)";
+	G4cout<<", pools ";
+	PrintPools(samples.pools);
+	G4cout<<G4endl;
+
+	lastReportEvents = events;
+	lastReportRSS = rss;
+
+}
+
+void MemoryMonitor::EndOfRun(const G4Run* run)
+{
+
+	//The arena is reported for every run
+	if(!G4Threading::IsMasterThread() || !G4Threading::IsMultithreadedApplication()){
+		G4AutoLock lock(&sharedMutex);
+		sharedArena.Merge(EventArena::Instance()->EndOfRun());
+	}
+	if(G4Threading::IsMasterThread()){
+		G4AutoLock lock(&sharedMutex);
+		PrintArena(sharedArena);
+	}
+
+	//Reported once, from the run the workers were merged into
+	if(!IsActive() || !G4Threading::IsMasterThread()) return;
+
+	const Samples& samples = static_cast<const Run*>(run)->GetMemorySamples();
+	const Fit& fit = samples.fit;
+	struct rusage usage;
+	G4double maxRSS = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss*1024. : 0;
+
+	G4double slope = fit.Slope();
+	G4double r2 = fit.R2();
+	G4cout<<"Memory: peak RSS "<<MB(std::max(samples.peak, maxRSS))<<" MB, RSS at end "<<MB(ResidentBytes())<<" MB"<<G4endl
+	      <<"  allocator pools at end ";
+	PrintPools(samples.pools);
+	G4cout<<G4endl<<"  allocator pools at peak ";
+	PrintPools(samples.poolPeaks);
+	G4cout<<G4endl;
+	if(fit.n > 2)
+		G4cout<<"  after "<<warmupEvents<<" warm-up events RSS grows by "<<slope*reportEvery/1024.
+		      <<" kB per "<<reportEvery<<" events (fit R2 "<<r2<<")"<<G4endl;
+
+	if(!leakCheck) return;
+
+	//A leak is steady growth, not the steps of caches and pools filling up
+	if(fit.n >= 10 && slope > leakThreshold && r2 > 0.9){
+		G4ExceptionDescription msg;
+		msg << "Run " << run->GetRunID() << ": RSS grows linearly with the event count, "
+		    << slope << " bytes/event over " << (G4long)fit.n << " events (R2 " << r2
+		    << ", threshold " << leakThreshold << " bytes/event)";
+		G4Exception("MemoryMonitor::EndOfRun", "Memory001", FatalException, msg);
+	}
+	G4cout<<"  leak check passed"<<G4endl;
+
+}
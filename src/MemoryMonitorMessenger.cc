@@ -0,0 +1,91 @@
+#include "MemoryMonitorMessenger.hh"
+#include "MemoryMonitor.hh"
+#include "EventArena.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+
+MemoryMonitorMessenger::MemoryMonitorMessenger(MemoryMonitor* mon)
+	: G4UImessenger(),
+	  monitor(mon)
+{
+
+	memoryDir = new G4UIdirectory("/matrix/memory/");
+	memoryDir->SetGuidance("Memory usage per event and per run.");
+
+	enableCmd = new G4UIcmdWithABool("/matrix/memory/enable", this);
+	enableCmd->SetGuidance("Sample RSS and allocator pools after every event.");
+	enableCmd->SetParameterName("enable", true);
+	enableCmd->SetDefaultValue(true);
+	enableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	reportEveryCmd = new G4UIcmdWithAnInteger("/matrix/memory/reportEvery", this);
+	reportEveryCmd->SetGuidance("Print memory usage and growth every N events of the run.");
+	reportEveryCmd->SetParameterName("N", false);
+	reportEveryCmd->SetRange("N>0");
+	reportEveryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	leakCheckCmd = new G4UIcmdWithABool("/matrix/memory/leakCheck", this);
+	leakCheckCmd->SetGuidance("Fail the run if RSS grows linearly with the number of events.");
+	leakCheckCmd->SetParameterName("check", true);
+	leakCheckCmd->SetDefaultValue(true);
+	leakCheckCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	leakThresholdCmd = new G4UIcmdWithADouble("/matrix/memory/leakThreshold", this);
+	leakThresholdCmd->SetGuidance("Growth in bytes per event above which a linear trend is a leak.");
+	leakThresholdCmd->SetParameterName("bytes", false);
+	leakThresholdCmd->SetRange("bytes>0.");
+	leakThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	arenaChunkCmd = new G4UIcmdWithAnInteger("/matrix/memory/arenaChunk", this);
+	arenaChunkCmd->SetGuidance("Size in kB of the chunks the event arenas map from now on.");
+	arenaChunkCmd->SetParameterName("kB", false);
+	arenaChunkCmd->SetRange("kB>=64");
+	arenaChunkCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	hugePagesCmd = new G4UIcmdWithABool("/matrix/memory/hugePages", this);
+	hugePagesCmd->SetGuidance("Back new event arena chunks with huge pages, reserved ones if available,");
+	hugePagesCmd->SetGuidance("transparent ones otherwise. Chunks are rounded up to 2 MB.");
+	hugePagesCmd->SetParameterName("huge", true);
+	hugePagesCmd->SetDefaultValue(true);
+	hugePagesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+MemoryMonitorMessenger::~MemoryMonitorMessenger()
+{
+
+	delete hugePagesCmd;
+	delete arenaChunkCmd;
+	delete leakThresholdCmd;
+	delete leakCheckCmd;
+	delete reportEveryCmd;
+	delete enableCmd;
+	delete memoryDir;
+
+}
+
+void MemoryMonitorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == enableCmd)
+		monitor->SetEnabled(enableCmd->GetNewBoolValue(newValue));
+
+	else if(command == reportEveryCmd)
+		monitor->SetReportEvery(reportEveryCmd->GetNewIntValue(newValue));
+
+	else if(command == leakCheckCmd)
+		monitor->SetLeakCheck(leakCheckCmd->GetNewBoolValue(newValue));
+
+	else if(command == leakThresholdCmd)
+		monitor->SetLeakThreshold(leakThresholdCmd->GetNewDoubleValue(newValue));
+
+	else if(command == arenaChunkCmd)
+		EventArena::SetChunkSize(1024.*arenaChunkCmd->GetNewIntValue(newValue));
+
+	else if(command == hugePagesCmd)
+		EventArena::SetHugePages(hugePagesCmd->GetNewBoolValue(newValue));
+
+}
@@ -0,0 +1,172 @@
+#include "PhaseSpaceReader.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstring>
+
+PhaseSpaceReader::PhaseSpaceReader()
+	: records(0),
+	  nRecords(0),
+	  sliceIndex(0),
+	  sliceCount(1),
+	  sliceBegin(0),
+	  sliceEnd(0),
+	  cursor(0),
+	  prefetched(0),
+	  use(0),
+	  recycle(1),
+	  rotate(false),
+	  readAhead(0),
+	  nWraps(0)
+{}
+
+PhaseSpaceReader::~PhaseSpaceReader()
+{}
+
+G4bool PhaseSpaceReader::Open(const G4String& fileName)
+{
+
+	Close();
+
+	if(!file.Open(fileName)){
+		G4ExceptionDescription msg;
+		msg << "Cannot map phase-space file " << fileName;
+		G4Exception("PhaseSpaceReader::Open", "PhaseSpace001", JustWarning, msg);
+		return false;
+	}
+
+	const PhaseSpaceHeader* header = reinterpret_cast<const PhaseSpaceHeader*>(file.GetData());
+	G4bool valid = file.GetSize() >= sizeof(PhaseSpaceHeader)
+		    && std::strncmp(header->magic, "MTXPSF1", 8) == 0
+		    && header->recordSize == sizeof(PhaseSpaceRecord)
+		    && header->nRecords > 0
+		    && file.GetSize() >= sizeof(PhaseSpaceHeader) + header->nRecords*sizeof(PhaseSpaceRecord);
+	if(!valid){
+		G4ExceptionDescription msg;
+		msg << fileName << " is not a valid phase-space file (MTXPSF1 header with "
+		    << sizeof(PhaseSpaceRecord) << " byte records expected)";
+		G4Exception("PhaseSpaceReader::Open", "PhaseSpace002", JustWarning, msg);
+		file.Close();
+		return false;
+	}
+
+	records = reinterpret_cast<const PhaseSpaceRecord*>(file.GetData() + sizeof(PhaseSpaceHeader));
+	nRecords = header->nRecords;
+	SetSlice(sliceIndex, sliceCount);
+
+	return true;
+}
+
+void PhaseSpaceReader::Close()
+{
+
+	file.Close();
+	records = 0;
+	nRecords = 0;
+	sliceBegin = sliceEnd = 0;
+	cursor = prefetched = 0;
+
+}
+
+void PhaseSpaceReader::SetSlice(G4int index, G4int count)
+{
+
+	if(count < 1) count = 1;
+	if(index < 0 || index >= count) index = 0;
+	sliceIndex = index;
+	sliceCount = count;
+
+	//Contiguous disjoint ranges; the first nRecords%count slices get one extra
+	uint64_t base  = nRecords/count;
+	uint64_t extra = nRecords%count;
+	sliceBegin = index*base + (index < (G4int)extra ? index : extra);
+	sliceEnd   = sliceBegin + base + (index < (G4int)extra ? 1 : 0);
+
+	if(records && sliceBegin == sliceEnd){
+		G4ExceptionDescription msg;
+		msg << "Phase-space slice " << index << "/" << count << " of "
+		    << file.GetFileName() << " is empty";
+		G4Exception("PhaseSpaceReader::SetSlice", "PhaseSpace003", FatalException, msg);
+	}
+
+	Rewind();
+	nWraps = 0;
+
+}
+
+void PhaseSpaceReader::Rewind()
+{
+
+	cursor = sliceBegin;
+	prefetched = sliceBegin;
+	use = 0;
+
+}
+
+void PhaseSpaceReader::Skip(uint64_t n)
+{
+
+	uint64_t length = sliceEnd - sliceBegin;
+	if(length == 0) return;
+
+	uint64_t position = (cursor - sliceBegin)*recycle + use + n;
+	uint64_t record = position/recycle;
+
+	use = position%recycle;
+	nWraps += record/length;
+	cursor = sliceBegin + record%length;
+	prefetched = cursor;
+
+}
+
+void PhaseSpaceReader::Next(G4int& pdg, G4ThreeVector& pos, G4ThreeVector& dir,
+			    G4double& energy, G4double& time, G4double& weight)
+{
+
+	if(cursor >= sliceEnd){
+		Rewind();
+		if(nWraps++ == 0){
+			G4ExceptionDescription msg;
+			msg << "Phase-space slice of " << file.GetFileName()
+			    << " exhausted, restarting from its first record";
+			G4Exception("PhaseSpaceReader::Next", "PhaseSpace004", JustWarning, msg);
+		}
+	}
+
+	if(readAhead && cursor >= prefetched){
+		uint64_t window = readAhead/sizeof(PhaseSpaceRecord) + 1;
+		file.Prefetch(sizeof(PhaseSpaceHeader) + cursor*sizeof(PhaseSpaceRecord), readAhead);
+		prefetched = cursor + window;
+	}
+
+	const PhaseSpaceRecord& record = records[cursor];
+
+	G4double x  = record.x,  y  = record.y;
+	G4double dx = record.dx, dy = record.dy;
+
+	//Quarter turns around the beam axis, continued on each wrap
+	if(rotate){
+		G4double t;
+		switch((use + nWraps)%4){
+		case 1: t = x;  x  = -y;  y  = t;
+			t = dx; dx = -dy; dy = t;  break;
+		case 2: x  = -x;  y  = -y;
+			dx = -dx; dy = -dy; break;
+		case 3: t = x;  x  = y;   y  = -t;
+			t = dx; dx = dy;  dy = -t; break;
+		default: break;
+		}
+	}
+
+	pdg	= record.pdg;
+	pos	= G4ThreeVector(x*mm, y*mm, record.z*mm);
+	dir	= G4ThreeVector(dx, dy, record.dz).unit();
+	energy	= record.energy*MeV;
+	time	= record.time*ns;
+	weight	= record.weight;
+
+	if(++use >= recycle){
+		use = 0;
+		++cursor;
+	}
+
+}
@@ -1,9 +1,12 @@
 
 #include "globals.hh"
 #include "PhysicsList.hh"
+#include "PhysicsListMessenger.hh"
+#include "PhysicsTableCache.hh"
 #include "G4ParticleTypes.hh"
 #include "G4ProcessManager.hh"
 #include "G4PhysicsListHelper.hh"
+#include "G4ProcessTable.hh"
 
 #include "G4ComptonScattering.hh"
 #include "G4GammaConversion.hh"
@@ -23,13 +26,25 @@
 #include "G4OpWLS.hh"
 
 #include "G4Scintillation.hh"
+#include "G4FastSimulationManagerProcess.hh"
+#include "G4BiasingHelper.hh"
 
 
 PhysicsList::PhysicsList()
-{}
+	: messenger(0),
+	  tableCache(0),
+	  forcedInteraction(false),
+	  wlsTimeProfile("delta")
+{
+	tableCache = new PhysicsTableCache(this);
+	messenger = new PhysicsListMessenger(this);
+}
 
 PhysicsList::~PhysicsList()
-{}
+{
+	delete messenger;
+	delete tableCache;
+}
 
 void PhysicsList::ConstructParticle()
 {
@@ -48,6 +63,20 @@ void PhysicsList::ConstructProcess()
 	ConstructEM();
 	ConstructOp();
 	ConstructScintillation();
+	if(forcedInteraction) ConstructBiasing();
+
+}
+
+void PhysicsList::ConstructBiasing()
+{
+
+	//Interactions and transportation of the gamma under the control of the
+	//biasing operator attached to the crystals (DetectorConstruction)
+	G4ProcessManager* manager = G4Gamma::Gamma()->GetProcessManager();
+	G4BiasingHelper::ActivatePhysicsBiasing(manager, "phot");
+	G4BiasingHelper::ActivatePhysicsBiasing(manager, "compt");
+	G4BiasingHelper::ActivatePhysicsBiasing(manager, "conv");
+	G4BiasingHelper::ActivateNonPhysicsBiasing(manager);
 
 }
 
@@ -85,8 +114,7 @@ void PhysicsList::ConstructOp()
 	G4ParticleDefinition* OpPhoton;
 
 	G4OpWLS* theWLSProcess = new G4OpWLS();
-	theWLSProcess->UseTimeProfile("delta");
-//	theWLSProcess->UseTimeProfile("exponential");
+	theWLSProcess->UseTimeProfile(wlsTimeProfile);
 
 	G4Cerenkov* theCerenkovProcess = new G4Cerenkov();
 	theCerenkovProcess->SetMaxNumPhotonsPerStep(300);
@@ -100,6 +128,19 @@ void PhysicsList::ConstructOp()
 	helper->RegisterProcess(theCerenkovProcess, OpPhoton);
 	helper->RegisterProcess(theWLSProcess, OpPhoton);
 
+	//Hands photons in the crystals to CrystalPhotonModel when enabled
+	OpPhoton->GetProcessManager()->AddDiscreteProcess(new G4FastSimulationManagerProcess());
+
+
+}
+
+void PhysicsList::ApplyWLSTimeProfile() const
+{
+
+	//The process of the calling thread
+	G4OpWLS* wls = dynamic_cast<G4OpWLS*>(
+		G4ProcessTable::GetProcessTable()->FindProcess("OpWLS", G4OpticalPhoton::OpticalPhoton()));
+	if(wls) wls->UseTimeProfile(wlsTimeProfile);
 
 }
 
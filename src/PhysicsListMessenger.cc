@@ -0,0 +1,51 @@
+#include "PhysicsListMessenger.hh"
+#include "PhysicsList.hh"
+#include "PhysicsTableCache.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+
+PhysicsListMessenger::PhysicsListMessenger(PhysicsList* list)
+	: G4UImessenger(),
+	  physicsList(list)
+{
+
+	physicsDir = new G4UIdirectory("/matrix/physics/");
+	physicsDir->SetGuidance("Physics list options.");
+
+	tableCacheCmd = new G4UIcmdWithAString("/matrix/physics/tableCache", this);
+	tableCacheCmd->SetGuidance("Directory of the physics table cache, none disables it.");
+	tableCacheCmd->SetGuidance("Defaults to $MATRIX_PHYSICS_CACHE. Must be set before the first run.");
+	tableCacheCmd->SetParameterName("dir", false);
+	tableCacheCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	wlsTimeProfileCmd = new G4UIcmdWithAString("/matrix/physics/wlsTimeProfile", this);
+	wlsTimeProfileCmd->SetGuidance("Time profile of the WLS re-emission in the fibers.");
+	wlsTimeProfileCmd->SetGuidance("Takes effect at the next run.");
+	wlsTimeProfileCmd->SetParameterName("profile", false);
+	wlsTimeProfileCmd->SetCandidates("delta exponential");
+	//The physics list is shared, workers pick it up at their next run
+	wlsTimeProfileCmd->SetToBeBroadcasted(false);
+	wlsTimeProfileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+PhysicsListMessenger::~PhysicsListMessenger()
+{
+
+	delete wlsTimeProfileCmd;
+	delete tableCacheCmd;
+	delete physicsDir;
+
+}
+
+void PhysicsListMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == tableCacheCmd)
+		physicsList->GetTableCache()->SetDirectory(newValue == "none" ? G4String("") : newValue);
+
+	else if(command == wlsTimeProfileCmd)
+		physicsList->SetWLSTimeProfile(newValue);
+
+}
@@ -0,0 +1,232 @@
+#include "PhysicsTableCache.hh"
+
+#include "G4VUserPhysicsList.hh"
+#include "G4StateManager.hh"
+#include "G4ParticleTable.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4Version.hh"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+	//FNV-1a, stable across builds and platforms
+	G4String Hash(const std::string& text)
+	{
+		unsigned long long h = 1469598103934665603ULL;
+		for(std::size_t i = 0; i < text.size(); i++){
+			h ^= (unsigned char)text[i];
+			h *= 1099511628211ULL;
+		}
+		char buffer[17];
+		std::snprintf(buffer, sizeof(buffer), "%016llx", h);
+		return buffer;
+	}
+
+	int RemoveEntry(const char* path, const struct stat*, int, struct FTW*)
+	{
+		return std::remove(path);
+	}
+
+	void RemoveTree(const G4String& path)
+	{
+		nftw(path.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+	}
+
+}
+
+PhysicsTableCache::PhysicsTableCache(G4VUserPhysicsList* list)
+	: G4VStateDependent(),
+	  physicsList(list),
+	  directory(""),
+	  key(""),
+	  timing(false),
+	  done(false),
+	  retrieved(false)
+{
+	const char* env = std::getenv("MATRIX_PHYSICS_CACHE");
+	if(env) directory = env;
+}
+
+PhysicsTableCache::~PhysicsTableCache()
+{}
+
+G4bool PhysicsTableCache::Notify(G4ApplicationState requestedState)
+{
+
+	//Tables are built while the kernel initializes the first run, between
+	//the Idle -> Init and the Idle -> GeomClosed transitions
+	if(done || directory == "") return true;
+
+	G4ApplicationState current = G4StateManager::GetStateManager()->GetCurrentState();
+	if(requestedState == G4State_Init && current == G4State_Idle) BeginTables();
+	else if(requestedState == G4State_GeomClosed && timing) EndTables();
+
+	return true;
+
+}
+
+void PhysicsTableCache::BeginTables()
+{
+
+	key = ComputeKey();
+	G4String entry = directory + "/" + key;
+
+	struct stat info;
+	if(stat((entry + "/complete").c_str(), &info) == 0){
+		physicsList->SetPhysicsTableRetrieved(entry);
+		retrieved = true;
+	}
+
+	timing = true;
+	start = std::chrono::steady_clock::now();
+
+}
+
+void PhysicsTableCache::EndTables()
+{
+
+	G4double seconds = std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+	timing = false;
+	done = true;
+
+	G4String entry = directory + "/" + key;
+	if(retrieved){
+		G4double coldSeconds = ReadBuildTime(entry);
+		G4cout<<"Physics tables retrieved from "<<entry<<" in "<<seconds<<" s";
+		if(coldSeconds > 0) G4cout<<", "<<coldSeconds - seconds<<" s saved";
+		G4cout<<G4endl;
+	}
+	else{
+		G4cout<<"Physics tables built in "<<seconds<<" s, caching them in "<<entry<<G4endl;
+		Store(seconds);
+	}
+
+}
+
+void PhysicsTableCache::Store(G4double buildSeconds)
+{
+
+	if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST){
+		G4ExceptionDescription msg;
+		msg << "Cannot create physics table cache " << directory;
+		G4Exception("PhysicsTableCache::Store", "TableCache001", JustWarning, msg);
+		return;
+	}
+
+	//Each job writes aside and renames the complete entry into place;
+	//the first job to finish wins, the others drop their copy
+	char host[64] = "";
+	gethostname(host, sizeof(host) - 1);
+	std::ostringstream tmp;
+	tmp << directory << "/" << key << ".tmp." << host << "." << getpid();
+	G4String tmpEntry = tmp.str();
+	G4String entry = directory + "/" + key;
+
+	if(mkdir(tmpEntry.c_str(), 0755) != 0 || !physicsList->StorePhysicsTable(tmpEntry)){
+		G4ExceptionDescription msg;
+		msg << "Failed to store physics tables in " << tmpEntry;
+		G4Exception("PhysicsTableCache::Store", "TableCache002", JustWarning, msg);
+		RemoveTree(tmpEntry);
+		return;
+	}
+
+	std::ofstream marker((tmpEntry + "/complete").c_str());
+	marker << "buildSeconds " << buildSeconds << "\n";
+	marker << G4Version << "\n";
+	marker.close();
+
+	if(!marker || std::rename(tmpEntry.c_str(), entry.c_str()) != 0) RemoveTree(tmpEntry);
+
+}
+
+G4double PhysicsTableCache::ReadBuildTime(const G4String& entry) const
+{
+
+	std::ifstream in((entry + "/complete").c_str());
+	G4String tag;
+	G4double seconds = 0;
+	in >> tag >> seconds;
+	return (in && tag == "buildSeconds") ? seconds : 0;
+
+}
+
+G4String PhysicsTableCache::ComputeKey() const
+{
+
+	std::ostringstream text;
+	text.precision(17);
+	text << G4Version << "\n";
+
+	//Processes attached to every particle, in order
+	G4ParticleTable::G4PTblDicIterator* particles = G4ParticleTable::GetParticleTable()->GetIterator();
+	particles->reset();
+	while((*particles)()){
+		G4ParticleDefinition* particle = particles->value();
+		G4ProcessManager* manager = particle->GetProcessManager();
+		if(!manager) continue;
+		text << "particle " << particle->GetParticleName();
+		G4ProcessVector* processes = manager->GetProcessList();
+		for(G4int i = 0; i < processes->size(); i++)
+			text << " " << (*processes)[i]->GetProcessName();
+		text << "\n";
+	}
+
+	//Materials, their composition and optical properties
+	const G4MaterialTable* materials = G4Material::GetMaterialTable();
+	for(std::size_t m = 0; m < materials->size(); m++){
+		const G4Material* material = (*materials)[m];
+		text << "material " << material->GetName() << " " << material->GetDensity()
+		     << " " << material->GetTemperature() << " " << material->GetPressure();
+		for(std::size_t e = 0; e < material->GetNumberOfElements(); e++)
+			text << " " << material->GetElement(e)->GetName()
+			     << " " << material->GetFractionVector()[e];
+		text << "\n";
+
+		G4MaterialPropertiesTable* mpt = material->GetMaterialPropertiesTable();
+		if(!mpt) continue;
+		std::vector<G4String> names = mpt->GetMaterialPropertyNames();
+		for(std::size_t p = 0; p < names.size(); p++){
+			G4MaterialPropertyVector* property = mpt->GetProperty(names[p]);
+			if(!property) continue;
+			text << " property " << names[p];
+			for(std::size_t i = 0; i < property->GetVectorLength(); i++)
+				text << " " << property->Energy(i) << " " << (*property)[i];
+			text << "\n";
+		}
+		std::vector<G4String> constNames = mpt->GetMaterialConstPropertyNames();
+		for(std::size_t p = 0; p < constNames.size(); p++){
+			if(!mpt->ConstPropertyExists(constNames[p])) continue;
+			text << " const " << constNames[p] << " " << mpt->GetConstProperty(constNames[p]) << "\n";
+		}
+	}
+
+	//Production cuts of every region and the table energy range
+	G4RegionStore* regions = G4RegionStore::GetInstance();
+	for(std::size_t r = 0; r < regions->size(); r++){
+		G4ProductionCuts* cuts = (*regions)[r]->GetProductionCuts();
+		text << "region " << (*regions)[r]->GetName();
+		for(G4int i = 0; cuts && i < NumberOfG4CutIndex; i++)
+			text << " " << cuts->GetProductionCut(i);
+		text << "\n";
+	}
+	G4ProductionCutsTable* cutsTable = G4ProductionCutsTable::GetProductionCutsTable();
+	text << "range " << cutsTable->GetLowEdgeEnergy() << " " << cutsTable->GetHighEdgeEnergy() << "\n";
+
+	return Hash(text.str());
+
+}
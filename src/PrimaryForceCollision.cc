@@ -0,0 +1,62 @@
+#include "PrimaryForceCollision.hh"
+
+#include "G4BOptrForceCollision.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4Track.hh"
+
+PrimaryForceCollision::PrimaryForceCollision(const G4String& particle, const G4String& name)
+	: G4VBiasingOperator(name),
+	  forceCollision(0),
+	  forced(false)
+{
+	forceCollision = new G4BOptrForceCollision(particle, name + "Primaries");
+}
+
+PrimaryForceCollision::~PrimaryForceCollision()
+{
+	//The wrapped operator stays registered with the biasing interface and
+	//lives as long as the thread, like this one
+}
+
+void PrimaryForceCollision::StartTracking(const G4Track* track)
+{
+
+	forced = track->GetParentID() == 0;
+
+	//Clones come from the non-physics biasing process, which only ever
+	//clones the tracks handed to the wrapped operator
+	if(!forced){
+		const G4BiasingProcessInterface* creator = dynamic_cast<const G4BiasingProcessInterface*>(track->GetCreatorProcess());
+		forced = creator && !creator->GetWrappedProcess();
+	}
+
+}
+
+G4VBiasingOperation* PrimaryForceCollision::ProposeNonPhysicsBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess)
+{
+	return forced ? forceCollision->GetProposedNonPhysicsBiasingOperation(track, callingProcess) : 0;
+}
+
+G4VBiasingOperation* PrimaryForceCollision::ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess)
+{
+	return forced ? forceCollision->GetProposedOccurenceBiasingOperation(track, callingProcess) : 0;
+}
+
+G4VBiasingOperation* PrimaryForceCollision::ProposeFinalStateBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess)
+{
+	return forced ? forceCollision->GetProposedFinalStateBiasingOperation(track, callingProcess) : 0;
+}
+
+void PrimaryForceCollision::OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase biasingCase,
+					     G4VBiasingOperation* operationApplied, const G4VParticleChange* particleChangeProduced)
+{
+	if(forced) forceCollision->ReportOperationApplied(callingProcess, biasingCase, operationApplied, particleChangeProduced);
+}
+
+void PrimaryForceCollision::OperationApplied(const G4BiasingProcessInterface* callingProcess, G4BiasingAppliedCase biasingCase,
+					     G4VBiasingOperation* occurenceOperationApplied, G4double weightForOccurenceInteraction,
+					     G4VBiasingOperation* finalStateOperationApplied, const G4VParticleChange* particleChangeProduced)
+{
+	if(forced) forceCollision->ReportOperationApplied(callingProcess, biasingCase, occurenceOperationApplied, weightForOccurenceInteraction,
+							  finalStateOperationApplied, particleChangeProduced);
+}
@@ -1,14 +1,57 @@
 
 #include "globals.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "PrimaryGeneratorMessenger.hh"
+#include "PhaseSpaceReader.hh"
+#include "DepositReplay.hh"
+#include "PrimaryInformation.hh"
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTypes.hh"
+#include "G4ParticleTable.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+#include "G4Poisson.hh"
+
+#include <fstream>
+#include <sstream>
+
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
 	: G4VUserPrimaryGeneratorAction(),
-	  particleGun(0)
+	  particleGun(0),
+	  messenger(0),
+	  sourceType(kGun),
+	  positionShape(kPoint),
+	  angularShape(kBeam),
+	  spotHalfSize(0),
+	  spotHalfSizeY(0),
+	  spotSigma(1.*mm),
+	  coneCosMin(1.),
+	  pairs(false),
+	  primariesPerEvent(1),
+	  pileupRate(0),
+	  pileupWindow(1.*us),
+	  firstEventID(0),
+	  phaseSpace(0),
+	  phaseSpaceFile(""),
+	  phaseSpaceOpen(false),
+	  sliceIndex(0),
+	  sliceCount(1),
+	  lastPdg(0),
+	  lastParticle(0),
+	  deposits(0)
 {
+	//Flat spot covers the matrix faces of all modules by default
+	spotHalfSize = ModuleTiling::PlaneX() - ModuleTiling::ModuleX() + Mx;
+	spotHalfSizeY = ModuleTiling::PlaneY() - ModuleTiling::ModuleY() + My;
 
 	G4int n_particle = 1;
 	particleGun = new G4ParticleGun(n_particle);
@@ -17,18 +60,293 @@ PrimaryGeneratorAction::PrimaryGeneratorAction()
 	particleGun->SetParticleEnergy(511.*keV);
 	particleGun->SetParticlePosition(G4ThreeVector(0., 0., 452*mm));
 
+	phaseSpace = new PhaseSpaceReader();
+	deposits = new DepositReplay();
+	messenger = new PrimaryGeneratorMessenger(this);
+
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
 
+	delete messenger;
+	delete deposits;
+	delete phaseSpace;
 	delete particleGun;
 
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* Event)
 {
-	
-	particleGun->GeneratePrimaryVertex(Event);
 
+	//Continue the numbering of an earlier part of the run
+	if(firstEventID) Event->SetEventID(Event->GetEventID() + firstEventID);
+
+	//One event of recorded deposits, as scintillation photons
+	if(sourceType == kDeposits){
+		deposits->GeneratePrimaries(Event);
+		return;
+	}
+
+	//Independent primaries, or a Poisson number of them spread over the
+	//pile-up window
+	G4int n = primariesPerEvent;
+	if(pileupRate > 0) n = G4Poisson(pileupRate*pileupWindow);
+
+	for(G4int i = 0; i < n; i++){
+		G4long serial = (G4long)Event->GetEventID()*primariesPerEvent + i;
+		G4PrimaryVertex* vertex = (sourceType == kPhaseSpace) ? GeneratePhaseSpace() : GenerateBeam(serial);
+		if(pileupRate > 0) vertex->SetT0(vertex->GetT0() + pileupWindow*G4UniformRand());
+
+		for(G4PrimaryParticle* particle = vertex->GetPrimary(); particle; particle = particle->GetNext())
+			particle->SetUserInformation(new PrimaryInformation(i));
+
+		Event->AddPrimaryVertex(vertex);
+	}
+
+}
+
+G4PrimaryVertex* PrimaryGeneratorAction::GenerateBeam(G4long serial)
+{
+
+	G4ThreeVector pos = SamplePosition(serial);
+	G4ThreeVector dir = SampleDirection();
+	G4PrimaryVertex* vertex = new G4PrimaryVertex(pos, particleGun->GetParticleTime());
+
+	if(pairs){
+		//Back-to-back annihilation photons
+		G4PrimaryParticle* first  = new G4PrimaryParticle(G4Gamma::Gamma());
+		G4PrimaryParticle* second = new G4PrimaryParticle(G4Gamma::Gamma());
+		first->SetKineticEnergy(electron_mass_c2);
+		second->SetKineticEnergy(electron_mass_c2);
+		first->SetMomentumDirection(dir);
+		second->SetMomentumDirection(-dir);
+		vertex->SetPrimary(first);
+		vertex->SetPrimary(second);
+	}
+	else{
+		G4PrimaryParticle* particle = new G4PrimaryParticle(particleGun->GetParticleDefinition());
+		particle->SetKineticEnergy(SampleEnergy());
+		particle->SetMomentumDirection(dir);
+		particle->SetPolarization(particleGun->GetParticlePolarization());
+		vertex->SetPrimary(particle);
+	}
+
+	return vertex;
+}
+
+G4ThreeVector PrimaryGeneratorAction::SamplePosition(G4long serial) const
+{
+
+	G4ThreeVector pos = particleGun->GetParticlePosition();
+
+	switch(positionShape){
+	case kSquare:
+		pos += G4ThreeVector(spotHalfSize*(2.*G4UniformRand() - 1.),
+				     spotHalfSizeY*(2.*G4UniformRand() - 1.), 0.);
+		break;
+	case kGaussian:
+		pos += G4ThreeVector(G4RandGauss::shoot(0., spotSigma),
+				     G4RandGauss::shoot(0., spotSigma), 0.);
+		break;
+	case kRaster:{
+		//One crystal per primary, sweeping rows of the matrix, then the
+		//modules in order
+		G4int ix = serial%nx;
+		G4int iy = (serial/nx)%ny;
+		G4int module = (serial/(nx*ny))%ModuleTiling::NumberOfModules();
+		G4int mx = module%ModuleTiling::nModulesX, my = module/ModuleTiling::nModulesX;
+		pos += G4ThreeVector(ModuleTiling::ModuleCentreX(mx) + (ix - 0.5*(nx - 1))*2.*CSx,
+				     ModuleTiling::ModuleCentreY(my) + (iy - 0.5*(ny - 1))*2.*CSy, 0.);
+		break;
+	}
+	default:
+		break;
+	}
+
+	return pos;
+}
+
+G4ThreeVector PrimaryGeneratorAction::SampleDirection() const
+{
+
+	if(angularShape == kBeam) return particleGun->GetParticleMomentumDirection();
+
+	G4double cosTheta = (angularShape == kIsotropic)
+		? 2.*G4UniformRand() - 1.
+		: 1. - (1. - coneCosMin)*G4UniformRand();
+	G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+	G4double phi = twopi*G4UniformRand();
+
+	G4ThreeVector dir(sinTheta*std::cos(phi), sinTheta*std::sin(phi), cosTheta);
+	if(angularShape == kCone) dir.rotateUz(particleGun->GetParticleMomentumDirection());
+
+	return dir;
+}
+
+G4double PrimaryGeneratorAction::SampleEnergy() const
+{
+
+	if(spectrum.IsEmpty()) return particleGun->GetParticleEnergy();
+
+	G4int bin = spectrum.Sample(G4UniformRand());
+	return spectrumLow[bin] + spectrumWidth[bin]*G4UniformRand();
+}
+
+void PrimaryGeneratorAction::SetPositionShape(const G4String& shape)
+{
+
+	if(shape == "square") positionShape = kSquare;
+	else if(shape == "gaussian") positionShape = kGaussian;
+	else if(shape == "raster") positionShape = kRaster;
+	else positionShape = kPoint;
+
+}
+
+void PrimaryGeneratorAction::SetAngularShape(const G4String& shape)
+{
+
+	if(shape == "isotropic") angularShape = kIsotropic;
+	else if(shape == "cone") angularShape = kCone;
+	else angularShape = kBeam;
+
+}
+
+void PrimaryGeneratorAction::SetEnergySpectrum(const G4String& fileName)
+{
+
+	//Histogram bins, one per line: low edge, high edge (MeV), content
+	std::ifstream in(fileName.c_str());
+	if(!in){
+		G4ExceptionDescription msg;
+		msg << "Cannot read energy spectrum " << fileName;
+		G4Exception("PrimaryGeneratorAction::SetEnergySpectrum", "Source001", FatalErrorInArgument, msg);
+		return;
+	}
+
+	std::vector<G4double> low, width, content;
+	std::string line;
+	while(std::getline(in, line)){
+		if(line.empty() || line[0] == '#') continue;
+		std::istringstream is(line);
+		G4double l, h, c;
+		if(!(is >> l >> h >> c)) continue;
+		if(h <= l){
+			G4ExceptionDescription msg;
+			msg << "Bin with high edge below low edge in " << fileName << ": " << line;
+			G4Exception("PrimaryGeneratorAction::SetEnergySpectrum", "Source002", FatalErrorInArgument, msg);
+			return;
+		}
+		low.push_back(l*MeV);
+		width.push_back((h - l)*MeV);
+		content.push_back(c);
+	}
+
+	spectrum.Build(content);
+	spectrumLow.swap(low);
+	spectrumWidth.swap(width);
+
+	G4cout<<"Energy spectrum "<<fileName<<": "<<spectrum.GetSize()<<" bins"<<G4endl;
+
+}
+
+void PrimaryGeneratorAction::SetSourceType(const G4String& type)
+{
+
+	if(type == "phaseSpace") sourceType = kPhaseSpace;
+	else if(type == "deposits") sourceType = kDeposits;
+	else sourceType = kGun;
+
+}
+
+void PrimaryGeneratorAction::SetDepositFile(const G4String& name)
+{
+
+	deposits->SetFileName(name);
+
+}
+
+void PrimaryGeneratorAction::SetPhaseSpaceSlice(G4int index, G4int count)
+{
+
+	sliceIndex = index;
+	sliceCount = count;
+	phaseSpaceOpen = false;
+
+}
+
+void PrimaryGeneratorAction::OpenPhaseSpace()
+{
+
+	//Every worker thread of every rank reads its own part of the file
+	G4int thread = G4Threading::G4GetThreadId();
+	G4int nThreads = 1;
+	if(thread < 0) thread = 0;
+#ifdef G4MULTITHREADED
+	if(G4Threading::IsWorkerThread())
+		nThreads = G4MTRunManager::GetMasterRunManager()->GetNumberOfThreads();
+#endif
+
+	if(!phaseSpace->Open(phaseSpaceFile)){
+		G4ExceptionDescription msg;
+		msg << "Phase-space source selected but " << phaseSpaceFile << " cannot be used";
+		G4Exception("PrimaryGeneratorAction::OpenPhaseSpace", "PhaseSpace005", FatalException, msg);
+		return;
+	}
+	phaseSpace->SetSlice(sliceIndex*nThreads + thread, sliceCount*nThreads);
+	phaseSpaceOpen = true;
+
+	//A run continued from a checkpoint picks up where the records stopped
+	if(firstEventID > 0 && pileupRate <= 0)
+		phaseSpace->Skip((uint64_t)firstEventID*primariesPerEvent);
+
+	G4cout<<"Phase-space "<<phaseSpaceFile<<": records "<<phaseSpace->GetSliceBegin()
+	      <<" to "<<phaseSpace->GetSliceEnd()<<" of "<<phaseSpace->GetNumberOfRecords()<<G4endl;
+
+}
+
+G4ParticleDefinition* PrimaryGeneratorAction::FindParticle(G4int pdg)
+{
+
+	//Phase-space files are dominated by one species, avoid the table lookup
+	if(lastParticle && pdg == lastPdg) return lastParticle;
+
+	G4ParticleDefinition* particle = G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+	if(!particle){
+		G4ExceptionDescription msg;
+		msg << "Unknown PDG code " << pdg << " in phase-space file " << phaseSpaceFile;
+		G4Exception("PrimaryGeneratorAction::FindParticle", "PhaseSpace006", FatalException, msg);
+	}
+	lastPdg = pdg;
+	lastParticle = particle;
+
+	return particle;
+}
+
+G4PrimaryVertex* PrimaryGeneratorAction::GeneratePhaseSpace()
+{
+
+	if(!phaseSpaceOpen) OpenPhaseSpace();
+
+	G4int pdg;
+	G4ThreeVector pos, dir;
+	G4double energy, time, weight;
+	phaseSpace->Next(pdg, pos, dir, energy, time, weight);
+
+	G4PrimaryParticle* particle = new G4PrimaryParticle(FindParticle(pdg));
+	particle->SetMomentumDirection(dir);
+	particle->SetKineticEnergy(energy);
+	particle->SetWeight(weight);
+
+	//Optical photons need a polarization perpendicular to their direction
+	if(particle->GetParticleDefinition() == G4OpticalPhoton::OpticalPhoton()){
+		G4ThreeVector polarization = dir.orthogonal().unit();
+		polarization.rotate(twopi*G4UniformRand(), dir);
+		particle->SetPolarization(polarization);
+	}
+
+	G4PrimaryVertex* vertex = new G4PrimaryVertex(pos, time);
+	vertex->SetPrimary(particle);
+
+	return vertex;
 }
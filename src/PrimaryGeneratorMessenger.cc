@@ -0,0 +1,283 @@
+#include "PrimaryGeneratorMessenger.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "PhaseSpaceReader.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+#include <sstream>
+
+PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(PrimaryGeneratorAction* gen)
+	: G4UImessenger(),
+	  generator(gen)
+{
+
+	matrixDir = new G4UIdirectory("/matrix/");
+	matrixDir->SetGuidance("Preshower matrix simulation control.");
+
+	sourceDir = new G4UIdirectory("/matrix/source/");
+	sourceDir->SetGuidance("Primary particle source.");
+
+	typeCmd = new G4UIcmdWithAString("/matrix/source/type", this);
+	typeCmd->SetGuidance("Select the primary source.");
+	typeCmd->SetGuidance("  gun        : /gun/ particle spread by the position, angle and energy distributions");
+	typeCmd->SetGuidance("  phaseSpace : records read from a phase-space file");
+	typeCmd->SetGuidance("  deposits   : scintillation light of recorded crystal deposits");
+	typeCmd->SetParameterName("type", false);
+	typeCmd->SetCandidates("gun phaseSpace deposits");
+	typeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	pairsCmd = new G4UIcmdWithABool("/matrix/source/pairs", this);
+	pairsCmd->SetGuidance("Fire back-to-back 511 keV gammas instead of the gun particle.");
+	pairsCmd->SetParameterName("pairs", true);
+	pairsCmd->SetDefaultValue(true);
+	pairsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	primariesCmd = new G4UIcmdWithAnInteger("/matrix/source/primaries", this);
+	primariesCmd->SetGuidance("Number of independent primaries per event.");
+	primariesCmd->SetGuidance("Amortizes the per-event overhead for low energy studies.");
+	primariesCmd->SetParameterName("n", false);
+	primariesCmd->SetRange("n>=1");
+	primariesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	firstEventCmd = new G4UIcmdWithAnInteger("/matrix/source/firstEvent", this);
+	firstEventCmd->SetGuidance("Offset added to the event IDs of the following runs.");
+	firstEventCmd->SetGuidance("Set by checkpoint resume; also splits a run between jobs.");
+	firstEventCmd->SetParameterName("id", false);
+	firstEventCmd->SetRange("id>=0");
+	firstEventCmd->AvailableForStates(G4State_PreInit, G4State_Idle, G4State_GeomClosed);
+
+	//Pile-up
+	pileupDir = new G4UIdirectory("/matrix/source/pileup/");
+	pileupDir->SetGuidance("Poisson number of primaries at random times in a window.");
+	pileupDir->SetGuidance("A rate of zero goes back to /matrix/source/primaries.");
+
+	rateCmd = new G4UIcmdWithADoubleAndUnit("/matrix/source/pileup/rate", this);
+	rateCmd->SetGuidance("Mean primary rate.");
+	rateCmd->SetParameterName("rate", false);
+	rateCmd->SetRange("rate>=0.");
+	rateCmd->SetUnitCategory("Frequency");
+	rateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	windowCmd = new G4UIcmdWithADoubleAndUnit("/matrix/source/pileup/window", this);
+	windowCmd->SetGuidance("Length of the time window making up one event, 1 us by default.");
+	windowCmd->SetParameterName("window", false);
+	windowCmd->SetRange("window>0.");
+	windowCmd->SetUnitCategory("Time");
+	windowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	//Position distribution
+	positionDir = new G4UIdirectory("/matrix/source/position/");
+	positionDir->SetGuidance("Spread of the vertex around /gun/position (x and y only).");
+
+	positionShapeCmd = new G4UIcmdWithAString("/matrix/source/position/shape", this);
+	positionShapeCmd->SetGuidance("Transverse vertex distribution.");
+	positionShapeCmd->SetGuidance("  point    : the gun position");
+	positionShapeCmd->SetGuidance("  square   : flat over +-halfSize, by default the matrix faces of all modules");
+	positionShapeCmd->SetGuidance("  gaussian : round spot of width sigma");
+	positionShapeCmd->SetGuidance("  raster   : centre of one crystal per event, in event order");
+	positionShapeCmd->SetParameterName("shape", false);
+	positionShapeCmd->SetCandidates("point square gaussian raster");
+	positionShapeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	halfSizeCmd = new G4UIcmdWithADoubleAndUnit("/matrix/source/position/halfSize", this);
+	halfSizeCmd->SetGuidance("Half width of the square spot.");
+	halfSizeCmd->SetParameterName("halfSize", false);
+	halfSizeCmd->SetRange("halfSize>0.");
+	halfSizeCmd->SetUnitCategory("Length");
+	halfSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	sigmaCmd = new G4UIcmdWithADoubleAndUnit("/matrix/source/position/sigma", this);
+	sigmaCmd->SetGuidance("Standard deviation of the gaussian spot in x and y.");
+	sigmaCmd->SetParameterName("sigma", false);
+	sigmaCmd->SetRange("sigma>0.");
+	sigmaCmd->SetUnitCategory("Length");
+	sigmaCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	//Angular distribution
+	angleDir = new G4UIdirectory("/matrix/source/angle/");
+	angleDir->SetGuidance("Angular distribution around /gun/direction.");
+
+	angleShapeCmd = new G4UIcmdWithAString("/matrix/source/angle/shape", this);
+	angleShapeCmd->SetGuidance("  beam      : the gun direction");
+	angleShapeCmd->SetGuidance("  isotropic : full solid angle");
+	angleShapeCmd->SetGuidance("  cone      : uniform within coneHalfAngle of the gun direction");
+	angleShapeCmd->SetParameterName("shape", false);
+	angleShapeCmd->SetCandidates("beam isotropic cone");
+	angleShapeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	coneCmd = new G4UIcmdWithADoubleAndUnit("/matrix/source/angle/coneHalfAngle", this);
+	coneCmd->SetGuidance("Opening half angle of the cone.");
+	coneCmd->SetParameterName("angle", false);
+	coneCmd->SetRange("angle>0.");
+	coneCmd->SetUnitCategory("Angle");
+	coneCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	//Energy distribution
+	energyDir = new G4UIdirectory("/matrix/source/energy/");
+	energyDir->SetGuidance("Energy distribution of the gun particle.");
+
+	spectrumCmd = new G4UIcmdWithAString("/matrix/source/energy/spectrum", this);
+	spectrumCmd->SetGuidance("Read a binned spectrum: one 'low high content' line per bin, edges in MeV.");
+	spectrumCmd->SetGuidance("The alias sampling table is built once, when the command is applied.");
+	spectrumCmd->SetParameterName("file", false);
+	spectrumCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	monoCmd = new G4UIcmdWithoutParameter("/matrix/source/energy/mono", this);
+	monoCmd->SetGuidance("Drop the spectrum and use /gun/energy.");
+	monoCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	//Phase-space file
+	phaseSpaceDir = new G4UIdirectory("/matrix/source/phaseSpace/");
+	phaseSpaceDir->SetGuidance("Memory mapped phase-space file input.");
+
+	fileCmd = new G4UIcmdWithAString("/matrix/source/phaseSpace/file", this);
+	fileCmd->SetGuidance("Binary phase-space file (see PhaseSpaceReader.hh for the layout).");
+	fileCmd->SetParameterName("file", false);
+	fileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	recycleCmd = new G4UIcmdWithAnInteger("/matrix/source/phaseSpace/recycle", this);
+	recycleCmd->SetGuidance("Number of times each record is used before moving on.");
+	recycleCmd->SetParameterName("n", false);
+	recycleCmd->SetRange("n>=1");
+	recycleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	rotateCmd = new G4UIcmdWithABool("/matrix/source/phaseSpace/rotate", this);
+	rotateCmd->SetGuidance("Turn each reuse of a record by 90 deg around the z axis.");
+	rotateCmd->SetParameterName("rotate", true);
+	rotateCmd->SetDefaultValue(true);
+	rotateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	readAheadCmd = new G4UIcmdWithAnInteger("/matrix/source/phaseSpace/readAhead", this);
+	readAheadCmd->SetGuidance("Prefetch window ahead of the reader in MB, 0 disables it.");
+	readAheadCmd->SetParameterName("MB", false);
+	readAheadCmd->SetRange("MB>=0");
+	readAheadCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	sliceCmd = new G4UIcommand("/matrix/source/phaseSpace/slice", this);
+	sliceCmd->SetGuidance("Read only slice <index> of <count> equal parts of the file.");
+	sliceCmd->SetGuidance("Use it to split a file between ranks; worker threads subdivide the slice.");
+	G4UIparameter* indexPar = new G4UIparameter("index", 'i', false);
+	indexPar->SetParameterRange("index>=0");
+	sliceCmd->SetParameter(indexPar);
+	G4UIparameter* countPar = new G4UIparameter("count", 'i', false);
+	countPar->SetParameterRange("count>=1");
+	sliceCmd->SetParameter(countPar);
+	sliceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	//Deposit replay
+	depositsDir = new G4UIdirectory("/matrix/source/deposits/");
+	depositsDir->SetGuidance("Replay of deposits recorded with /matrix/deposits/record.");
+
+	depositFileCmd = new G4UIcmdWithAString("/matrix/source/deposits/file", this);
+	depositFileCmd->SetGuidance("Deposit file (see DepositReader.hh for the layout).");
+	depositFileCmd->SetGuidance("Event i replays recorded event i modulo the events in the file.");
+	depositFileCmd->SetParameterName("file", false);
+	depositFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger()
+{
+
+	delete depositFileCmd;
+	delete depositsDir;
+	delete sliceCmd;
+	delete readAheadCmd;
+	delete rotateCmd;
+	delete recycleCmd;
+	delete fileCmd;
+	delete phaseSpaceDir;
+	delete monoCmd;
+	delete spectrumCmd;
+	delete energyDir;
+	delete coneCmd;
+	delete angleShapeCmd;
+	delete angleDir;
+	delete sigmaCmd;
+	delete halfSizeCmd;
+	delete positionShapeCmd;
+	delete positionDir;
+	delete windowCmd;
+	delete rateCmd;
+	delete pileupDir;
+	delete firstEventCmd;
+	delete primariesCmd;
+	delete pairsCmd;
+	delete typeCmd;
+	delete sourceDir;
+	delete matrixDir;
+
+}
+
+void PrimaryGeneratorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == typeCmd)
+		generator->SetSourceType(newValue);
+
+	else if(command == pairsCmd)
+		generator->SetPairs(pairsCmd->GetNewBoolValue(newValue));
+
+	else if(command == primariesCmd)
+		generator->SetPrimariesPerEvent(primariesCmd->GetNewIntValue(newValue));
+
+	else if(command == firstEventCmd)
+		generator->SetFirstEventID(firstEventCmd->GetNewIntValue(newValue));
+
+	else if(command == rateCmd)
+		generator->SetPileupRate(rateCmd->GetNewDoubleValue(newValue));
+
+	else if(command == windowCmd)
+		generator->SetPileupWindow(windowCmd->GetNewDoubleValue(newValue));
+
+	else if(command == positionShapeCmd)
+		generator->SetPositionShape(newValue);
+
+	else if(command == halfSizeCmd)
+		generator->SetSpotHalfSize(halfSizeCmd->GetNewDoubleValue(newValue));
+
+	else if(command == sigmaCmd)
+		generator->SetSpotSigma(sigmaCmd->GetNewDoubleValue(newValue));
+
+	else if(command == angleShapeCmd)
+		generator->SetAngularShape(newValue);
+
+	else if(command == coneCmd)
+		generator->SetConeHalfAngle(coneCmd->GetNewDoubleValue(newValue));
+
+	else if(command == spectrumCmd)
+		generator->SetEnergySpectrum(newValue);
+
+	else if(command == monoCmd)
+		generator->SetMonoEnergetic();
+
+	else if(command == fileCmd)
+		generator->SetPhaseSpaceFile(newValue);
+
+	else if(command == recycleCmd)
+		generator->GetPhaseSpaceReader()->SetRecycle(recycleCmd->GetNewIntValue(newValue));
+
+	else if(command == rotateCmd)
+		generator->GetPhaseSpaceReader()->SetRotate(rotateCmd->GetNewBoolValue(newValue));
+
+	else if(command == readAheadCmd)
+		generator->GetPhaseSpaceReader()->SetReadAhead((std::size_t)readAheadCmd->GetNewIntValue(newValue)*1024*1024);
+
+	else if(command == depositFileCmd)
+		generator->SetDepositFile(newValue);
+
+	else if(command == sliceCmd){
+		G4int index, count;
+		std::istringstream is(newValue);
+		is >> index >> count;
+		generator->SetPhaseSpaceSlice(index, count);
+	}
+
+}
@@ -0,0 +1,6 @@
+#include "PrimaryInformation.hh"
+
+void PrimaryInformation::Print() const
+{
+	G4cout<<"Primary index: "<<index<<G4endl;
+}
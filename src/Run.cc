@@ -0,0 +1,52 @@
+#include "Run.hh"
+
+Run::Run()
+	: G4Run(),
+	  primaries(0),
+	  readouts(0),
+	  edges(0),
+	  sumLE(0),
+	  sumLE2(0),
+	  latePhotons(0),
+	  deposits(0),
+	  depositEvents(0),
+	  stackPeakDepth(0),
+	  stackPeakBytes(0),
+	  spilled(0),
+	  spilledEvents(0)
+{
+	for(G4int i = 0; i < kNumberOfKillReasons; i++) killed[i] = 0;
+	biasing.Clear();
+	memory.Clear();
+}
+
+Run::~Run()
+{}
+
+void Run::Merge(const G4Run* run)
+{
+
+	const Run* localRun = static_cast<const Run*>(run);
+	for(G4int i = 0; i < kNumberOfKillReasons; i++) killed[i] += localRun->killed[i];
+	primaries += localRun->primaries;
+
+	readouts += localRun->readouts;
+	edges += localRun->edges;
+	sumLE += localRun->sumLE;
+	sumLE2 += localRun->sumLE2;
+	latePhotons += localRun->latePhotons;
+
+	deposits += localRun->deposits;
+	depositEvents += localRun->depositEvents;
+
+	stackPeakDepth = std::max(stackPeakDepth, localRun->stackPeakDepth);
+	stackPeakBytes = std::max(stackPeakBytes, localRun->stackPeakBytes);
+	spilled += localRun->spilled;
+	spilledEvents += localRun->spilledEvents;
+
+	biasing.Merge(localRun->biasing);
+	memory.Merge(localRun->memory);
+
+	G4Run::Merge(run);
+
+}
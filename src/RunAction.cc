@@ -1,48 +1,169 @@
 /**
  * RunAction for Preshower Matrix Simulation
  *
- * Creates two histograms, one for each axis (X and Y).
+ * Creates two histograms, one for each axis (X and Y), and an ntuple with
+ * one row per detected photon. Reports the event and primary throughput.
  *
  */
 
 
 #include "Analysis.hh"
 #include "RunAction.hh"
+#include "Run.hh"
+#include "RunCheckpoint.hh"
+#include "ConvergenceMonitor.hh"
+#include "LiveMonitor.hh"
+#include "SubEventScheduler.hh"
+#include "MemoryMonitor.hh"
+#include "StackLimiter.hh"
+#include "BiasingMonitor.hh"
+#include "DepositRecorder.hh"
+#include "TimingRecorder.hh"
+#include "CrystalPhotonModel.hh"
+#include "PhysicsList.hh"
+#include "RunActionMessenger.hh"
+#include "DetectorParameters.hh"
 #include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4Timer.hh"
 
 RunAction::RunAction() 
-	: G4UserRunAction()
-{}
+	: G4UserRunAction(),
+	  messenger(0),
+	  fileName("matrix"),
+	  timer(0),
+	  checkpoint(0),
+	  convergence(0),
+	  liveMonitor(0),
+	  subEvents(0),
+	  memory(0),
+	  stackLimiter(0),
+	  biasing(0),
+	  deposits(0),
+	  timing(0)
+{
+	timer = new G4Timer();
+	checkpoint = new RunCheckpoint();
+	convergence = new ConvergenceMonitor();
+	liveMonitor = new LiveMonitor();
+	subEvents = new SubEventScheduler();
+	memory = new MemoryMonitor();
+	stackLimiter = new StackLimiter();
+	biasing = new BiasingMonitor();
+	deposits = new DepositRecorder();
+	timing = new TimingRecorder();
+	messenger = new RunActionMessenger(this);
+}
 
 RunAction::~RunAction()
-{}
+{
+	delete messenger;
+	delete timing;
+	delete deposits;
+	delete biasing;
+	delete stackLimiter;
+	delete memory;
+	delete subEvents;
+	delete liveMonitor;
+	delete convergence;
+	delete checkpoint;
+	delete timer;
+}
+
+G4Run* RunAction::GenerateRun()
+{
+	return new Run();
+}
 
 void RunAction::BeginOfRunAction(const G4Run* run)
 {
 	G4cout<<"Run "<<run->GetRunID()<<" start."<<G4endl;
 
+	timer->Start();
+
 	G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
 
 
-	analysisManager->OpenFile("matrix");
+	analysisManager->OpenFile(fileName);
 
 	analysisManager->CreateNtuple("nTuple","event-axis-channel");
 	analysisManager->CreateNtupleIColumn("event");
 	analysisManager->CreateNtupleIColumn("axis");
 	analysisManager->CreateNtupleIColumn("channel");
+	analysisManager->CreateNtupleIColumn("primary");
+	analysisManager->CreateNtupleDColumn("weight");
+	analysisManager->CreateNtupleIColumn("module");
 	analysisManager->FinishNtuple();
 
 	analysisManager->SetFirstHistoId(1);
-	analysisManager->CreateH1("Histogram_X","Fibers Readout X", 25, 0.5, 25.5);
-	analysisManager->CreateH1("Histogram_Y","Fibers Readout Y", 25, 0.5, 25.5);
+	//One bin per readout channel, modules one after the other; channels count from 0
+	G4int nx = ModuleTiling::NumberOfModules()*DetectorParameters::nx;
+	G4int ny = ModuleTiling::NumberOfModules()*DetectorParameters::ny;
+	analysisManager->CreateH1("Histogram_X","Fibers Readout X", nx, -0.5, nx - 0.5);
+	analysisManager->CreateH1("Histogram_Y","Fibers Readout Y", ny, -0.5, ny - 0.5);
+
+	//Timing ntuple and histogram, if enabled, booked before any row is filled
+	timing->BeginOfRun(run);
+
+	//Replays the journal of an interrupted run into the new output
+	checkpoint->BeginOfRun(run);
+
+	convergence->BeginOfRun(run);
+	liveMonitor->BeginOfRun(run);
+	subEvents->BeginOfRun();
+	memory->BeginOfRun(run);
+	biasing->BeginOfRun(run);
+	deposits->BeginOfRun(run);
+
+	CrystalPhotonModel* tracer = CrystalPhotonModel::GetInstance();
+	if(tracer) tracer->BeginOfRun();
+
+	//The WLS time profile may have changed since this thread built its processes
+	const PhysicsList* physicsList = dynamic_cast<const PhysicsList*>(G4RunManager::GetRunManager()->GetUserPhysicsList());
+	if(physicsList) physicsList->ApplyWLSTimeProfile();
 }
 
 void RunAction::EndOfRunAction(const G4Run* run)
 {
+	//Threads out of events track batches of the ones still busy
+	subEvents->EndOfRun();
+
+	timer->Stop();
+	G4int nEvents = run->GetNumberOfEvent();
+	G4double seconds = timer->GetRealElapsed();
+	//Merged from the workers on the master
+	G4long nPrimaries = static_cast<const Run*>(run)->GetPrimaries();
+
 	G4cout<<"Run "<<run->GetRunID()<<" done."<<G4endl;
+	G4cout<<"  "<<nEvents<<" events, "<<nPrimaries<<" primaries in "<<seconds<<" s";
+	if(seconds > 0) G4cout<<" ("<<nEvents/seconds<<" events/s, "<<nPrimaries/seconds<<" primaries/s)";
+	G4cout<<G4endl;
+
+	//Worker counts are merged into the master run
+	if(IsMaster()){
+		const Run* localRun = static_cast<const Run*>(run);
+		G4cout<<"  optical photons killed: "
+		      <<localRun->GetKilled(Run::kEscaped)<<" escaped, "
+		      <<localRun->GetKilled(Run::kTimeWindow)<<" out of time, "
+		      <<localRun->GetKilled(Run::kReflections)<<" over reflection limit"<<G4endl;
+	}
+	stackLimiter->EndOfRun(run);
+
+	CrystalPhotonModel* tracer = CrystalPhotonModel::GetInstance();
+	if(tracer) tracer->EndOfRun();
+
+	checkpoint->EndOfRun(run);
+	convergence->EndOfRun(run);
+	liveMonitor->EndOfRun(run);
+	biasing->EndOfRun(run);
+	deposits->EndOfRun(run);
+	timing->EndOfRun(run);
 
 	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
 	analysisManager->Write();
 	analysisManager->CloseFile();
+
+	//Last, a failed leak check aborts but the output of the run is kept
+	memory->EndOfRun(run);
 	delete G4AnalysisManager::Instance();
 }
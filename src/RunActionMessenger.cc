@@ -0,0 +1,36 @@
+#include "RunActionMessenger.hh"
+#include "RunAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+
+RunActionMessenger::RunActionMessenger(RunAction* run)
+	: G4UImessenger(),
+	  runAction(run)
+{
+
+	outputDir = new G4UIdirectory("/matrix/output/");
+	outputDir->SetGuidance("Histogram and ntuple output.");
+
+	fileCmd = new G4UIcmdWithAString("/matrix/output/file", this);
+	fileCmd->SetGuidance("Output file name, without extension (default matrix).");
+	fileCmd->SetParameterName("file", false);
+	fileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+RunActionMessenger::~RunActionMessenger()
+{
+
+	delete fileCmd;
+	delete outputDir;
+
+}
+
+void RunActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == fileCmd)
+		runAction->SetFileName(newValue);
+
+}
@@ -0,0 +1,276 @@
+#include "Analysis.hh"
+#include "RunCheckpoint.hh"
+#include "RunCheckpointMessenger.hh"
+#include "DetectorParameters.hh"
+#include "PrimaryGeneratorAction.hh"
+
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+	//Histograms the journal replays, Histogram_X and Histogram_Y by axis.
+	//Others (Timing_LE) are not journalled and start over on resume
+	const G4int kFirstJournalledH1 = 1;
+	const G4int kLastJournalledH1 = 2;
+
+}
+
+RunCheckpoint::RunCheckpoint()
+	: messenger(0),
+	  directory("checkpoint"),
+	  everyEvents(0),
+	  everyMinutes(0),
+	  resume(false),
+	  journal(0),
+	  firstEvent(0),
+	  totalEvents(0),
+	  lastEvent(-1),
+	  lastTime(0)
+{
+	messenger = new RunCheckpointMessenger(this);
+}
+
+RunCheckpoint::~RunCheckpoint()
+{
+
+	if(journal) std::fclose(journal);
+	delete messenger;
+
+}
+
+void RunCheckpoint::BeginOfRun(const G4Run* run)
+{
+
+	if(everyEvents <= 0 && everyMinutes <= 0 && !resume) return;
+
+	if(G4Threading::IsMultithreadedApplication()){
+		G4Exception("RunCheckpoint::BeginOfRun", "Checkpoint001", JustWarning,
+			    "Checkpoints need a sequential run, disabled");
+		return;
+	}
+
+	if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST){
+		G4ExceptionDescription msg;
+		msg << "Cannot create checkpoint directory " << directory;
+		G4Exception("RunCheckpoint::BeginOfRun", "Checkpoint002", JustWarning, msg);
+		return;
+	}
+
+	//Runs of forked workers start at an offset
+	const PrimaryGeneratorAction* generator = static_cast<const PrimaryGeneratorAction*>(
+		G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+	firstEvent = generator ? generator->GetFirstEventID() : 0;
+	totalEvents = run->GetNumberOfEventToBeProcessed();
+	lastEvent = firstEvent - 1;
+	lastTime = std::time(0);
+	pending.clear();
+
+	if(resume){
+		//Only the first run after start-up continues the interrupted one
+		resume = false;
+		Resume();
+	}
+	else journal = std::fopen(Path("rows.dat").c_str(), "wb");
+
+}
+
+void RunCheckpoint::EndOfEvent(G4int eventID)
+{
+
+	if(!journal) return;
+
+	if(!pending.empty()){
+		std::fwrite(&pending[0], sizeof(Row), pending.size(), journal);
+		pending.clear();
+	}
+
+	G4bool due = (everyEvents > 0 && eventID - lastEvent >= everyEvents)
+		  || (everyMinutes > 0 && std::difftime(std::time(0), lastTime) >= 60.*everyMinutes);
+	if(due) Write(eventID + 1);
+
+	//A resumed run stops at the length of the original one
+	if(eventID + 1 >= firstEvent + totalEvents) G4RunManager::GetRunManager()->AbortRun(true);
+
+}
+
+void RunCheckpoint::EndOfRun(const G4Run* run)
+{
+
+	if(!journal) return;
+
+	std::fclose(journal);
+	journal = 0;
+
+	//The run completed, nothing is left to resume
+	std::remove(Path("checkpoint.txt").c_str());
+	std::remove(Path("rows.dat").c_str());
+
+	G4cout<<"Run "<<run->GetRunID()<<" completed, checkpoint in "<<directory<<" cleared."<<G4endl;
+
+}
+
+void RunCheckpoint::Write(G4int nextEvent)
+{
+
+	std::fflush(journal);
+	fsync(fileno(journal));
+	long journalBytes = std::ftell(journal);
+
+	//Written aside and renamed so a kill never leaves a torn checkpoint
+	G4String fileName = Path("checkpoint.txt");
+	G4String tmpName = fileName + ".tmp";
+	std::ofstream out(tmpName.c_str());
+	out.precision(17);
+	out << "MatrixCheckpoint 2\n";
+	out << "nextEvent " << nextEvent << "\n";
+	out << "firstEvent " << firstEvent << "\n";
+	out << "totalEvents " << totalEvents << "\n";
+	out << "journalBytes " << journalBytes << "\n";
+
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+	for(G4int id = kFirstJournalledH1; id <= kLastJournalledH1; id++){
+		G4H1* h1 = analysisManager->GetH1(id);
+		if(!h1) continue;
+		G4int nBins = h1->axis().bins();
+		out << "H1 " << id << " " << h1->entries() << " " << nBins;
+		for(G4int i = 0; i < nBins; i++) out << " " << h1->bin_height(i);
+		out << "\n";
+	}
+
+	out << "engine\n";
+	G4Random::getTheEngine()->put(out);
+	out.close();
+
+	if(!out || std::rename(tmpName.c_str(), fileName.c_str()) != 0){
+		G4ExceptionDescription msg;
+		msg << "Failed to write checkpoint " << fileName;
+		G4Exception("RunCheckpoint::Write", "Checkpoint003", JustWarning, msg);
+		return;
+	}
+
+	lastEvent = nextEvent - 1;
+	lastTime = std::time(0);
+
+	G4cout<<"Checkpoint written at event "<<nextEvent<<" of "<<firstEvent<<" to "<<firstEvent + totalEvents - 1<<G4endl;
+
+}
+
+void RunCheckpoint::Resume()
+{
+
+	G4String fileName = Path("checkpoint.txt");
+	std::ifstream in(fileName.c_str());
+	G4String tag;
+	G4int version = 0;
+	in >> tag >> version;
+	if(!in || tag != "MatrixCheckpoint" || version != 2){
+		G4ExceptionDescription msg;
+		msg << "No usable checkpoint in " << directory << " to resume from";
+		G4Exception("RunCheckpoint::Resume", "Checkpoint004", FatalException, msg);
+		return;
+	}
+
+	G4int nextEvent = 0, savedFirst = 0, savedTotal = 0;
+	long journalBytes = 0;
+	std::vector<G4String> histograms;
+	while(in >> tag && tag != "engine"){
+		if(tag == "nextEvent") in >> nextEvent;
+		else if(tag == "firstEvent") in >> savedFirst;
+		else if(tag == "totalEvents") in >> savedTotal;
+		else if(tag == "journalBytes") in >> journalBytes;
+		else if(tag == "H1"){
+			std::string line;
+			std::getline(in, line);
+			histograms.push_back(line);
+		}
+	}
+	G4Random::getTheEngine()->get(in);
+
+	if(savedFirst != firstEvent || savedTotal != totalEvents){
+		G4ExceptionDescription msg;
+		msg << "Interrupted run had events " << savedFirst << " to " << savedFirst + savedTotal - 1
+		    << ", this one " << firstEvent << " to " << firstEvent + totalEvents - 1
+		    << "; stopping at " << savedFirst + savedTotal - 1;
+		G4Exception("RunCheckpoint::Resume", "Checkpoint005", JustWarning, msg);
+		firstEvent = savedFirst;
+		totalEvents = savedTotal;
+	}
+
+	//Rows of events after the checkpoint are simulated again
+	G4String journalName = Path("rows.dat");
+	if(truncate(journalName.c_str(), journalBytes) != 0){
+		G4ExceptionDescription msg;
+		msg << "Cannot rewind journal " << journalName;
+		G4Exception("RunCheckpoint::Resume", "Checkpoint006", FatalException, msg);
+		return;
+	}
+
+	std::FILE* replay = std::fopen(journalName.c_str(), "rb");
+	std::vector<Row> rows(4096);
+	std::size_t n;
+	while(replay && (n = std::fread(&rows[0], sizeof(Row), rows.size(), replay)) > 0)
+		for(std::size_t i = 0; i < n; i++) FillRow(rows[i]);
+	if(replay) std::fclose(replay);
+
+	//The replayed output must match what was recorded
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+	for(std::size_t k = 0; k < histograms.size(); k++){
+		std::istringstream is(histograms[k]);
+		G4int id, nBins;
+		G4double entries;
+		is >> id >> entries >> nBins;
+		if(id < kFirstJournalledH1 || id > kLastJournalledH1) continue;
+		G4H1* h1 = analysisManager->GetH1(id);
+		G4bool match = h1 && h1->entries() == entries && h1->axis().bins() == (unsigned)nBins;
+		for(G4int i = 0; match && i < nBins; i++){
+			G4double height;
+			is >> height;
+			match = std::fabs(h1->bin_height(i) - height) <= 1e-9*std::fabs(height);
+		}
+		if(!match){
+			G4ExceptionDescription msg;
+			msg << "Histogram " << id << " replayed from the journal differs from the checkpoint";
+			G4Exception("RunCheckpoint::Resume", "Checkpoint007", JustWarning, msg);
+		}
+	}
+
+	//Event IDs continue from the checkpoint
+	std::ostringstream command;
+	command << "/matrix/source/firstEvent " << nextEvent;
+	G4UImanager::GetUIpointer()->ApplyCommand(command.str());
+
+	journal = std::fopen(journalName.c_str(), "ab");
+	lastEvent = nextEvent - 1;
+
+	G4cout<<"Resuming from "<<fileName<<" at event "<<nextEvent<<" of "<<firstEvent<<" to "<<firstEvent + totalEvents - 1<<G4endl;
+
+}
+
+void RunCheckpoint::FillRow(const Row& row) const
+{
+
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+	analysisManager->FillNtupleIColumn(0,row.event);
+	analysisManager->FillNtupleIColumn(1,row.axis);
+	analysisManager->FillNtupleIColumn(2,row.channel);
+	analysisManager->FillNtupleIColumn(3,row.primary);
+	analysisManager->FillNtupleDColumn(4,row.weight);
+	analysisManager->FillNtupleIColumn(5,row.module);
+	analysisManager->AddNtupleRow();
+
+	analysisManager->FillH1(row.axis,ModuleTiling::AxisChannel(row.module,row.axis,row.channel),row.weight);
+
+}
@@ -0,0 +1,70 @@
+#include "RunCheckpointMessenger.hh"
+#include "RunCheckpoint.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+
+RunCheckpointMessenger::RunCheckpointMessenger(RunCheckpoint* check)
+	: G4UImessenger(),
+	  checkpoint(check)
+{
+
+	checkpointDir = new G4UIdirectory("/matrix/checkpoint/");
+	checkpointDir->SetGuidance("Periodic checkpoints of long runs and resume after a kill.");
+
+	directoryCmd = new G4UIcmdWithAString("/matrix/checkpoint/directory", this);
+	directoryCmd->SetGuidance("Directory holding the checkpoint and the output journal.");
+	directoryCmd->SetParameterName("dir", false);
+	directoryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	eventsCmd = new G4UIcmdWithAnInteger("/matrix/checkpoint/everyEvents", this);
+	eventsCmd->SetGuidance("Write a checkpoint every N events, 0 disables it.");
+	eventsCmd->SetParameterName("N", false);
+	eventsCmd->SetRange("N>=0");
+	eventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	minutesCmd = new G4UIcmdWithADouble("/matrix/checkpoint/everyMinutes", this);
+	minutesCmd->SetGuidance("Write a checkpoint every M minutes of wall time, 0 disables it.");
+	minutesCmd->SetParameterName("M", false);
+	minutesCmd->SetRange("M>=0.");
+	minutesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	resumeCmd = new G4UIcmdWithABool("/matrix/checkpoint/resume", this);
+	resumeCmd->SetGuidance("Continue the next run from the checkpoint in the directory.");
+	resumeCmd->SetGuidance("Use the same macro as the interrupted job; its /run/beamOn is cut short.");
+	resumeCmd->SetParameterName("resume", true);
+	resumeCmd->SetDefaultValue(true);
+	resumeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+RunCheckpointMessenger::~RunCheckpointMessenger()
+{
+
+	delete resumeCmd;
+	delete minutesCmd;
+	delete eventsCmd;
+	delete directoryCmd;
+	delete checkpointDir;
+
+}
+
+void RunCheckpointMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == directoryCmd)
+		checkpoint->SetDirectory(newValue);
+
+	else if(command == eventsCmd)
+		checkpoint->SetEveryEvents(eventsCmd->GetNewIntValue(newValue));
+
+	else if(command == minutesCmd)
+		checkpoint->SetEveryMinutes(minutesCmd->GetNewDoubleValue(newValue));
+
+	else if(command == resumeCmd)
+		checkpoint->SetResume(resumeCmd->GetNewBoolValue(newValue));
+
+}
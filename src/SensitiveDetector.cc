@@ -2,17 +2,20 @@
 #include "SensitiveDetector.hh"
 #include "Hits.hh"
 #include "RunAction.hh"
-#include "G4Event.hh"
-#include "G4RunManager.hh"
 #include "G4EventManager.hh"
+#include "TrackingAction.hh"
+#include "SubEventScheduler.hh"
+#include "DetectorParameters.hh"
 #include "G4OpticalPhoton.hh"
 #include "G4SDManager.hh"
 #include "G4StepPoint.hh"
+#include "G4Track.hh"
 
 SensitiveDetector::SensitiveDetector(const G4String& name, const G4String& hitsCName) 
 	: G4VSensitiveDetector(name),
 	  point(NULL),
 	  hitsCollection(NULL),
+	  hcID(-1),
 	  energy(0),
 	  pos(G4ThreeVector()),
 	  eDep(0)
@@ -23,11 +26,15 @@ SensitiveDetector::SensitiveDetector(const G4String& name, const G4String& hitsC
 SensitiveDetector::~SensitiveDetector()
 {}
 
-void SensitiveDetector::Initialize(G4HCofThisEvent* /*hce*/)
+void SensitiveDetector::Initialize(G4HCofThisEvent* hce)
 {
 
 	eDep = 0;
 
+	hitsCollection = new HitsCollection(SensitiveDetectorName, collectionName[0]);
+	if(hcID < 0) hcID = G4SDManager::GetSDMpointer()->GetCollectionID(hitsCollection);
+	hce->AddHitsCollection(hcID, hitsCollection);
+
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*)
@@ -47,31 +54,36 @@ G4bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*)
 		G4cout<<"************************ Readout error**************************"<<G4endl;
 	}
 
-	G4cout<<"Name: "<<rName<<"\tReplica: "<<channel<<G4endl;
-
-	G4RunManager* runManager = G4RunManager::GetRunManager();
-	G4int event = runManager->GetCurrentEvent()->GetEventID();
-
-	G4AnalysisManager *analysisManager = G4AnalysisManager::Instance();
-	analysisManager->FillNtupleIColumn(0,event);
-	analysisManager->FillNtupleIColumn(1,axis);
-	analysisManager->FillNtupleIColumn(2,channel);
-	analysisManager->AddNtupleRow();
-
-	analysisManager->FillH1(axis,channel);	
+	//Readout, then the module (Y replica) in its column (X replica); a
+	//geometry without modules has plain placements there, module 0
+	G4int module = 0;
+	if(tHandle->GetHistoryDepth() >= 3)
+		module = ModuleTiling::Module(tHandle->GetReplicaNumber(3), tHandle->GetReplicaNumber(2));
+
+	//Output is filled from the hits collection at the end of the event
+	G4Track* track = step->GetTrack();
+	Hits* hit = new Hits(track->GetTotalEnergy(), point->GetPosition());
+	//Arrival at the readout, since the start of the event
+	hit->setTime(point->GetGlobalTime());
+	hit->setModule(module);
+	hit->setAxis(axis);
+	hit->setChannel(channel);
+	hit->setWeight(track->GetWeight());
+
+	const TrackingAction* trackingAction = static_cast<const TrackingAction*>(
+		G4EventManager::GetEventManager()->GetUserTrackingAction());
+	if(trackingAction) hit->setPrimary(trackingAction->getCurrentPrimary());
+
+	//Photons of a batch belong to the event that queued it
+	PhotonBatch* batch = SubEventScheduler::CurrentBatch();
+	if(batch){
+		batch->hits.push_back(*hit);
+		delete hit;
+	}
+	else hitsCollection->insert(hit);
 
 	step->GetTrack()->SetTrackStatus(fStopAndKill);
 
 	return true;
 }
 
-void SensitiveDetector::EndOfEvent(G4HCofThisEvent*)
-{
-
-	G4RunManager* runManager = G4RunManager::GetRunManager();
-	G4int event = runManager->GetCurrentEvent()->GetEventID();
-
-	G4cout<<"Event: "<<event<<G4endl;
-
-}
-
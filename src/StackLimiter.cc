@@ -0,0 +1,278 @@
+#include "StackLimiter.hh"
+#include "StackLimiterMessenger.hh"
+#include "Run.hh"
+
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4StackManager.hh"
+#include "G4StackedTrack.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+	//Records moved to the scratch file at once
+	const std::size_t kChunk = 4096;
+
+	G4double MB(G4double bytes)
+	{
+		return bytes/(1024.*1024.);
+	}
+
+}
+
+StackLimiter::StackLimiter()
+	: messenger(0),
+	  memoryCap(0),
+	  capTracks(0),
+	  spillToDisk(false),
+	  spillDirectory(""),
+	  report(false),
+	  readIndex(0),
+	  fd(-1),
+	  fileRead(0),
+	  fileWritten(0),
+	  reloading(false),
+	  peakDepth(0),
+	  peakBytes(0),
+	  spilled(0)
+{
+	messenger = new StackLimiterMessenger(this);
+}
+
+StackLimiter::~StackLimiter()
+{
+	delete messenger;
+	if(fd >= 0) close(fd);
+}
+
+G4double StackLimiter::TrackBytes()
+{
+	return sizeof(G4Track) + sizeof(G4DynamicParticle) + sizeof(G4StackedTrack);
+}
+
+void StackLimiter::SetMemoryCap(G4double bytes)
+{
+	memoryCap = bytes;
+	capTracks = bytes > 0 ? std::max((G4long)1, (G4long)(bytes/TrackBytes())) : 0;
+}
+
+G4long StackLimiter::Pending() const
+{
+	return (fileWritten - fileRead) + (G4long)(buffer.size() - readIndex);
+}
+
+void StackLimiter::BeginOfEvent()
+{
+
+	//Left over only if the previous event was aborted
+	buffer.clear();
+	readIndex = 0;
+	fileRead = fileWritten = 0;
+	reloading = false;
+
+	peakDepth = 0;
+	peakBytes = 0;
+	spilled = 0;
+
+}
+
+G4bool StackLimiter::Spill(const G4Track* track, G4StackManager* stackManager)
+{
+
+	G4long depth = stackManager->GetNUrgentTrack() + stackManager->GetNWaitingTrack();
+	G4bool spill = capTracks > 0 && !reloading && depth >= capTracks
+		&& track->GetParentID() > 0 && track->GetDefinition() == G4OpticalPhoton::OpticalPhoton();
+
+	if(spill){
+		const G4DynamicParticle* particle = track->GetDynamicParticle();
+		Record record;
+		record.position = track->GetPosition();
+		record.direction = particle->GetMomentumDirection();
+		record.polarization = particle->GetPolarization();
+		record.energy = particle->GetKineticEnergy();
+		record.time = track->GetGlobalTime();
+		record.weight = track->GetWeight();
+		record.trackID = track->GetTrackID();
+		record.parentID = track->GetParentID();
+		record.creator = track->GetCreatorProcess();
+		buffer.push_back(record);
+		spilled++;
+		if(spillToDisk && buffer.size() - readIndex >= kChunk) FlushBuffer();
+	}
+	else depth++;
+
+	peakDepth = std::max(peakDepth, depth);
+	peakBytes = std::max(peakBytes, depth*TrackBytes() + (buffer.size() - readIndex)*sizeof(Record));
+
+	return spill;
+
+}
+
+void StackLimiter::Reload(G4StackManager* stackManager)
+{
+
+	if(Pending() == 0) return;
+
+	//Fill the stack up to the cap, oldest photons first; pushed tracks are
+	//classified again and must not be spilled back
+	G4long room = capTracks > 0 ? std::max((G4long)1, capTracks - stackManager->GetNUrgentTrack()) : Pending();
+	reloading = true;
+
+	std::vector<Record> chunk;
+	while(room > 0 && Pending() > 0){
+		if(fileWritten > fileRead){
+			G4long n = ReadFile(chunk, std::min(room, (G4long)kChunk));
+			for(G4long i = 0; i < n; i++) Push(chunk[i], stackManager);
+			room -= n;
+		}
+		else{
+			for(; room > 0 && readIndex < buffer.size(); room--) Push(buffer[readIndex++], stackManager);
+			if(readIndex == buffer.size()){
+				buffer.clear();
+				readIndex = 0;
+			}
+		}
+	}
+
+	reloading = false;
+
+}
+
+void StackLimiter::Push(const Record& record, G4StackManager* stackManager)
+{
+
+	G4DynamicParticle* particle = new G4DynamicParticle(G4OpticalPhoton::OpticalPhoton(),
+							     record.direction, record.energy);
+	particle->SetPolarization(record.polarization.x(), record.polarization.y(), record.polarization.z());
+
+	G4Track* track = new G4Track(particle, record.time, record.position);
+	track->SetTrackID(record.trackID);
+	track->SetParentID(record.parentID);
+	track->SetWeight(record.weight);
+	track->SetCreatorProcess(record.creator);
+	track->SetVertexPosition(record.position);
+	track->SetVertexMomentumDirection(record.direction);
+	track->SetVertexKineticEnergy(record.energy);
+
+	stackManager->PushOneTrack(track);
+
+}
+
+G4bool StackLimiter::OpenFile()
+{
+
+	if(fd >= 0) return true;
+
+	G4String dir = spillDirectory;
+	if(dir == ""){
+		const char* env = std::getenv("TMPDIR");
+		dir = env ? env : "/tmp";
+	}
+
+	//Unlinked right away, the file goes with the process
+	std::vector<char> path(dir.size() + 32);
+	std::snprintf(&path[0], path.size(), "%s/matrix-stack-XXXXXX", dir.c_str());
+	fd = mkstemp(&path[0]);
+	if(fd < 0){
+		G4ExceptionDescription msg;
+		msg << "Cannot create a scratch file in " << dir << ", spilled photons stay in memory";
+		G4Exception("StackLimiter::OpenFile", "Stack001", JustWarning, msg);
+		return false;
+	}
+	unlink(&path[0]);
+	return true;
+
+}
+
+void StackLimiter::FlushBuffer()
+{
+
+	if(!OpenFile()){
+		spillToDisk = false;
+		return;
+	}
+
+	//The file is empty or holds older photons than the buffer
+	const char* data = reinterpret_cast<const char*>(&buffer[readIndex]);
+	std::size_t size = (buffer.size() - readIndex)*sizeof(Record);
+	off_t offset = fileWritten*sizeof(Record);
+	std::size_t done = 0;
+	while(done < size){
+		ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+		if(n <= 0){
+			G4ExceptionDescription msg;
+			msg << "Cannot write spilled photons to the scratch file, keeping them in memory";
+			G4Exception("StackLimiter::FlushBuffer", "Stack002", JustWarning, msg);
+			spillToDisk = false;
+			return;
+		}
+		done += n;
+	}
+
+	fileWritten += buffer.size() - readIndex;
+	buffer.clear();
+	readIndex = 0;
+
+}
+
+G4long StackLimiter::ReadFile(std::vector<Record>& records, G4long max)
+{
+
+	G4long count = std::min(max, fileWritten - fileRead);
+	records.resize(count);
+
+	char* data = reinterpret_cast<char*>(&records[0]);
+	std::size_t size = count*sizeof(Record);
+	off_t offset = fileRead*sizeof(Record);
+	std::size_t done = 0;
+	while(done < size){
+		ssize_t n = pread(fd, data + done, size - done, offset + done);
+		if(n <= 0){
+			//Dropping photons would bias the event silently
+			G4ExceptionDescription msg;
+			msg << "Cannot read spilled photons back from the scratch file";
+			G4Exception("StackLimiter::ReadFile", "Stack003", FatalException, msg);
+			return 0;
+		}
+		done += n;
+	}
+
+	fileRead += count;
+	if(fileRead == fileWritten) fileRead = fileWritten = 0;
+	return count;
+
+}
+
+void StackLimiter::EndOfEvent(G4int eventID, Run* run)
+{
+
+	run->AddStackPeak(peakDepth, peakBytes);
+	run->AddSpilled(spilled);
+
+	if(!report) return;
+	G4cout<<"Event "<<eventID<<": peak stack "<<peakDepth<<" tracks (~"<<MB(peakBytes)<<" MB)";
+	if(spilled) G4cout<<", "<<spilled<<" optical photons spilled"<<(spillToDisk ? " to disk" : "");
+	G4cout<<G4endl;
+
+}
+
+void StackLimiter::EndOfRun(const G4Run* aRun)
+{
+
+	//Reported once, from the run the workers were merged into
+	if(!G4Threading::IsMasterThread()) return;
+
+	const Run* run = static_cast<const Run*>(aRun);
+	G4cout<<"  track stack: peak "<<run->GetStackPeakDepth()<<" tracks (~"<<MB(run->GetStackPeakBytes())<<" MB)";
+	if(memoryCap > 0)
+		G4cout<<", cap "<<MB(memoryCap)<<" MB, "<<run->GetSpilled()<<" optical photons spilled in "
+		      <<run->GetSpilledEvents()<<" events";
+	G4cout<<G4endl;
+
+}
@@ -0,0 +1,69 @@
+#include "StackLimiterMessenger.hh"
+#include "StackLimiter.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
+
+StackLimiterMessenger::StackLimiterMessenger(StackLimiter* stack)
+	: G4UImessenger(),
+	  limiter(stack)
+{
+
+	stackDir = new G4UIdirectory("/matrix/stack/");
+	stackDir->SetGuidance("Memory cap of the track stack.");
+
+	memoryCapCmd = new G4UIcmdWithADouble("/matrix/stack/memoryCap", this);
+	memoryCapCmd->SetGuidance("Memory in MB the stacked tracks of a thread may take, 0 for no cap.");
+	memoryCapCmd->SetGuidance("Optical photons beyond it are spilled and stacked again later.");
+	memoryCapCmd->SetParameterName("MB", false);
+	memoryCapCmd->SetRange("MB>=0.");
+	memoryCapCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	spillCmd = new G4UIcmdWithAString("/matrix/stack/spill", this);
+	spillCmd->SetGuidance("Where spilled photons wait: compact records in memory or a scratch file.");
+	spillCmd->SetParameterName("where", false);
+	spillCmd->SetCandidates("memory disk");
+	spillCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	spillDirectoryCmd = new G4UIcmdWithAString("/matrix/stack/spillDirectory", this);
+	spillDirectoryCmd->SetGuidance("Directory of the scratch files, $TMPDIR or /tmp by default.");
+	spillDirectoryCmd->SetParameterName("dir", false);
+	spillDirectoryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	reportCmd = new G4UIcmdWithABool("/matrix/stack/report", this);
+	reportCmd->SetGuidance("Print the peak stack depth and memory of every event.");
+	reportCmd->SetParameterName("report", true);
+	reportCmd->SetDefaultValue(true);
+	reportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+StackLimiterMessenger::~StackLimiterMessenger()
+{
+
+	delete reportCmd;
+	delete spillDirectoryCmd;
+	delete spillCmd;
+	delete memoryCapCmd;
+	delete stackDir;
+
+}
+
+void StackLimiterMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == memoryCapCmd)
+		limiter->SetMemoryCap(memoryCapCmd->GetNewDoubleValue(newValue)*1024.*1024.);
+
+	else if(command == spillCmd)
+		limiter->SetSpillToDisk(newValue == "disk");
+
+	else if(command == spillDirectoryCmd)
+		limiter->SetSpillDirectory(newValue);
+
+	else if(command == reportCmd)
+		limiter->SetReport(reportCmd->GetNewBoolValue(newValue));
+
+}
@@ -0,0 +1,44 @@
+#include "StackingAction.hh"
+#include "RunAction.hh"
+#include "SubEventScheduler.hh"
+#include "StackLimiter.hh"
+#include "TrackingAction.hh"
+
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4EventManager.hh"
+
+StackingAction::StackingAction(RunAction* run)
+	: G4UserStackingAction(),
+	  runAction(run)
+{}
+
+StackingAction::~StackingAction()
+{}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+
+	SubEventScheduler* scheduler = runAction->GetSubEventScheduler();
+	if(!scheduler->IsEnabled() || track->GetParentID() == 0 || track->GetDefinition() != G4OpticalPhoton::OpticalPhoton())
+		return runAction->GetStackLimiter()->Spill(track, stackManager) ? fKill : fUrgent;
+
+	//The parent is the track that just finished, its primary is current
+	const TrackingAction* trackingAction = static_cast<const TrackingAction*>(
+		G4EventManager::GetEventManager()->GetUserTrackingAction());
+	scheduler->Divert(track, trackingAction ? trackingAction->getCurrentPrimary() : 0);
+
+	return fKill;
+
+}
+
+void StackingAction::NewStage()
+{
+	//Spilled photons come back once the stack is empty
+	runAction->GetStackLimiter()->Reload(stackManager);
+}
+
+void StackingAction::PrepareNewEvent()
+{
+	runAction->GetStackLimiter()->BeginOfEvent();
+}
@@ -0,0 +1,30 @@
+#include "StartupTimer.hh"
+
+#include <chrono>
+#include <atomic>
+
+namespace {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::atomic<bool> firstEventSeen(false);
+}
+
+void StartupTimer::Start()
+{
+
+	start = std::chrono::steady_clock::now();
+
+}
+
+G4double StartupTimer::Elapsed()
+{
+
+	return std::chrono::duration<G4double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StartupTimer::FirstEvent()
+{
+
+	if(firstEventSeen.load(std::memory_order_relaxed) || firstEventSeen.exchange(true)) return;
+	G4cout<<"Time to first event: "<<Elapsed()<<" s"<<G4endl;
+
+}
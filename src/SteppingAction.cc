@@ -0,0 +1,115 @@
+#include "SteppingAction.hh"
+#include "SteppingActionMessenger.hh"
+#include "Run.hh"
+#include "RunAction.hh"
+#include "DepositRecorder.hh"
+#include "SubEventScheduler.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpBoundaryProcess.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessVector.hh"
+#include "G4RunManager.hh"
+#include "G4VPhysicalVolume.hh"
+
+SteppingAction::SteppingAction(RunAction* run)
+	: G4UserSteppingAction(),
+	  messenger(0),
+	  runAction(run),
+	  timeWindow(0),
+	  maxReflections(0),
+	  boundary(0),
+	  nReflections(0)
+{
+	messenger = new SteppingActionMessenger(this);
+}
+
+SteppingAction::~SteppingAction()
+{
+	delete messenger;
+}
+
+void SteppingAction::UserSteppingAction(const G4Step* step)
+{
+
+	G4Track* track = step->GetTrack();
+	if(track->GetDefinition() != G4OpticalPhoton::OpticalPhoton()){
+		DepositRecorder* deposits = runAction->GetDepositRecorder();
+		if(deposits->IsActive() && step->GetTotalEnergyDeposit() > 0) deposits->Record(step);
+		return;
+	}
+	if(track->GetTrackStatus() != fAlive) return;
+
+	//Photons are tracked one at a time, so one counter is enough
+	if(track->GetCurrentStepNumber() == 1) nReflections = 0;
+
+	Run* run = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	PhotonBatch* batch = SubEventScheduler::CurrentBatch();
+	G4StepPoint* post = step->GetPostStepPoint();
+
+	if(timeWindow > 0 && post->GetGlobalTime() > timeWindow){
+		track->SetTrackStatus(fStopAndKill);
+		Kill(run, batch, Run::kTimeWindow);
+		return;
+	}
+
+	if(post->GetStepStatus() != fGeomBoundary) return;
+	if(!boundary) boundary = FindBoundaryProcess();
+
+	G4bool reflected = false;
+	if(boundary){
+		switch(boundary->GetStatus()){
+			case FresnelReflection:
+			case TotalInternalReflection:
+			case LambertianReflection:
+			case LobeReflection:
+			case SpikeReflection:
+			case BackScattering:
+				reflected = true;
+				break;
+			default:
+				break;
+		}
+	}
+
+	if(reflected){
+		if(maxReflections > 0 && ++nReflections > maxReflections){
+			track->SetTrackStatus(fStopAndKill);
+			Kill(run, batch, Run::kReflections);
+		}
+		return;
+	}
+
+	//A reflected photon also ends its step on the far side, only a
+	//transmitted one has really entered the next volume
+	G4VPhysicalVolume* next = post->GetPhysicalVolume();
+	if(next && !escapeVolumes.empty() && escapeVolumes.count(next->GetName())){
+		track->SetTrackStatus(fStopAndKill);
+		Kill(run, batch, Run::kEscaped);
+	}
+
+}
+
+void SteppingAction::Kill(Run* run, PhotonBatch* batch, G4int reason) const
+{
+
+	//Batches are reduced into the owning event's run
+	if(batch) batch->killed[reason]++;
+	else run->AddKilled((Run::KillReason)reason);
+
+}
+
+G4OpBoundaryProcess* SteppingAction::FindBoundaryProcess() const
+{
+
+	G4ProcessManager* manager = G4OpticalPhoton::OpticalPhoton()->GetProcessManager();
+	G4ProcessVector* processes = manager->GetProcessList();
+	for(G4int i = 0; i < processes->size(); i++){
+		G4OpBoundaryProcess* process = dynamic_cast<G4OpBoundaryProcess*>((*processes)[i]);
+		if(process) return process;
+	}
+	return 0;
+
+}
@@ -0,0 +1,69 @@
+#include "SteppingActionMessenger.hh"
+#include "SteppingAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+SteppingActionMessenger::SteppingActionMessenger(SteppingAction* stepping)
+	: G4UImessenger(),
+	  steppingAction(stepping)
+{
+
+	policyDir = new G4UIdirectory("/matrix/photons/");
+	policyDir->SetGuidance("Termination policies for optical photons.");
+
+	escapeCmd = new G4UIcmdWithAString("/matrix/photons/escapeVolume", this);
+	escapeCmd->SetGuidance("Kill optical photons entering this physical volume (e.g. World, Detector).");
+	escapeCmd->SetParameterName("volume", false);
+	escapeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	clearEscapeCmd = new G4UIcmdWithoutParameter("/matrix/photons/clearEscapeVolumes", this);
+	clearEscapeCmd->SetGuidance("Remove all escape volumes.");
+	clearEscapeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	timeWindowCmd = new G4UIcmdWithADoubleAndUnit("/matrix/photons/timeWindow", this);
+	timeWindowCmd->SetGuidance("Kill optical photons past this global time, 0 disables it.");
+	timeWindowCmd->SetParameterName("time", false);
+	timeWindowCmd->SetRange("time>=0.");
+	timeWindowCmd->SetUnitCategory("Time");
+	timeWindowCmd->SetDefaultUnit("ns");
+	timeWindowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	reflectionsCmd = new G4UIcmdWithAnInteger("/matrix/photons/maxReflections", this);
+	reflectionsCmd->SetGuidance("Kill optical photons after N boundary reflections, 0 disables it.");
+	reflectionsCmd->SetParameterName("N", false);
+	reflectionsCmd->SetRange("N>=0");
+	reflectionsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+SteppingActionMessenger::~SteppingActionMessenger()
+{
+
+	delete reflectionsCmd;
+	delete timeWindowCmd;
+	delete clearEscapeCmd;
+	delete escapeCmd;
+	delete policyDir;
+
+}
+
+void SteppingActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == escapeCmd)
+		steppingAction->AddEscapeVolume(newValue);
+
+	else if(command == clearEscapeCmd)
+		steppingAction->ClearEscapeVolumes();
+
+	else if(command == timeWindowCmd)
+		steppingAction->SetTimeWindow(timeWindowCmd->GetNewDoubleValue(newValue));
+
+	else if(command == reflectionsCmd)
+		steppingAction->SetMaxReflections(reflectionsCmd->GetNewIntValue(newValue));
+
+}
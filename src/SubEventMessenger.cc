@@ -0,0 +1,38 @@
+#include "SubEventMessenger.hh"
+#include "SubEventScheduler.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+SubEventMessenger::SubEventMessenger(SubEventScheduler* sched)
+	: G4UImessenger(),
+	  scheduler(sched)
+{
+
+	subEventDir = new G4UIdirectory("/matrix/subEvent/");
+	subEventDir->SetGuidance("Parallel tracking of the optical photons of one event.");
+
+	batchSizeCmd = new G4UIcmdWithAnInteger("/matrix/subEvent/batchSize", this);
+	batchSizeCmd->SetGuidance("Optical photons per batch, 0 tracks them on the event's thread as usual.");
+	batchSizeCmd->SetGuidance("Results depend on the batch size, not on the number of threads.");
+	batchSizeCmd->SetParameterName("N", false);
+	batchSizeCmd->SetRange("N>=0");
+	batchSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+SubEventMessenger::~SubEventMessenger()
+{
+
+	delete batchSizeCmd;
+	delete subEventDir;
+
+}
+
+void SubEventMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == batchSizeCmd)
+		scheduler->SetBatchSize(batchSizeCmd->GetNewIntValue(newValue));
+
+}
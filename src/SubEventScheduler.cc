@@ -0,0 +1,306 @@
+#include "SubEventScheduler.hh"
+#include "SubEventMessenger.hh"
+
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
+#include "G4VTrajectory.hh"
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "Randomize.hh"
+#include "CLHEP/Random/MixMaxRng.h"
+
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+struct SubEventScheduler::Deque
+{
+	G4Mutex mutex;
+	std::deque<PhotonBatch*> batches;
+};
+
+namespace {
+
+	//Deques of all threads, and the threads still running events
+	G4Mutex registryMutex = G4MUTEX_INITIALIZER;
+	std::vector<SubEventScheduler::Deque*>* registry = 0;
+	std::atomic<int> activeOwners(0);
+	std::atomic<int> queued(0);
+
+	G4ThreadLocal PhotonBatch* currentBatch = 0;
+
+	//splitmix64, spreads the seeds of consecutive batches
+	unsigned long long Mix(unsigned long long x)
+	{
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	G4bool IsOwnerThread()
+	{
+		//The MT master only merges, it never runs events
+		return !(G4Threading::IsMultithreadedApplication() && G4Threading::IsMasterThread());
+	}
+
+}
+
+PhotonBatch::PhotonBatch()
+	: seed(0),
+	  tracked(0),
+	  currentPrimary(0),
+	  done(false)
+{
+	for(G4int i = 0; i < Run::kNumberOfKillReasons; i++) killed[i] = 0;
+}
+
+SubEventScheduler::SubEventScheduler()
+	: messenger(0),
+	  batchSize(0),
+	  registered(false),
+	  open(0),
+	  seeded(false),
+	  eventKey(0),
+	  deque(0),
+	  engine(0)
+{
+	deque = new Deque;
+	G4MUTEXINIT(deque->mutex);
+	messenger = new SubEventMessenger(this);
+}
+
+SubEventScheduler::~SubEventScheduler()
+{
+
+	delete messenger;
+
+	{
+		G4AutoLock lock(&registryMutex);
+		if(registry) registry->erase(std::remove(registry->begin(), registry->end(), deque), registry->end());
+	}
+
+	G4MUTEXDESTROY(deque->mutex);
+	delete deque;
+	delete engine;
+
+}
+
+PhotonBatch* SubEventScheduler::CurrentBatch()
+{
+	return currentBatch;
+}
+
+void SubEventScheduler::BeginOfRun()
+{
+
+	if(!IsEnabled() || !IsOwnerThread()) return;
+
+	if(!registered){
+		G4AutoLock lock(&registryMutex);
+		if(!registry) registry = new std::vector<Deque*>;
+		registry->push_back(deque);
+		registered = true;
+	}
+	activeOwners++;
+
+}
+
+void SubEventScheduler::EndOfRun()
+{
+
+	if(!IsEnabled() || !IsOwnerThread() || !registered) return;
+
+	//Out of events: help the threads still busy with large ones
+	activeOwners--;
+	while(activeOwners.load() > 0 || queued.load() > 0){
+		PhotonBatch* batch = Steal();
+		if(batch) Track(batch);
+		else std::this_thread::yield();
+	}
+
+}
+
+void SubEventScheduler::BeginOfEvent()
+{
+
+	eventBatches.clear();
+	open = 0;
+	seeded = false;
+
+}
+
+void SubEventScheduler::Divert(const G4Track* track, G4int primary)
+{
+
+	//Batch seeds derive from one draw of the event's own stream
+	if(!seeded){
+		eventKey = ((unsigned long long)(G4UniformRand()*4294967296.) << 32)
+			 ^ (unsigned long long)(G4UniformRand()*4294967296.);
+		seeded = true;
+	}
+
+	if(!open){
+		open = new PhotonBatch;
+		open->seed = (long)(Mix(eventKey + eventBatches.size()) >> 2) + 1;
+		open->photons.reserve(batchSize);
+		eventBatches.push_back(open);
+	}
+
+	PhotonBatch::Photon photon;
+	photon.position = track->GetPosition();
+	photon.direction = track->GetMomentumDirection();
+	photon.polarization = track->GetPolarization();
+	photon.energy = track->GetKineticEnergy();
+	photon.time = track->GetGlobalTime();
+	photon.weight = track->GetWeight();
+	photon.trackID = track->GetTrackID();
+	photon.parentID = track->GetParentID();
+	photon.primary = primary;
+	open->photons.push_back(photon);
+
+	if((G4int)open->photons.size() >= batchSize){
+		Queue(open);
+		open = 0;
+	}
+
+}
+
+G4long SubEventScheduler::FinishEvent(HitsCollection* hits, Run* run)
+{
+
+	if(open){
+		Queue(open);
+		open = 0;
+	}
+
+	//Own batches first, then help others while ours are being stolen
+	std::size_t nDone = 0;
+	for(;;){
+		while(nDone < eventBatches.size() && eventBatches[nDone]->done.load(std::memory_order_acquire)) nDone++;
+		if(nDone == eventBatches.size()) break;
+
+		PhotonBatch* batch = PopOwn();
+		if(!batch) batch = Steal();
+		if(batch) Track(batch);
+		else std::this_thread::yield();
+	}
+
+	//Reduced in batch order, whoever tracked them
+	G4long tracked = 0;
+	for(std::size_t i = 0; i < eventBatches.size(); i++){
+		PhotonBatch* batch = eventBatches[i];
+		for(std::size_t k = 0; hits && k < batch->hits.size(); k++) hits->insert(new Hits(batch->hits[k]));
+		for(G4int r = 0; run && r < Run::kNumberOfKillReasons; r++) run->AddKilled((Run::KillReason)r, batch->killed[r]);
+		tracked += batch->tracked;
+		delete batch;
+	}
+	eventBatches.clear();
+
+	return tracked;
+
+}
+
+void SubEventScheduler::Queue(PhotonBatch* batch)
+{
+
+	G4AutoLock lock(&deque->mutex);
+	deque->batches.push_back(batch);
+	queued++;
+
+}
+
+PhotonBatch* SubEventScheduler::PopOwn()
+{
+
+	G4AutoLock lock(&deque->mutex);
+	if(deque->batches.empty()) return 0;
+	PhotonBatch* batch = deque->batches.back();
+	deque->batches.pop_back();
+	queued--;
+	return batch;
+
+}
+
+PhotonBatch* SubEventScheduler::Steal()
+{
+
+	if(queued.load(std::memory_order_relaxed) <= 0) return 0;
+
+	G4AutoLock lock(&registryMutex);
+	if(!registry) return 0;
+	for(std::size_t i = 0; i < registry->size(); i++){
+		Deque* victim = (*registry)[i];
+		G4AutoLock victimLock(&victim->mutex);
+		if(victim->batches.empty()) continue;
+		PhotonBatch* batch = victim->batches.front();
+		victim->batches.pop_front();
+		queued--;
+		return batch;
+	}
+	return 0;
+
+}
+
+void SubEventScheduler::Track(PhotonBatch* batch)
+{
+
+	//The batch's own engine keeps the result independent of the thread
+	if(!engine) engine = new CLHEP::MixMaxRng;
+	engine->setSeed(batch->seed, 0);
+	CLHEP::HepRandomEngine* saved = G4Random::getTheEngine();
+	G4Random::setTheEngine(engine);
+	PhotonBatch* outer = currentBatch;
+	currentBatch = batch;
+
+	G4TrackingManager* trackingManager = G4EventManager::GetEventManager()->GetTrackingManager();
+	G4int nextID = 1 << 30;
+	std::vector<G4Track*> stack;
+
+	for(std::size_t i = 0; i < batch->photons.size(); i++){
+		const PhotonBatch::Photon& photon = batch->photons[i];
+		batch->currentPrimary = photon.primary;
+
+		G4DynamicParticle* particle = new G4DynamicParticle(G4OpticalPhoton::OpticalPhoton(),
+								     photon.direction, photon.energy);
+		particle->SetPolarization(photon.polarization.x(), photon.polarization.y(), photon.polarization.z());
+		G4Track* track = new G4Track(particle, photon.time, photon.position);
+		track->SetTrackID(photon.trackID);
+		track->SetParentID(photon.parentID);
+		track->SetWeight(photon.weight);
+		stack.push_back(track);
+
+		//Re-emitted (WLS) photons are followed depth first
+		while(!stack.empty()){
+			G4Track* current = stack.back();
+			stack.pop_back();
+			trackingManager->ProcessOneTrack(current);
+			batch->tracked++;
+
+			G4VTrajectory* trajectory = trackingManager->GimmeTrajectory();
+			if(trajectory){
+				delete trajectory;
+				trackingManager->SetTrajectory(0);
+			}
+
+			G4TrackVector* secondaries = trackingManager->GimmeSecondaries();
+			for(std::size_t k = 0; secondaries && k < secondaries->size(); k++){
+				G4Track* secondary = (*secondaries)[k];
+				secondary->SetParentID(current->GetTrackID());
+				secondary->SetTrackID(nextID++);
+				stack.push_back(secondary);
+			}
+			if(secondaries) secondaries->clear();
+
+			delete current;
+		}
+	}
+
+	currentBatch = outer;
+	G4Random::setTheEngine(saved);
+	batch->done.store(true, std::memory_order_release);
+
+}
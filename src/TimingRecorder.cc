@@ -0,0 +1,212 @@
+#include "Analysis.hh"
+#include "TimingRecorder.hh"
+#include "TimingRecorderMessenger.hh"
+#include "Run.hh"
+
+#include "G4Event.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+	//Bins per channel, beyond that the window wants a coarser binning
+	const G4int kMaxBins = 100000;
+
+}
+
+TimingRecorder::TimingRecorder()
+	: messenger(0),
+	  enabled(false),
+	  mode(kHistogram),
+	  binWidth(50.*ps),
+	  window(20.*ns),
+	  firstPhotons(8),
+	  threshold(1.),
+	  totThreshold(1.),
+	  nBins(0),
+	  nKept(0),
+	  ntupleID(-1),
+	  histoID(-1)
+{
+	messenger = new TimingRecorderMessenger(this);
+}
+
+TimingRecorder::~TimingRecorder()
+{
+	delete messenger;
+}
+
+void TimingRecorder::BeginOfRun(const G4Run*)
+{
+
+	if(!enabled) return;
+
+	G4int nChannels = ModuleTiling::NumberOfChannels();
+	nBins = 0;
+	nKept = 0;
+	bins.clear();
+	times.clear();
+	kept.clear();
+	if(mode == kHistogram){
+		nBins = std::max(1, (G4int)std::ceil(window/binWidth));
+		if(nBins > kMaxBins){
+			G4ExceptionDescription msg;
+			msg << "A window of " << window/ns << " ns in bins of " << binWidth/ps << " ps needs "
+			    << nBins << " bins per channel, using " << kMaxBins;
+			G4Exception("TimingRecorder::BeginOfRun", "Timing001", JustWarning, msg);
+			nBins = kMaxBins;
+		}
+		bins.assign((std::size_t)nChannels*nBins, 0.f);
+	}
+	else{
+		//Enough photons kept to see the leading edge
+		nKept = std::max(firstPhotons, (G4int)std::ceil(threshold));
+		times.assign((std::size_t)nChannels*nKept, 0.);
+		kept.assign(nChannels, 0);
+	}
+	counts.assign(nChannels, 0);
+	photons.assign(nChannels, 0.);
+	earliest.assign(nChannels, 0.);
+	touched.clear();
+
+	//Booked on every thread, after the hit ntuple and histograms
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+	ntupleID = analysisManager->CreateNtuple("timing", "event-module-axis-channel timing summary");
+	analysisManager->CreateNtupleIColumn(ntupleID, "event");
+	analysisManager->CreateNtupleIColumn(ntupleID, "module");
+	analysisManager->CreateNtupleIColumn(ntupleID, "axis");
+	analysisManager->CreateNtupleIColumn(ntupleID, "channel");
+	analysisManager->CreateNtupleDColumn(ntupleID, "photons");
+	analysisManager->CreateNtupleDColumn(ntupleID, "first");
+	analysisManager->CreateNtupleDColumn(ntupleID, "leadingEdge");
+	analysisManager->CreateNtupleDColumn(ntupleID, "tot");
+	analysisManager->FinishNtuple(ntupleID);
+
+	histoID = analysisManager->CreateH1("Timing_LE", "Leading edge time per channel (ns)", 200, 0., window/ns);
+
+}
+
+void TimingRecorder::EndOfEvent(const G4Event* event, HitsCollection* hits, Run* run)
+{
+
+	if(!enabled || !hits) return;
+
+	G4long late = 0;
+	G4int nHits = hits->entries();
+	G4int nChannels = (G4int)photons.size();
+	for(G4int i = 0; i < nHits; i++){
+		Hits* hit = (*hits)[i];
+		if(hit->getAxis() <= 0) continue;
+		G4int id = ModuleTiling::ChannelID(hit->getModule(), hit->getAxis(), hit->getChannel());
+		if(id < 0 || id >= nChannels) continue;
+		G4double t = hit->getTime();
+
+		if(counts[id]++ == 0){
+			touched.push_back(id);
+			earliest[id] = t;
+		}
+		else earliest[id] = std::min(earliest[id], t);
+		photons[id] += hit->getWeight();
+
+		if(mode == kHistogram){
+			G4int bin = t >= 0 ? (G4int)(t/binWidth) : -1;
+			if(bin >= 0 && bin < nBins) bins[(std::size_t)id*nBins + bin] += hit->getWeight();
+			else late++;
+		}
+		else{
+			//Insertion into the ascending first N of the channel
+			G4double* first = &times[(std::size_t)id*nKept];
+			G4int& n = kept[id];
+			if(n == nKept && t >= first[n - 1]) continue;
+			G4int k = n < nKept ? n++ : n - 1;
+			for(; k > 0 && first[k - 1] > t; k--) first[k] = first[k - 1];
+			first[k] = t;
+		}
+	}
+
+	G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+	G4int eventID = event->GetEventID();
+	for(std::size_t i = 0; i < touched.size(); i++){
+		G4int id = touched[i];
+		G4double n, first, leadingEdge, tot;
+		Summarize(id, n, first, leadingEdge, tot);
+
+		G4int module, axis, channel;
+		ModuleTiling::DecodeChannel(id, module, axis, channel);
+		analysisManager->FillNtupleIColumn(ntupleID, 0, eventID);
+		analysisManager->FillNtupleIColumn(ntupleID, 1, module);
+		analysisManager->FillNtupleIColumn(ntupleID, 2, axis);
+		analysisManager->FillNtupleIColumn(ntupleID, 3, channel);
+		analysisManager->FillNtupleDColumn(ntupleID, 4, n);
+		analysisManager->FillNtupleDColumn(ntupleID, 5, first/ns);
+		analysisManager->FillNtupleDColumn(ntupleID, 6, leadingEdge >= 0 ? leadingEdge/ns : -1.);
+		analysisManager->FillNtupleDColumn(ntupleID, 7, tot/ns);
+		analysisManager->AddNtupleRow(ntupleID);
+
+		if(leadingEdge >= 0){
+			analysisManager->FillH1(histoID, leadingEdge/ns);
+			run->AddLeadingEdge(leadingEdge);
+		}
+
+		//Ready for the next event
+		counts[id] = 0;
+		photons[id] = 0;
+		if(mode == kHistogram) std::fill(bins.begin() + (std::size_t)id*nBins, bins.begin() + (std::size_t)(id + 1)*nBins, 0.f);
+		else kept[id] = 0;
+	}
+	run->AddReadouts(touched.size());
+	run->AddLatePhotons(late);
+	touched.clear();
+
+}
+
+void TimingRecorder::Summarize(G4int id, G4double& n, G4double& first, G4double& leadingEdge, G4double& tot) const
+{
+
+	n = photons[id];
+	first = earliest[id];
+	leadingEdge = -1;
+	tot = 0;
+
+	if(mode == kFirstPhotons){
+		G4int k = std::max(1, (G4int)std::ceil(threshold));
+		if(kept[id] >= k) leadingEdge = times[(std::size_t)id*nKept + k - 1];
+		return;
+	}
+
+	const G4float* pulse = &bins[(std::size_t)id*nBins];
+	G4double sum = 0;
+	for(G4int b = 0; b < nBins && leadingEdge < 0; b++){
+		if(pulse[b] > 0 && sum + pulse[b] >= threshold)
+			leadingEdge = (b + (threshold - sum)/pulse[b])*binWidth;
+		sum += pulse[b];
+	}
+
+	G4int rise = 0;
+	while(rise < nBins && pulse[rise] < totThreshold) rise++;
+	G4int fall = rise;
+	while(fall < nBins && pulse[fall] >= totThreshold) fall++;
+	tot = (fall - rise)*binWidth;
+
+}
+
+void TimingRecorder::EndOfRun(const G4Run* aRun)
+{
+
+	//Reported once, from the run the workers were merged into
+	if(!enabled || !G4Threading::IsMasterThread()) return;
+
+	const Run* run = static_cast<const Run*>(aRun);
+	G4cout<<"Timing: "<<run->GetReadouts()<<" channel readouts";
+	G4long edges = run->GetLeadingEdges();
+	if(edges > 0){
+		G4double mean = run->GetLeadingEdgeSum()/edges;
+		G4double rms = std::sqrt(std::max(0., run->GetLeadingEdgeSum2()/edges - mean*mean));
+		G4cout<<", leading edge "<<mean/ns<<" ns, rms "<<rms/ps<<" ps";
+	}
+	if(mode == kHistogram) G4cout<<", "<<run->GetLatePhotons()<<" photons outside the "<<window/ns<<" ns window";
+	G4cout<<G4endl;
+
+}
@@ -0,0 +1,103 @@
+#include "TimingRecorderMessenger.hh"
+#include "TimingRecorder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+TimingRecorderMessenger::TimingRecorderMessenger(TimingRecorder* timing)
+	: G4UImessenger(),
+	  recorder(timing)
+{
+
+	timingDir = new G4UIdirectory("/matrix/timing/");
+	timingDir->SetGuidance("Photon arrival times per readout channel, summarized per event.");
+
+	enableCmd = new G4UIcmdWithABool("/matrix/timing/enable", this);
+	enableCmd->SetGuidance("Write a timing summary row per channel and event (ntuple \"timing\").");
+	enableCmd->SetParameterName("enable", true);
+	enableCmd->SetDefaultValue(true);
+	enableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	modeCmd = new G4UIcmdWithAString("/matrix/timing/mode", this);
+	modeCmd->SetGuidance("Fixed-width time histogram per channel, or its first N arrival times.");
+	modeCmd->SetParameterName("mode", false);
+	modeCmd->SetCandidates("histogram firstPhotons");
+	modeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	binWidthCmd = new G4UIcmdWithADoubleAndUnit("/matrix/timing/binWidth", this);
+	binWidthCmd->SetGuidance("Bin width of the channel histograms.");
+	binWidthCmd->SetParameterName("width", false);
+	binWidthCmd->SetRange("width>0.");
+	binWidthCmd->SetUnitCategory("Time");
+	binWidthCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	windowCmd = new G4UIcmdWithADoubleAndUnit("/matrix/timing/window", this);
+	windowCmd->SetGuidance("Time range of the channel histograms, from the start of the event.");
+	windowCmd->SetParameterName("window", false);
+	windowCmd->SetRange("window>0.");
+	windowCmd->SetUnitCategory("Time");
+	windowCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	firstPhotonsCmd = new G4UIcmdWithAnInteger("/matrix/timing/firstPhotons", this);
+	firstPhotonsCmd->SetGuidance("Arrival times kept per channel in firstPhotons mode.");
+	firstPhotonsCmd->SetParameterName("N", false);
+	firstPhotonsCmd->SetRange("N>0");
+	firstPhotonsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	thresholdCmd = new G4UIcmdWithADouble("/matrix/timing/threshold", this);
+	thresholdCmd->SetGuidance("Photons a channel must collect for its leading edge.");
+	thresholdCmd->SetParameterName("photons", false);
+	thresholdCmd->SetRange("photons>0.");
+	thresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	totThresholdCmd = new G4UIcmdWithADouble("/matrix/timing/totThreshold", this);
+	totThresholdCmd->SetGuidance("Photons per bin the pulse must reach for the time over threshold.");
+	totThresholdCmd->SetParameterName("photons", false);
+	totThresholdCmd->SetRange("photons>0.");
+	totThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+TimingRecorderMessenger::~TimingRecorderMessenger()
+{
+
+	delete totThresholdCmd;
+	delete thresholdCmd;
+	delete firstPhotonsCmd;
+	delete windowCmd;
+	delete binWidthCmd;
+	delete modeCmd;
+	delete enableCmd;
+	delete timingDir;
+
+}
+
+void TimingRecorderMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == enableCmd)
+		recorder->SetEnabled(enableCmd->GetNewBoolValue(newValue));
+
+	else if(command == modeCmd)
+		recorder->SetMode(newValue == "firstPhotons" ? TimingRecorder::kFirstPhotons : TimingRecorder::kHistogram);
+
+	else if(command == binWidthCmd)
+		recorder->SetBinWidth(binWidthCmd->GetNewDoubleValue(newValue));
+
+	else if(command == windowCmd)
+		recorder->SetWindow(windowCmd->GetNewDoubleValue(newValue));
+
+	else if(command == firstPhotonsCmd)
+		recorder->SetFirstPhotons(firstPhotonsCmd->GetNewIntValue(newValue));
+
+	else if(command == thresholdCmd)
+		recorder->SetThreshold(thresholdCmd->GetNewDoubleValue(newValue));
+
+	else if(command == totThresholdCmd)
+		recorder->SetToTThreshold(totThresholdCmd->GetNewDoubleValue(newValue));
+
+}
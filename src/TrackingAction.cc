@@ -0,0 +1,110 @@
+#include "TrackingAction.hh"
+#include "TrackingActionMessenger.hh"
+#include "Trajectory.hh"
+#include "PrimaryInformation.hh"
+#include "SubEventScheduler.hh"
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4TrackingManager.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4DynamicParticle.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4OpticalPhoton.hh"
+
+TrackingAction::TrackingAction()
+	: G4UserTrackingAction(),
+	  messenger(0),
+	  primaryOfTrack(1024, 0),
+	  currentPrimary(0),
+	  opticalPhotons(0),
+	  lastTrackID(0),
+	  photonSampling(1),
+	  detectedOnly(false),
+	  maxPoints(0),
+	  storeMode(0),
+	  suppressed(false),
+	  photonSerial(0)
+{
+	messenger = new TrackingActionMessenger(this);
+}
+
+TrackingAction::~TrackingAction()
+{
+	delete messenger;
+}
+
+void TrackingAction::PreUserTrackingAction(const G4Track* track)
+{
+
+	G4int id = track->GetTrackID();
+
+	SelectTrajectory(track);
+
+	//Batched photons may be tracked on another thread, the batch knows
+	PhotonBatch* batch = SubEventScheduler::CurrentBatch();
+	if(batch){
+		currentPrimary = batch->currentPrimary;
+		return;
+	}
+
+	//Track 1 opens every event
+	if(id == 1) opticalPhotons = lastTrackID = 0;
+	if(id > lastTrackID) lastTrackID = id;
+	if(track->GetDefinition() == G4OpticalPhoton::OpticalPhoton()) opticalPhotons++;
+
+	if(track->GetParentID() == 0){
+		G4PrimaryParticle* primary = track->GetDynamicParticle()->GetPrimaryParticle();
+		PrimaryInformation* info = primary ? static_cast<PrimaryInformation*>(primary->GetUserInformation()) : 0;
+		currentPrimary = info ? info->getIndex() : 0;
+	}
+	else currentPrimary = primaryOfTrack[track->GetParentID()];
+
+	//Entries of previous events are overwritten before they are read again
+	if(id >= (G4int)primaryOfTrack.size()) primaryOfTrack.resize(2*id, 0);
+	primaryOfTrack[id] = currentPrimary;
+
+}
+
+void TrackingAction::PostUserTrackingAction(const G4Track* track)
+{
+
+	if(!detectedOnly || suppressed || storeMode == 0) return;
+	if(track->GetDefinition() != G4OpticalPhoton::OpticalPhoton()) return;
+
+	//Detected photons are killed by the readout in their last step
+	G4VPhysicalVolume* volume = track->GetStep()->GetPreStepPoint()->GetPhysicalVolume();
+	G4bool detected = volume && (volume->GetName() == "RO_X" || volume->GetName() == "RO_Y");
+
+	//The tracking manager deletes the trajectory instead of handing it over
+	if(!detected){
+		fpTrackingManager->SetStoreTrajectory(0);
+		suppressed = true;
+	}
+
+}
+
+G4bool TrackingAction::FiltersTrajectories() const
+{
+	return !trajectoryParticles.empty() || photonSampling != 1 || detectedOnly || maxPoints > 0;
+}
+
+void TrackingAction::SelectTrajectory(const G4Track* track)
+{
+
+	//A 0 left by the previous track is ours, not the user's
+	G4int mode = fpTrackingManager->GetStoreTrajectory();
+	if(!suppressed || mode != 0) storeMode = mode;
+	suppressed = false;
+	if(storeMode == 0 || !FiltersTrajectories()) return;
+
+	const G4ParticleDefinition* particle = track->GetDefinition();
+	G4bool keep = trajectoryParticles.empty() || trajectoryParticles.count(particle->GetParticleName());
+	if(keep && particle == G4OpticalPhoton::OpticalPhoton() && photonSampling != 1)
+		keep = photonSampling > 0 && photonSerial%photonSampling == 0;
+	if(particle == G4OpticalPhoton::OpticalPhoton()) photonSerial++;
+
+	fpTrackingManager->SetStoreTrajectory(keep ? storeMode : 0);
+	suppressed = !keep;
+	if(keep && maxPoints > 0) fpTrackingManager->SetTrajectory(new Trajectory(track, maxPoints));
+
+}
@@ -0,0 +1,77 @@
+#include "TrackingActionMessenger.hh"
+#include "TrackingAction.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithABool.hh"
+
+TrackingActionMessenger::TrackingActionMessenger(TrackingAction* tracking)
+	: G4UImessenger(),
+	  trackingAction(tracking)
+{
+
+	trajectoryDir = new G4UIdirectory("/matrix/trajectories/");
+	trajectoryDir->SetGuidance("Which trajectories are stored, when /tracking/storeTrajectory is on.");
+
+	particleCmd = new G4UIcmdWithAString("/matrix/trajectories/particle", this);
+	particleCmd->SetGuidance("Store trajectories of this particle; without any, of all particles.");
+	particleCmd->SetParameterName("particle", false);
+	particleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	clearParticlesCmd = new G4UIcmdWithoutParameter("/matrix/trajectories/clearParticles", this);
+	clearParticlesCmd->SetGuidance("Store trajectories of all particles again.");
+	clearParticlesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	samplingCmd = new G4UIcmdWithAnInteger("/matrix/trajectories/photonSampling", this);
+	samplingCmd->SetGuidance("Store one optical photon trajectory in N, 0 stores none.");
+	samplingCmd->SetParameterName("N", false);
+	samplingCmd->SetRange("N>=0");
+	samplingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	detectedOnlyCmd = new G4UIcmdWithABool("/matrix/trajectories/detectedOnly", this);
+	detectedOnlyCmd->SetGuidance("Store only optical photons detected in RO_X or RO_Y.");
+	detectedOnlyCmd->SetParameterName("detectedOnly", true);
+	detectedOnlyCmd->SetDefaultValue(true);
+	detectedOnlyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+	maxPointsCmd = new G4UIcmdWithAnInteger("/matrix/trajectories/maxPoints", this);
+	maxPointsCmd->SetGuidance("Thin trajectories to at most N points, 0 keeps them all.");
+	maxPointsCmd->SetParameterName("N", false);
+	maxPointsCmd->SetRange("N>=0");
+	maxPointsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+}
+
+TrackingActionMessenger::~TrackingActionMessenger()
+{
+
+	delete maxPointsCmd;
+	delete detectedOnlyCmd;
+	delete samplingCmd;
+	delete clearParticlesCmd;
+	delete particleCmd;
+	delete trajectoryDir;
+
+}
+
+void TrackingActionMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+
+	if(command == particleCmd)
+		trackingAction->AddTrajectoryParticle(newValue);
+
+	else if(command == clearParticlesCmd)
+		trackingAction->ClearTrajectoryParticles();
+
+	else if(command == samplingCmd)
+		trackingAction->SetPhotonSampling(samplingCmd->GetNewIntValue(newValue));
+
+	else if(command == detectedOnlyCmd)
+		trackingAction->SetDetectedOnly(detectedOnlyCmd->GetNewBoolValue(newValue));
+
+	else if(command == maxPointsCmd)
+		trackingAction->SetMaxTrajectoryPoints(maxPointsCmd->GetNewIntValue(newValue));
+
+}
@@ -0,0 +1,89 @@
+#include "Trajectory.hh"
+#include "G4Track.hh"
+#include "G4Step.hh"
+
+G4ThreadLocal G4Allocator<Trajectory>* TrajectoryAllocator = 0;
+
+Trajectory::Trajectory(const G4Track* track, G4int max)
+	: G4VTrajectory(),
+	  trackID(track->GetTrackID()),
+	  parentID(track->GetParentID()),
+	  particle(track->GetDefinition()),
+	  initialMomentum(track->GetMomentum()),
+	  maxPoints(max < 2 ? 2 : max),
+	  stride(1),
+	  sinceKept(0),
+	  hasTail(false),
+	  tailPoint(0)
+{
+	points.reserve(maxPoints);
+	points.push_back(new G4TrajectoryPoint(track->GetPosition()));
+}
+
+Trajectory::~Trajectory()
+{
+
+	for(std::size_t i = 0; i < points.size(); i++) delete points[i];
+	delete tailPoint;
+
+}
+
+void Trajectory::AppendStep(const G4Step* step)
+{
+	Keep(step->GetPostStepPoint()->GetPosition());
+}
+
+void Trajectory::Keep(const G4ThreeVector& position)
+{
+
+	//A point made of the old tail is stale
+	delete tailPoint;
+	tailPoint = 0;
+	if(++sinceKept < stride){
+		tail = position;
+		hasTail = true;
+		return;
+	}
+
+	hasTail = false;
+	sinceKept = 0;
+	points.push_back(new G4TrajectoryPoint(position));
+	if((G4int)points.size() >= maxPoints) Decimate();
+
+}
+
+void Trajectory::Decimate()
+{
+
+	//Keeps the even points, the vertex among them; a dropped latest
+	//position waits as the tail
+	std::size_t kept = 0, last = points.size() - 1;
+	for(std::size_t i = 0; i < points.size(); i++){
+		if(i%2 == 0) points[kept++] = points[i];
+		else{
+			if(i == last){
+				tail = points[i]->GetPosition();
+				hasTail = true;
+			}
+			delete points[i];
+		}
+	}
+	points.resize(kept);
+	stride *= 2;
+
+}
+
+G4TrajectoryPoint* Trajectory::TailPoint() const
+{
+	if(!tailPoint) tailPoint = new G4TrajectoryPoint(tail);
+	return tailPoint;
+}
+
+void Trajectory::MergeTrajectory(G4VTrajectory* second)
+{
+
+	if(!second) return;
+	//The first point of the second trajectory is the last one of this
+	for(G4int i = 1; i < second->GetPointEntries(); i++) Keep(second->GetPoint(i)->GetPosition());
+
+}
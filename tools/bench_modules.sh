@@ -0,0 +1,34 @@
+#!/bin/sh
+# Runs bench_modules.mac once per tiling and tabulates initialization
+# time, peak memory, navigation and event throughput against the number
+# of modules.
+#
+#   tools/bench_modules.sh <matrix binary> <tiling> [tiling ...]
+#
+# EVENTS (default 2000) sets the events per job.
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 <matrix binary> <tiling> [tiling ...]   (tiling: N or NXxNY)" >&2
+	exit 1
+fi
+
+matrix=$1
+shift
+events=${EVENTS:-2000}
+macro=$(dirname "$0")/../bench_modules.mac
+
+printf "%-8s %8s %9s %9s %10s %12s %10s\n" tiling modules channels "init [s]" "RSS [MB]" "steps/s" "events/s"
+for tiling in "$@"; do
+	log=$(mktemp)
+	"$matrix" --modules "$tiling" -n "$events" -o bench_modules -s 1 "$macro" > "$log" 2>&1
+	awk -v tiling="$tiling" '
+		/ modules, .* crystals, .* readout channels/ { split($1, m, "x"); modules = m[1]*m[2]; channels = $5 }
+		/^Initialization done after/ { init = $4 }
+		/^Memory: peak RSS/ { rss = $4 }
+		/ steps\/s\)/ { steps = $(NF-1); sub(/^\(/, "", steps) }
+		/ events\/s,/ { for(i = 1; i <= NF; i++) if($i == "events/s,") { rate = $(i-1); sub(/^\(/, "", rate) } }
+		END { printf "%-8s %8s %9s %9s %10s %12s %10s\n", tiling, modules, channels, init, rss, steps, rate }
+	' "$log"
+	rm -f "$log"
+done
+rm -f bench_modules.root
@@ -0,0 +1,365 @@
+/**
+ * matrix_analysis: parallel, streaming analysis of the matrix ntuple
+ * ("nTuple": event, axis, channel, primary, weight, module; one row per
+ * detected photon). Rows count with their weight, 1 unless biasing was on.
+ *
+ *   matrix_analysis [-t threads] [-M module] [-o output.root] matrix.root [matrix_t1.root ...]
+ *
+ * Channels are those of one module: the rows of all modules add up unless
+ * -M selects one, and then only events with a row in that module count.
+ * Buffers grow to the largest channel found; rows with an axis other than
+ * 1 or 2 or a negative channel are skipped and reported.
+ *
+ * The rows of all files are cut into ranges that worker threads take from
+ * a shared counter. Each thread reads its ranges through its own TFile and
+ * TTree cache, so memory depends on the number of threads and channels,
+ * not on the size of the files. A range starts at the first event that
+ * begins in it and runs to the end of its last event; the rows of an event
+ * are contiguous within a file. Thread results are merged at the end into:
+ *
+ *   Histogram_X/Y     photons per channel
+ *   Profile_X/Y       mean photons per channel and event, with errors
+ *   LightYield        detected photons per event
+ *   CrystalMap        brightest X channel against brightest Y channel
+ */
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1D.h"
+#include "TH2D.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	//Rows per range taken by a thread
+	const long long kRangeRows = 1LL << 20;
+
+	struct Range
+	{
+		int file;
+		long long begin;
+		long long end;
+	};
+
+	//Adds b into a, growing a to the size of b
+	void Accumulate(std::vector<double>& a, const std::vector<double>& b)
+	{
+		if(a.size() < b.size()) a.resize(b.size(), 0);
+		for(std::size_t i = 0; i < b.size(); i++) a[i] += b[i];
+	}
+
+	struct Result
+	{
+		Result() : events(0), rows(0), dropped(0) {}
+
+		long long events;
+		long long rows;
+		long long dropped;
+		//Per axis, index channel
+		std::vector<double> sum[2];
+		std::vector<double> sum2[2];
+		std::vector<double> yield;
+		//Brightest X and Y channel
+		std::map<std::pair<int, int>, double> crystals;
+
+		int Channels() const
+		{
+			return (int)std::max(sum[0].size(), sum[1].size());
+		}
+
+		void Merge(const Result& other)
+		{
+			events += other.events;
+			rows += other.rows;
+			dropped += other.dropped;
+			for(int a = 0; a < 2; a++){
+				Accumulate(sum[a], other.sum[a]);
+				Accumulate(sum2[a], other.sum2[a]);
+			}
+			Accumulate(yield, other.yield);
+			for(std::map<std::pair<int, int>, double>::const_iterator it = other.crystals.begin(); it != other.crystals.end(); ++it)
+				crystals[it->first] += it->second;
+		}
+	};
+
+	//Counts of the event being read
+	struct Event
+	{
+		Event() : id(-1), inModule(false), total(0), photons(0) {}
+
+		int id;
+		bool inModule;		//has a row in the selected module
+		std::vector<double> counts[2];
+		double total;
+		int photons;
+
+		void Add(int axis, int channel, double weight, Result& result)
+		{
+			inModule = true;
+			if(axis < 1 || axis > 2 || channel < 0){
+				result.dropped++;
+				return;
+			}
+			std::vector<double>& axisCounts = counts[axis - 1];
+			if((int)axisCounts.size() <= channel) axisCounts.resize(channel + 1, 0);
+			axisCounts[channel] += weight;
+			total += weight;
+			photons++;
+		}
+
+		void Close(Result& result)
+		{
+			if(id < 0) return;
+			if(!inModule){
+				id = -1;
+				return;
+			}
+			result.events++;
+
+			//Spectrum of the photon count, events weighted by their mean photon weight
+			double weight = photons ? total/photons : 0.;
+			if((int)result.yield.size() <= photons) result.yield.resize(photons + 1, 0);
+			result.yield[photons] += weight;
+
+			//Brightest channel of each axis, first one on ties
+			int best[2] = {-1, -1};
+			for(int a = 0; a < 2; a++)
+				for(int i = 0; i < (int)counts[a].size(); i++)
+					if(counts[a][i] > 0 && (best[a] < 0 || counts[a][i] > counts[a][best[a]])) best[a] = i;
+			if(best[0] >= 0 && best[1] >= 0)
+				result.crystals[std::make_pair(best[0], best[1])] += weight;
+
+			//Sums for the per-event profile; the channels without photons
+			//add zeros, which are taken into account when it is built
+			for(int a = 0; a < 2; a++){
+				std::vector<double>& axisCounts = counts[a];
+				if(result.sum[a].size() < axisCounts.size()){
+					result.sum[a].resize(axisCounts.size(), 0);
+					result.sum2[a].resize(axisCounts.size(), 0);
+				}
+				for(std::size_t i = 0; i < axisCounts.size(); i++){
+					if(axisCounts[i] == 0) continue;
+					result.sum[a][i] += axisCounts[i];
+					result.sum2[a][i] += axisCounts[i]*axisCounts[i];
+					axisCounts[i] = 0;
+				}
+			}
+			total = 0;
+			photons = 0;
+			inModule = false;
+			id = -1;
+		}
+	};
+
+	class Worker
+	{
+	public:
+		Worker(const std::vector<std::string>& names, int only) : files(names), selected(only), current(-1), file(0), tree(0) {}
+		~Worker() { delete file; }
+
+		bool Process(const Range& range, Result& result)
+		{
+			if(!Open(range.file)) return false;
+
+			long long entries = tree->GetEntries();
+			long long i = range.begin;
+
+			//The event running into the range belongs to the previous one
+			if(i > 0){
+				tree->GetEntry(i - 1);
+				int previous = event;
+				while(i < entries){
+					tree->GetEntry(i);
+					if(event != previous) break;
+					i++;
+				}
+			}
+
+			Event counts;
+			for(; i < entries; i++){
+				tree->GetEntry(i);
+				if(event != counts.id){
+					if(i >= range.end) break;
+					counts.Close(result);
+					counts.id = event;
+				}
+				if(selected < 0 || module == selected) counts.Add(axis, channel, weight, result);
+				result.rows++;
+			}
+			counts.Close(result);
+			return true;
+		}
+
+	private:
+		bool Open(int index)
+		{
+			if(index == current) return true;
+			delete file;
+			file = TFile::Open(files[index].c_str(), "READ");
+			tree = file ? (TTree*)file->Get("nTuple") : 0;
+			current = index;
+			if(!tree){
+				std::fprintf(stderr, "No nTuple in %s\n", files[index].c_str());
+				return false;
+			}
+			tree->SetCacheSize(32*1024*1024);
+			tree->SetBranchStatus("*", 0);
+			tree->SetBranchStatus("event", 1);
+			tree->SetBranchStatus("axis", 1);
+			tree->SetBranchStatus("channel", 1);
+			tree->SetBranchAddress("event", &event);
+			tree->SetBranchAddress("axis", &axis);
+			tree->SetBranchAddress("channel", &channel);
+
+			//Outputs written before the module column have a single module
+			module = 0;
+			if(tree->GetBranch("module")){
+				tree->SetBranchStatus("module", 1);
+				tree->SetBranchAddress("module", &module);
+			}
+
+			//Outputs written before the weight column count every row once
+			weight = 1.;
+			if(tree->GetBranch("weight")){
+				tree->SetBranchStatus("weight", 1);
+				tree->SetBranchAddress("weight", &weight);
+			}
+			return true;
+		}
+
+		const std::vector<std::string>& files;
+		int selected;
+		int current;
+		TFile* file;
+		TTree* tree;
+		int event;
+		int axis;
+		int channel;
+		int module;
+		double weight;
+	};
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr, "Usage: matrix_analysis [-t threads] [-M module] [-o output.root] file.root [file.root ...]\n");
+	}
+
+}
+
+int main(int argc, char** argv)
+{
+
+	int nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::string output = "matrix_analysis.root";
+	int selected = -1;
+	std::vector<std::string> files;
+
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "-t" && i + 1 < argc) nThreads = std::max(1, std::atoi(argv[++i]));
+		else if(arg == "-o" && i + 1 < argc) output = argv[++i];
+		else if(arg == "-M" && i + 1 < argc) selected = std::atoi(argv[++i]);
+		else if(arg[0] != '-') files.push_back(arg);
+		else{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if(files.empty()){
+		PrintUsage();
+		return 1;
+	}
+
+	ROOT::EnableThreadSafety();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//Ranges of every file
+	std::vector<Range> ranges;
+	for(int f = 0; f < (int)files.size(); f++){
+		TFile* file = TFile::Open(files[f].c_str(), "READ");
+		TTree* tree = file ? (TTree*)file->Get("nTuple") : 0;
+		if(!tree){
+			std::fprintf(stderr, "No nTuple in %s\n", files[f].c_str());
+			delete file;
+			return 1;
+		}
+		long long entries = tree->GetEntries();
+		for(long long begin = 0; begin < entries; begin += kRangeRows){
+			Range range = {f, begin, std::min(entries, begin + kRangeRows)};
+			ranges.push_back(range);
+		}
+		delete file;
+	}
+
+	std::vector<Result> results(nThreads);
+	std::atomic<std::size_t> next(0);
+	std::atomic<bool> failed(false);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < nThreads; t++){
+		threads.push_back(std::thread([&, t]() {
+			Worker worker(files, selected);
+			for(std::size_t r = next++; r < ranges.size() && !failed; r = next++)
+				if(!worker.Process(ranges[r], results[t])) failed = true;
+		}));
+	}
+	for(std::size_t t = 0; t < threads.size(); t++) threads[t].join();
+	if(failed) return 1;
+
+	Result total;
+	for(int t = 0; t < nThreads; t++) total.Merge(results[t]);
+
+	TFile out(output.c_str(), "RECREATE");
+	//Channels count from 0, like the Histogram_X/Y of the simulation
+	int n = std::max(total.Channels(), 1);
+	for(int a = 0; a < 2; a++){
+		total.sum[a].resize(n, 0);
+		total.sum2[a].resize(n, 0);
+	}
+	TH1D histX("Histogram_X", "Photons per channel X", n, -0.5, n - 0.5);
+	TH1D histY("Histogram_Y", "Photons per channel Y", n, -0.5, n - 0.5);
+	TH1D profileX("Profile_X", "Mean photons per event, channel X", n, -0.5, n - 0.5);
+	TH1D profileY("Profile_Y", "Mean photons per event, channel Y", n, -0.5, n - 0.5);
+	TH1D* hists[2] = {&histX, &histY};
+	TH1D* profiles[2] = {&profileX, &profileY};
+	for(int a = 0; a < 2; a++){
+		for(int c = 0; c < n; c++){
+			hists[a]->SetBinContent(c + 1, total.sum[a][c]);
+			if(total.events == 0) continue;
+			double mean = total.sum[a][c]/total.events;
+			double variance = total.sum2[a][c]/total.events - mean*mean;
+			profiles[a]->SetBinContent(c + 1, mean);
+			profiles[a]->SetBinError(c + 1, total.events > 1 ? std::sqrt(std::max(variance, 0.)/(total.events - 1)) : 0.);
+		}
+	}
+
+	int maxYield = std::max((int)total.yield.size(), 1);
+	TH1D yield("LightYield", "Detected photons per event", maxYield, -0.5, maxYield - 0.5);
+	for(std::size_t i = 0; i < total.yield.size(); i++) yield.SetBinContent(i + 1, total.yield[i]);
+
+	TH2D crystals("CrystalMap", "Brightest channels X:Y", n, -0.5, n - 0.5, n, -0.5, n - 0.5);
+	for(std::map<std::pair<int, int>, double>::const_iterator it = total.crystals.begin(); it != total.crystals.end(); ++it)
+		crystals.SetBinContent(it->first.first + 1, it->first.second + 1, it->second);
+
+	out.Write();
+	out.Close();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if(total.dropped > 0)
+		std::fprintf(stderr, "%lld rows with an axis other than 1 or 2 or a negative channel skipped\n", total.dropped);
+	std::printf("%lld rows, %lld events with photons from %zu files in %.2f s (%.3g rows/s, %d threads)\n",
+		    total.rows, total.events, files.size(), seconds, seconds > 0 ? total.rows/seconds : 0., nThreads);
+	std::printf("Results written to %s\n", output.c_str());
+	return 0;
+
+}
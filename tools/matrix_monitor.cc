@@ -0,0 +1,122 @@
+/**
+ * matrix_monitor: read-only viewer of the shared-memory segment
+ * published by a running matrix job (/matrix/monitor/segment).
+ *
+ *   matrix_monitor [-i seconds] [-1] /matrix
+ */
+
+#include "LiveMonitorSegment.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace {
+
+	int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void PrintHistogram(const char* title, const std::atomic<uint64_t>* bins, uint32_t n)
+	{
+		uint64_t largest = 0;
+		for(uint32_t i = 0; i < n; i++) largest = std::max<uint64_t>(largest, bins[i].load(std::memory_order_relaxed));
+		std::printf("%s\n", title);
+		for(uint32_t i = 0; i < n; i++){
+			uint64_t value = bins[i].load(std::memory_order_relaxed);
+			int width = largest ? (int)(50.*value/largest) : 0;
+			std::printf("  %2u %12llu |%.*s\n", i, (unsigned long long)value, width,
+				    "##################################################");
+		}
+	}
+
+}
+
+int main(int argc, char** argv)
+{
+
+	double interval = 2.;
+	bool once = false;
+	std::string name = "";
+
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "-i" && i + 1 < argc) interval = std::atof(argv[++i]);
+		else if(arg == "-1") once = true;
+		else if(arg[0] != '-' || arg.size() == 1) name = arg;
+		else{
+			std::fprintf(stderr, "Usage: matrix_monitor [-i seconds] [-1] <segment>\n");
+			return 1;
+		}
+	}
+	if(name == ""){
+		std::fprintf(stderr, "Usage: matrix_monitor [-i seconds] [-1] <segment>\n");
+		return 1;
+	}
+	if(name[0] != '/') name = "/" + name;
+
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if(fd < 0){
+		std::fprintf(stderr, "No segment %s, is the job running with /matrix/monitor/segment?\n", name.c_str());
+		return 1;
+	}
+	void* address = mmap(0, sizeof(LiveMonitorSegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED){
+		std::perror("mmap");
+		return 1;
+	}
+	const LiveMonitorSegment* shm = static_cast<const LiveMonitorSegment*>(address);
+	if(std::strncmp(shm->magic, "MTXMON1", sizeof(shm->magic)) != 0 || shm->version != 1){
+		std::fprintf(stderr, "%s is not a matrix monitor segment\n", name.c_str());
+		return 1;
+	}
+
+	uint64_t lastEvents = 0;
+	int64_t lastTime = 0;
+	const char* states[] = {"idle", "running", "done"};
+
+	for(;;){
+		int64_t update = shm->updateTime.load(std::memory_order_acquire);
+		int32_t state = shm->state.load(std::memory_order_relaxed);
+		uint64_t events = shm->events.load(std::memory_order_relaxed);
+		uint64_t requested = shm->eventsRequested.load(std::memory_order_relaxed);
+		uint64_t tracked = shm->photonsTracked.load(std::memory_order_relaxed);
+		uint64_t detected = shm->photonsDetected.load(std::memory_order_relaxed);
+		double elapsed = 1e-9*(update - shm->startTime.load(std::memory_order_relaxed));
+		double rate = elapsed > 0 ? events/elapsed : 0.;
+		double recent = (lastTime && update > lastTime) ? (events - lastEvents)/(1e-9*(update - lastTime)) : rate;
+		lastEvents = events;
+		lastTime = update;
+
+		if(!once) std::printf("\033[H\033[2J");
+		std::printf("matrix pid %d, run %d %s, last update %.1f s ago\n", shm->pid,
+			    shm->runID.load(std::memory_order_relaxed), states[state >= 0 && state <= 2 ? state : 0],
+			    1e-9*(Now() - update));
+		std::printf("events       %llu / %llu (%.1f%%)\n", (unsigned long long)events,
+			    (unsigned long long)requested, requested ? 100.*events/requested : 0.);
+		std::printf("events/s     %.2f (average %.2f)\n", recent, rate);
+		std::printf("tracked/evt  %.1f optical photons\n", events ? (double)tracked/events : 0.);
+		std::printf("detected/evt %.2f\n", events ? (double)detected/events : 0.);
+		std::printf("resident     %.1f MB\n", shm->residentBytes.load(std::memory_order_relaxed)/1048576.);
+		PrintHistogram("Histogram_X", shm->channelX, std::min<uint32_t>(shm->nChannelsX, LiveMonitorSegment::kMaxChannels));
+		PrintHistogram("Histogram_Y", shm->channelY, std::min<uint32_t>(shm->nChannelsY, LiveMonitorSegment::kMaxChannels));
+		std::fflush(stdout);
+
+		if(once) break;
+		usleep((useconds_t)(interval*1e6));
+	}
+
+	munmap(address, sizeof(LiveMonitorSegment));
+	return 0;
+
+}
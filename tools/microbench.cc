@@ -0,0 +1,345 @@
+/**
+ * microbench: timing of the per-step and per-event hot paths in isolation.
+ *
+ *   microbench [-n calls] [-r repetitions] [name ...]
+ *
+ * The real geometry and physics are initialized once; synthetic G4Steps
+ * then sit on touchables of every readout channel (RO_X and RO_Y), built
+ * by locating their centres. Each benchmark runs a warm-up and then
+ * repetitions of n calls, and prints ns per call (median, mean, standard
+ * deviation and minimum over the repetitions) and heap allocations per
+ * call, counted by replacing the global operator new. Names select
+ * benchmarks by substring:
+ *
+ *   filter/accept       particle filter on an optical photon step
+ *   filter/reject       particle filter on a gamma step
+ *   ProcessHits         G4VSensitiveDetector::Hit, filter and hit creation
+ *   Hits/new+delete     hit allocation from the event arena, per event
+ *   Hits/G4Allocator    the same from a G4Allocator pool, as before the arena
+ *   FillOutput/hit      ntuple, histogram fill of an event, per hit
+ */
+
+#include "DetectorConstruction.hh"
+#include "DetectorParameters.hh"
+#include "PhysicsList.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "TrackingAction.hh"
+#include "SensitiveDetector.hh"
+#include "Hits.hh"
+#include "EventArena.hh"
+
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4VSDFilter.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4Event.hh"
+#include "G4Run.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Gamma.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4TouchableHistory.hh"
+#include "G4UImanager.hh"
+#include "G4Allocator.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+	//Heap allocations of the whole program
+	long long allocations = 0;
+
+}
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	allocations++;
+	void* p = std::malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept		{std::free(p);}
+void operator delete[](void* p) noexcept	{std::free(p);}
+void operator delete(void* p, std::size_t) noexcept	{std::free(p);}
+void operator delete[](void* p, std::size_t) noexcept	{std::free(p);}
+
+namespace {
+
+	//Photons of a typical event for the output path
+	const int kHitsPerEvent = 64;
+
+	struct Benchmark
+	{
+		std::string name;
+		long calls;				//default calls per repetition
+		std::function<void()> setup;		//before every repetition, untimed
+		std::function<void(long)> run;
+		std::function<void()> teardown;		//after every repetition, untimed
+	};
+
+	struct Result
+	{
+		double median;
+		double mean;
+		double sigma;
+		double min;
+		double allocations;
+	};
+
+	Result Measure(Benchmark& bench, long calls, int repetitions)
+	{
+
+		std::vector<double> ns;
+		long long allocated = 0;
+		for(int r = -1; r < repetitions; r++){
+			if(bench.setup) bench.setup();
+			long long before = allocations;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			bench.run(calls);
+			std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+			long long after = allocations;
+			if(bench.teardown) bench.teardown();
+			//The first round warms caches and pools
+			if(r < 0) continue;
+			ns.push_back(std::chrono::duration<double, std::nano>(stop - start).count()/calls);
+			allocated += after - before;
+		}
+
+		Result result;
+		std::sort(ns.begin(), ns.end());
+		std::size_t n = ns.size();
+		result.median = n%2 ? ns[n/2] : 0.5*(ns[n/2 - 1] + ns[n/2]);
+		result.min = ns[0];
+		double sum = 0, sum2 = 0;
+		for(std::size_t i = 0; i < n; i++){ sum += ns[i]; sum2 += ns[i]*ns[i]; }
+		result.mean = sum/n;
+		result.sigma = n > 1 ? std::sqrt(std::max(0., (sum2 - sum*sum/n)/(n - 1))) : 0;
+		result.allocations = (double)allocated/((double)calls*repetitions);
+		return result;
+
+	}
+
+	//Step of a particle at rest on the touchable, as the SD sees it
+	G4Step* MakeStep(G4ParticleDefinition* particle, const G4TouchableHandle& touchable)
+	{
+
+		G4ThreeVector position = touchable->GetTranslation();
+		G4Track* track = new G4Track(new G4DynamicParticle(particle, G4ThreeVector(0., 0., 1.), 2.5*eV), 0., position);
+		track->SetTouchableHandle(touchable);
+		track->SetNextTouchableHandle(touchable);
+		G4Step* step = new G4Step();
+		step->InitializeStep(track);
+		track->SetStep(step);
+		step->GetPostStepPoint()->SetPosition(position);
+		return step;
+
+	}
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr, "Usage: microbench [-n calls] [-r repetitions] [name ...]\n");
+	}
+
+}
+
+int main(int argc, char** argv)
+{
+
+	long calls = 0;
+	int repetitions = 20;
+	std::vector<std::string> selected;
+
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "-n" && i + 1 < argc) calls = std::max(1L, std::atol(argv[++i]));
+		else if(arg == "-r" && i + 1 < argc) repetitions = std::max(1, std::atoi(argv[++i]));
+		else if(arg[0] != '-') selected.push_back(arg);
+		else{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	//Real geometry, physics and sensitive detector, without running
+	G4RunManager* runManager = new G4RunManager();
+	runManager->SetUserInitialization(new PhysicsList());
+	runManager->SetUserInitialization(new DetectorConstruction());
+	TrackingAction* trackingAction = new TrackingAction();
+	runManager->SetUserAction(trackingAction);
+	G4UImanager::GetUIpointer()->ApplyCommand("/control/verbose 0");
+	G4UImanager::GetUIpointer()->ApplyCommand("/run/verbose 0");
+	runManager->Initialize();
+	//Cuts and physics tables as at the start of a run
+	runManager->BeamOn(0);
+
+	SensitiveDetector* sd = static_cast<SensitiveDetector*>(
+		G4SDManager::GetSDMpointer()->FindSensitiveDetector("LYSO/SensitiveDetector"));
+	if(!sd || !sd->GetFilter()){
+		std::fprintf(stderr, "No LYSO/SensitiveDetector with a filter in the geometry\n");
+		return 1;
+	}
+	G4VSDFilter* filter = sd->GetFilter();
+
+	//One touchable per readout channel, at its centre
+	G4Navigator navigator;
+	navigator.SetWorldVolume(G4TransportationManager::GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+	std::vector<G4Step*> photonSteps, gammaSteps;
+	const G4double z = DetectorParameters::Dz - DetectorParameters::Pz;
+	for(G4int axis = 0; axis < 2; axis++){
+		G4int n = axis ? DetectorParameters::ny : DetectorParameters::nx;
+		for(G4int c = 0; c < n; c++){
+			G4double along = -DetectorParameters::ROw + (2*c + 1)*DetectorParameters::RODiv;
+			G4double across = DetectorParameters::Px + DetectorParameters::ROh;
+			G4ThreeVector centre = axis ? G4ThreeVector(across, along, z) : G4ThreeVector(along, across, z);
+			navigator.LocateGlobalPointAndSetup(centre, 0, false, true);
+			G4TouchableHandle touchable(navigator.CreateTouchableHistory());
+			if(touchable->GetVolume()->GetName() != (axis ? "RO_Y" : "RO_X") || touchable->GetReplicaNumber() != c){
+				std::fprintf(stderr, "Channel %d of %s not found at its centre\n", c, axis ? "RO_Y" : "RO_X");
+				return 1;
+			}
+			photonSteps.push_back(MakeStep(G4OpticalPhoton::OpticalPhoton(), touchable));
+			gammaSteps.push_back(MakeStep(G4Gamma::Gamma(), touchable));
+		}
+	}
+	const std::size_t nSteps = photonSteps.size();
+
+	//Output booked and opened as in a run
+	RunAction* runAction = new RunAction();
+	runAction->SetFileName("microbench");
+	EventAction* eventAction = new EventAction(runAction);
+	G4Run* run = runAction->GenerateRun();
+	runAction->BeginOfRunAction(run);
+	G4Event event(0);
+
+	G4HCofThisEvent* hce = 0;
+	std::vector<Hits*> ring(kHitsPerEvent, (Hits*)0);
+	HitsCollection* eventHits = 0;
+	//Rewinds once the hits of a repetition are gone, as at the next event
+	EventArena* arena = EventArena::Instance();
+	G4Allocator<Hits> pool;
+
+	std::vector<Benchmark> benchmarks;
+	long sink = 0;
+
+	Benchmark accept = {"filter/accept", 10000000};
+	accept.run = [&](long n){
+		for(long i = 0; i < n; i++) sink += filter->Accept(photonSteps[i%nSteps]);
+	};
+	benchmarks.push_back(accept);
+
+	Benchmark reject = {"filter/reject", 10000000};
+	reject.run = [&](long n){
+		for(long i = 0; i < n; i++) sink += filter->Accept(gammaSteps[i%nSteps]);
+	};
+	benchmarks.push_back(reject);
+
+	//Hits pile up in a fresh collection per repetition, as in an event
+	Benchmark processHits = {"ProcessHits", 200000};
+	processHits.setup = [&](){
+		hce = new G4HCofThisEvent(G4SDManager::GetSDMpointer()->GetCollectionCapacity());
+		sd->Initialize(hce);
+	};
+	processHits.run = [&](long n){
+		for(long i = 0; i < n; i++) sink += sd->Hit(photonSteps[i%nSteps]);
+	};
+	//The collection goes with the event's G4HCofThisEvent, there is no event here
+	processHits.teardown = [&](){
+		delete hce;
+		hce = 0;
+		arena->Reset();
+	};
+	benchmarks.push_back(processHits);
+
+	//Calls are hits, created and deleted one event at a time
+	Benchmark allocation = {"Hits/new+delete", 10000000};
+	allocation.run = [&](long n){
+		for(long i = 0; i < n; i += kHitsPerEvent){
+			for(int k = 0; k < kHitsPerEvent; k++) ring[k] = new Hits(2.5*eV, G4ThreeVector());
+			for(int k = 0; k < kHitsPerEvent; k++) delete ring[k];
+			arena->Reset();
+		}
+	};
+	benchmarks.push_back(allocation);
+
+	Benchmark pooled = {"Hits/G4Allocator", 10000000};
+	pooled.run = [&](long n){
+		for(long i = 0; i < n; i += kHitsPerEvent){
+			for(int k = 0; k < kHitsPerEvent; k++) ring[k] = ::new(pool.MallocSingle()) Hits(2.5*eV, G4ThreeVector());
+			for(int k = 0; k < kHitsPerEvent; k++){
+				ring[k]->~Hits();
+				pool.FreeSingle(ring[k]);
+			}
+		}
+	};
+	benchmarks.push_back(pooled);
+
+	//Calls are hits, filled one event at a time
+	Benchmark fill = {"FillOutput/hit", 4096*kHitsPerEvent};
+	fill.setup = [&](){
+		eventHits = new HitsCollection("LYSO/SensitiveDetector", "LYSOHitsCollection");
+		for(int i = 0; i < kHitsPerEvent; i++){
+			Hits* hit = new Hits(2.5*eV, G4ThreeVector());
+			hit->setAxis(1 + i%2);
+			hit->setChannel(i%DetectorParameters::nx);
+			eventHits->insert(hit);
+		}
+	};
+	fill.run = [&](long n){
+		for(long i = 0; i < n; i += kHitsPerEvent) eventAction->FillOutput(&event, eventHits, 0);
+	};
+	fill.teardown = [&](){
+		delete eventHits;
+		eventHits = 0;
+		arena->Reset();
+	};
+	benchmarks.push_back(fill);
+
+	std::printf("%-18s %10s %10s %10s %10s %10s %12s\n", "benchmark", "calls", "median", "mean", "sigma", "min", "allocs/call");
+	for(std::size_t b = 0; b < benchmarks.size(); b++){
+		Benchmark& bench = benchmarks[b];
+		if(!selected.empty()){
+			G4bool match = false;
+			for(std::size_t s = 0; s < selected.size(); s++)
+				if(bench.name.find(selected[s]) != std::string::npos) match = true;
+			if(!match) continue;
+		}
+		long n = calls ? calls : bench.calls;
+		if(bench.name == "FillOutput/hit" || bench.name.compare(0, 5, "Hits/") == 0)
+			n = std::max(1L, n/kHitsPerEvent)*kHitsPerEvent;
+		Result result = Measure(bench, n, repetitions);
+		std::printf("%-18s %10ld %8.2f ns %8.2f ns %8.2f ns %8.2f ns %12.3f\n", bench.name.c_str(), n,
+			    result.median, result.mean, result.sigma, result.min, result.allocations);
+	}
+
+	runAction->EndOfRunAction(run);
+	std::remove("microbench.root");
+	delete run;
+	delete eventAction;
+	delete runAction;
+	delete runManager;
+
+	return sink < 0;
+
+}
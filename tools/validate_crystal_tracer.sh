@@ -0,0 +1,170 @@
+#!/bin/sh
+# Checks the batched crystal photon tracer against full optical tracking.
+#
+# Runs the same events with the same seed twice, with full tracking in the
+# crystals and with the tracer, then compares
+#  - the light yield (weighted photons per event),
+#  - the crystal identification efficiency of the convergence monitor,
+#  - Histogram_X/Y as mean photons per event and channel, through the
+#    chi2 of all channels against its number of degrees of freedom,
+# each with the event-to-event spread as error. Prints the run time,
+# events/s of both runs and the photons/s of the tracer.
+#
+#   tools/validate_crystal_tracer.sh <matrix binary>
+#
+# EVENTS (default 2000) sets the runs, SIGMA (default 3) the tolerance.
+# Needs root in the PATH. Exits 1 if any figure differs by more than
+# SIGMA standard deviations.
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 <matrix binary>" >&2
+	exit 1
+fi
+
+matrix=$1
+events=${EVENTS:-2000}
+sigma=${SIGMA:-3}
+work=$(mktemp -d)
+
+for mode in full tracer; do
+	enable=false
+	[ $mode = tracer ] && enable=true
+	cat > "$work/$mode.mac" <<EOF
+/control/verbose 0
+/run/verbose 0
+/run/printProgress 0
+/matrix/convergence/target 0.0001
+/matrix/convergence/observable lightYield
+/matrix/convergence/observable efficiency
+/matrix/crystalTracer/enable $enable
+EOF
+	"$matrix" -t 1 -s 12345 -n "$events" -o "$work/$mode" "$work/$mode.mac" > "$work/$mode.log" 2>&1 || {
+		echo "$mode run failed, see $work/$mode.log" >&2
+		exit 1
+	}
+done
+
+#Efficiency, run time and events/s of a log
+efficiency()
+{
+	awk '/crystal identification efficiency/ { print $4 }' "$1"
+}
+timing()
+{
+	awk '/ events, .* primaries in / { printf "%s s, %.4g events/s", $6, ($6 > 0 ? $1/$6 : 0) }' "$1"
+}
+
+printf "%-8s %s\n" full "$(timing "$work/full.log")"
+printf "%-8s %s, %s\n" tracer "$(timing "$work/tracer.log")" \
+	"$(awk '/^Crystal tracer:/ { sub(/.*\(/, ""); sub(/\).*/, ""); print }' "$work/tracer.log")"
+
+cat > "$work/compare.C" <<EOF
+#include <map>
+
+struct Summary
+{
+	double yield;
+	double yield2;
+	std::map<long, double> sum;
+	std::map<long, double> sum2;
+};
+
+//Per event sums of the nTuple, by axis, module and channel
+bool Read(const char* name, Summary& s)
+{
+	TFile file(name);
+	TTree* tree = (TTree*)file.Get("nTuple");
+	if(!tree){ printf("No nTuple in %s\n", name); return false; }
+	int event, axis, channel, module = 0;
+	double weight = 1.;
+	tree->SetBranchAddress("event", &event);
+	tree->SetBranchAddress("axis", &axis);
+	tree->SetBranchAddress("channel", &channel);
+	if(tree->GetBranch("module")) tree->SetBranchAddress("module", &module);
+	if(tree->GetBranch("weight")) tree->SetBranchAddress("weight", &weight);
+
+	std::map<int, std::map<long, double> > events;
+	for(Long64_t i = 0; i < tree->GetEntries(); i++){
+		tree->GetEntry(i);
+		events[event][axis*1000000L + module*1000L + channel] += weight;
+	}
+
+	s.yield = s.yield2 = 0;
+	for(std::map<int, std::map<long, double> >::iterator e = events.begin(); e != events.end(); ++e){
+		double total = 0;
+		for(std::map<long, double>::iterator c = e->second.begin(); c != e->second.end(); ++c){
+			total += c->second;
+			s.sum[c->first] += c->second;
+			s.sum2[c->first] += c->second*c->second;
+		}
+		s.yield += total;
+		s.yield2 += total*total;
+	}
+	return true;
+}
+
+//Mean per event and its error, events without photons count as zeros
+void Mean(double sum, double sum2, double n, double& mean, double& error)
+{
+	mean = sum/n;
+	error = n > 1 ? sqrt(std::max(sum2/n - mean*mean, 0.)/(n - 1)) : 0.;
+}
+
+double Pull(double a, double ea, double b, double eb)
+{
+	double e = sqrt(ea*ea + eb*eb);
+	return e > 0 ? (a - b)/e : (a == b ? 0. : 1e9);
+}
+
+void compare()
+{
+	const double n = $events, nSigma = $sigma;
+	Summary full, tracer;
+	if(!Read("$work/full.root", full) || !Read("$work/tracer.root", tracer)) gSystem->Exit(1);
+	int failed = 0;
+
+	double a, ea, b, eb;
+	Mean(full.yield, full.yield2, n, a, ea);
+	Mean(tracer.yield, tracer.yield2, n, b, eb);
+	double pull = Pull(a, ea, b, eb);
+	printf("light yield      full %.5g +- %.2g, tracer %.5g +- %.2g photons/event (%.2f sigma)\n", a, ea, b, eb, pull);
+	if(fabs(pull) > nSigma) failed++;
+
+	a = $(efficiency "$work/full.log" | grep . || echo 0);
+	b = $(efficiency "$work/tracer.log" | grep . || echo 0);
+	ea = sqrt(a*(1. - a)/n);
+	eb = sqrt(b*(1. - b)/n);
+	pull = Pull(a, ea, b, eb);
+	printf("efficiency       full %.4f +- %.4f, tracer %.4f +- %.4f (%.2f sigma)\n", a, ea, b, eb, pull);
+	if(fabs(pull) > nSigma) failed++;
+
+	//Histogram_X/Y as means per event, channels seen in either run
+	std::map<long, double> channels(full.sum);
+	channels.insert(tracer.sum.begin(), tracer.sum.end());
+	double chi2 = 0, worst = 0;
+	long worstKey = -1;
+	for(std::map<long, double>::iterator c = channels.begin(); c != channels.end(); ++c){
+		Mean(full.sum[c->first], full.sum2[c->first], n, a, ea);
+		Mean(tracer.sum[c->first], tracer.sum2[c->first], n, b, eb);
+		pull = Pull(a, ea, b, eb);
+		chi2 += pull*pull;
+		if(fabs(pull) > fabs(worst)){ worst = pull; worstKey = c->first; }
+	}
+	int ndf = channels.size();
+	double limit = ndf + nSigma*sqrt(2.*ndf);
+	printf("Histogram_X/Y    chi2 %.1f for %d channels (limit %.1f)", chi2, ndf, limit);
+	if(worstKey >= 0)
+		printf(", worst %s module %ld channel %ld at %.2f sigma", worstKey/1000000 == 1 ? "X" : "Y",
+		       (worstKey%1000000)/1000, worstKey%1000, worst);
+	printf("\n");
+	if(chi2 > limit) failed++;
+
+	printf(failed ? "Tracer and full tracking differ\n" : "Tracer agrees with full tracking\n");
+	gSystem->Exit(failed ? 1 : 0);
+}
+EOF
+root -l -b -q "$work/compare.C"
+status=$?
+
+rm -rf "$work"
+exit $status
@@ -0,0 +1,81 @@
+#!/bin/sh
+# Checks the sub-event scheduler against what it promises.
+#
+#  - Batched output does not depend on the number of threads: runs on two
+#    and on N worker threads with the same seed must fill Histogram_X/Y
+#    identically, bin by bin. Both are MT runs, a sequential run draws its
+#    events from one stream and is not comparable.
+#  - Batched and unbatched tracking agree statistically, not bit by bit
+#    (batches draw from their own streams): their light yields and
+#    relative errors are printed side by side.
+#
+#   tools/validate_subevents.sh <matrix binary> [threads]
+#
+# EVENTS (default 200) and BATCH (default 2000 photons) set the runs. Needs
+# an MT build and root in the PATH. Exits 1 if the histograms differ.
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 <matrix binary> [threads]" >&2
+	exit 1
+fi
+
+matrix=$1
+threads=${2:-8}
+events=${EVENTS:-200}
+batch=${BATCH:-2000}
+work=$(mktemp -d)
+
+cat > "$work/common.mac" <<EOF
+/control/verbose 0
+/run/verbose 0
+/run/printProgress 0
+/matrix/convergence/target 0.0001
+/matrix/convergence/observable lightYield
+EOF
+cat "$work/common.mac" - > "$work/batched.mac" <<EOF
+/matrix/subEvent/batchSize $batch
+EOF
+cat "$work/common.mac" - > "$work/unbatched.mac" <<EOF
+/matrix/subEvent/batchSize 0
+EOF
+
+run()
+{
+	"$matrix" -t "$1" -s 4242 -n "$events" -o "$work/$2" "$work/$3.mac" > "$work/$2.log" 2>&1 || {
+		echo "$2 failed, see $work/$2.log" >&2
+		exit 1
+	}
+}
+
+run 2 batched_t2 batched
+run "$threads" batched_tN batched
+run "$threads" unbatched_tN unbatched
+
+printf "%-22s %s\n" run "light yield"
+for name in unbatched_tN batched_t2 batched_tN; do
+	printf "%-22s %s\n" "$name" "$(awk '/light yield/ { print $3 } /worst relative error/ { err = $7 } END { print "(rel. error " err ")" }' "$work/$name.log" | paste -sd' ')"
+done
+
+cat > "$work/compare.C" <<EOF
+void compare()
+{
+	TFile a("$work/batched_t2.root"), b("$work/batched_tN.root");
+	const char* names[] = {"Histogram_X", "Histogram_Y"};
+	int differing = 0;
+	for(int h = 0; h < 2; h++){
+		TH1* ha = (TH1*)a.Get(names[h]);
+		TH1* hb = (TH1*)b.Get(names[h]);
+		if(!ha || !hb || ha->GetNbinsX() != hb->GetNbinsX()){ printf("%s missing or rebinned\n", names[h]); differing++; continue; }
+		for(int i = 0; i <= ha->GetNbinsX() + 1; i++)
+			if(ha->GetBinContent(i) != hb->GetBinContent(i)) differing++;
+	}
+	if(differing) printf("2 and $threads threads: %d bins differ\n", differing);
+	else printf("2 and $threads threads: identical histograms\n");
+	gSystem->Exit(differing ? 1 : 0);
+}
+EOF
+root -l -b -q "$work/compare.C"
+status=$?
+
+rm -rf "$work"
+exit $status